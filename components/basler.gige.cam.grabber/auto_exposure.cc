@@ -0,0 +1,209 @@
+
+#include "auto_exposure.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
+double luminance_stats::percentile(double p) const {
+    if(count==0)
+        return 0.0;
+
+    /* pixels below the upper bound of bin k : count - ge[k] (bin width 16, last bin [240, 256)) */
+    double rank = p*(double)count;
+    double below_lower = 0.0;
+    for(int k=0;k<n_bins;k++){
+        double below_upper = (k<n_bins-1) ? (double)(count-ge[k]) : (double)count;
+        if(below_upper>=rank){
+            double in_bin = below_upper - below_lower;
+            double frac = in_bin>0.0 ? (rank-below_lower)/in_bin : 0.0;
+            return 16.0*((double)k + frac);
+        }
+        below_lower = below_upper;
+    }
+    return 255.0;
+}
+
+void compute_luminance_stats(const uint8_t* image, int width, int height, size_t stride, const camera_roi& roi,
+                            int row_step, int block_step, uint8_t saturation_level, luminance_stats& stats){
+
+    stats = luminance_stats();
+
+    /* region (whole image if roi is empty) */
+    int x0 = 0, y0 = 0, x1 = width, y1 = height;
+    if(roi.width>0 && roi.height>0){
+        x0 = clamp(roi.x, 0, width);
+        y0 = clamp(roi.y, 0, height);
+        x1 = clamp(roi.x+roi.width, 0, width);
+        y1 = clamp(roi.y+roi.height, 0, height);
+    }
+    row_step = max(row_step, 1);
+    const int block = 16;
+    const int block_advance = block*max(block_step, 1);
+
+    uint8_t thresholds[luminance_stats::n_bins];
+    for(int k=0;k<luminance_stats::n_bins-1;k++)
+        thresholds[k] = (uint8_t)(16*(k+1));
+    thresholds[luminance_stats::n_bins-1] = saturation_level;
+
+    /* scalar path for tails (and for targets without SIMD) */
+    auto scalar = [&](const uint8_t* p, int n){
+        for(int i=0;i<n;i++){
+            uint8_t v = p[i];
+            stats.sum += v;
+            for(int k=0;k<luminance_stats::n_bins;k++)
+                stats.ge[k] += (v>=thresholds[k]);
+        }
+        stats.count += (uint64_t)n;
+    };
+
+#if defined(__SSE2__)
+    /* per-lane byte counters (flushed before overflow) */
+    __m128i t[luminance_stats::n_bins];
+    __m128i acc[luminance_stats::n_bins];
+    for(int k=0;k<luminance_stats::n_bins;k++){
+        t[k] = _mm_set1_epi8((char)thresholds[k]);
+        acc[k] = _mm_setzero_si128();
+    }
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = _mm_setzero_si128();
+    int pending = 0;
+
+    auto flush = [&](){
+        for(int k=0;k<luminance_stats::n_bins;k++){
+            __m128i s = _mm_sad_epu8(acc[k], zero);
+            stats.ge[k] += (uint64_t)_mm_cvtsi128_si32(s) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(s, 8));
+            acc[k] = _mm_setzero_si128();
+        }
+        pending = 0;
+    };
+
+    for(int y=y0;y<y1;y+=row_step){
+        const uint8_t* row = image + (size_t)y*stride;
+        int x = x0;
+        for(;x+block<=x1;x+=block_advance){
+            __m128i v = _mm_loadu_si128((const __m128i*)(row+x));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+            for(int k=0;k<luminance_stats::n_bins;k++){
+                /* v>=t : max(v,t)==v -> 0xFF, subtracting -1 increments the lane counter */
+                acc[k] = _mm_sub_epi8(acc[k], _mm_cmpeq_epi8(_mm_max_epu8(v, t[k]), v));
+            }
+            stats.count += block;
+            if(++pending==255)
+                flush();
+        }
+        if(x<x1 && block_step<=1)
+            scalar(row+x, x1-x);
+    }
+    flush();
+    stats.sum += (uint64_t)_mm_cvtsi128_si64(sum) + (uint64_t)_mm_cvtsi128_si64(_mm_srli_si128(sum, 8));
+
+#elif defined(__aarch64__)
+    uint8x16_t t[luminance_stats::n_bins];
+    uint8x16_t acc[luminance_stats::n_bins];
+    for(int k=0;k<luminance_stats::n_bins;k++){
+        t[k] = vdupq_n_u8(thresholds[k]);
+        acc[k] = vdupq_n_u8(0);
+    }
+    uint32x4_t sum = vdupq_n_u32(0);
+    int pending = 0;
+
+    auto flush = [&](){
+        for(int k=0;k<luminance_stats::n_bins;k++){
+            stats.ge[k] += vaddlvq_u8(acc[k]);
+            acc[k] = vdupq_n_u8(0);
+        }
+        stats.sum += vaddlvq_u32(sum);
+        sum = vdupq_n_u32(0);
+        pending = 0;
+    };
+
+    for(int y=y0;y<y1;y+=row_step){
+        const uint8_t* row = image + (size_t)y*stride;
+        int x = x0;
+        for(;x+block<=x1;x+=block_advance){
+            uint8x16_t v = vld1q_u8(row+x);
+            sum = vpadalq_u16(sum, vpaddlq_u8(v));
+            for(int k=0;k<luminance_stats::n_bins;k++)
+                acc[k] = vsubq_u8(acc[k], vcgeq_u8(v, t[k]));
+            stats.count += block;
+            if(++pending==255)
+                flush();
+        }
+        if(x<x1 && block_step<=1)
+            scalar(row+x, x1-x);
+    }
+    flush();
+
+#else
+    for(int y=y0;y<y1;y+=row_step){
+        const uint8_t* row = image + (size_t)y*stride;
+        int x = x0;
+        for(;x+block<=x1;x+=block_advance)
+            scalar(row+x, block);
+        if(x<x1 && block_step<=1)
+            scalar(row+x, x1-x);
+    }
+#endif
+}
+
+auto_exposure::auto_exposure(const config& conf)
+:_config(conf){
+
+}
+
+bool auto_exposure::update(const uint8_t* image, int width, int height, size_t stride, double exposure_us, double gain_db,
+                            double& new_exposure_us, double& new_gain_db){
+
+    /* exposure change shows up a few frames later */
+    if(++_frame_count<max(_config.interval, 1))
+        return false;
+    _frame_count = 0;
+
+    luminance_stats full;
+    compute_luminance_stats(image, width, height, stride, camera_roi(), _config.row_step, _config.block_step, _config.saturation_level, full);
+    if(full.count==0)
+        return false;
+
+    double mean = full.mean();
+    double highlight = full.percentile(_config.highlight_percentile);
+    double saturated = full.saturated();
+
+    /* weighted to region of interest */
+    if(_roi){
+        luminance_stats region;
+        compute_luminance_stats(image, width, height, stride, *_roi, max(_config.row_step/2, 1), 1, _config.saturation_level, region);
+        if(region.count>0){
+            double w = clamp(_config.roi_weight, 0.0, 1.0);
+            mean = w*region.mean() + (1.0-w)*mean;
+            highlight = w*region.percentile(_config.highlight_percentile) + (1.0-w)*highlight;
+            saturated = max(saturated*(1.0-w), region.saturated());
+        }
+    }
+    _luminance = mean/255.0;
+    _saturated = saturated;
+
+    /* correction ratio : reach the target mean, but keep highlights below the limit and avoid saturation */
+    double ratio = (_config.target*255.0)/max(mean, 1.0);
+    if(highlight>_config.highlight_limit*255.0)
+        ratio = min(ratio, (_config.highlight_limit*255.0)/highlight);
+    if(saturated>_config.max_saturated)
+        ratio = min(ratio, 0.7);
+
+    /* damped in log domain */
+    ratio = pow(ratio, clamp(_config.damping, 0.0, 1.0));
+    if(fabs(ratio-1.0)<_config.deadband)
+        return false;
+
+    /* exposure first (up to max exposure), then gain */
+    double total = exposure_us*pow(10.0, gain_db/20.0)*ratio;
+    double min_gain = pow(10.0, _config.min_gain_db/20.0);
+    new_exposure_us = clamp(total/min_gain, _config.min_exposure_us, _config.max_exposure_us);
+    new_gain_db = clamp(20.0*log10(max(total/new_exposure_us, 1e-6)), _config.min_gain_db, _config.max_gain_db);
+
+    return fabs(new_exposure_us-exposure_us)>0.5 || fabs(new_gain_db-gain_db)>0.05;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file auto_exposure.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Software auto exposure (exposure time & gain) from subsampled luminance histogram
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_AUTO_EXPOSURE_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_AUTO_EXPOSURE_HPP_INCLUDED
+
+#include <array>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "camera_control.hpp"
+
+using namespace std;
+
+/**
+ * @brief luminance statistics of a subsampled 8bit image.
+ * the histogram is kept as cumulative counts (pixels >= threshold) for 15 uniform thresholds (16, 32, ... 240)
+ * and one saturation threshold, which can be counted with vector compares only.
+ */
+struct luminance_stats {
+    static constexpr int n_bins = 16;
+
+    uint64_t count {0};
+    uint64_t sum {0};
+    array<uint64_t, n_bins> ge {}; /* ge[k] : number of pixels >= 16*(k+1) (k<15), ge[15] : pixels >= saturation level */
+
+    double mean() const { return count ? (double)sum/(double)count : 0.0; }
+    double saturated() const { return count ? (double)ge[n_bins-1]/(double)count : 0.0; }
+    double percentile(double p) const; /* luminance (0~255) below which p of pixels fall (interpolated in bin) */
+};
+
+/**
+ * @brief build luminance statistics from every row_step-th row and every block_step-th 16-pixel block in the region.
+ * uses SSE2 (x86_64) or NEON (aarch64) compares, scalar code otherwise.
+ */
+void compute_luminance_stats(const uint8_t* image, int width, int height, size_t stride, const camera_roi& roi,
+                            int row_step, int block_step, uint8_t saturation_level, luminance_stats& stats);
+
+class auto_exposure {
+    public:
+        struct config {
+            double target {0.45};               /* target mean luminance (0~1) */
+            double highlight_percentile {0.99}; /* this percentile of luminance should stay below highlight_limit */
+            double highlight_limit {0.92};      /* (0~1) */
+            double max_saturated {0.005};       /* allowed saturated pixel fraction */
+            uint8_t saturation_level {250};
+            double damping {0.4};               /* 0~1, fraction of the correction applied per update (log domain) */
+            double deadband {0.04};             /* no change while the correction is within +-deadband */
+            double min_exposure_us {20.0};
+            double max_exposure_us {20000.0};   /* motion blur limit, gain is used above this */
+            double min_gain_db {0.0};
+            double max_gain_db {12.0};
+            double roi_weight {0.7};            /* weight of the roi statistics when roi is set */
+            int row_step {8};
+            int block_step {2};
+            int interval {2};                   /* update every n frames (exposure change latency) */
+        };
+
+        auto_exposure(const config& conf);
+        ~auto_exposure() = default;
+
+        /* weight the statistics to a region (nullopt : whole image) */
+        void set_roi(const optional<camera_roi>& roi) { _roi = roi; }
+
+        /**
+         * @brief update controller with a frame taken with (exposure_us, gain_db).
+         * @return true if new exposure/gain should be applied
+         */
+        bool update(const uint8_t* image, int width, int height, size_t stride, double exposure_us, double gain_db,
+                    double& new_exposure_us, double& new_gain_db);
+
+        double get_luminance() const { return _luminance; }
+        double get_saturated() const { return _saturated; }
+
+    private:
+        config _config;
+        optional<camera_roi> _roi;
+        int _frame_count {0};
+        double _luminance {0.0};
+        double _saturated {0.0};
+
+}; /* class */
+
+#endif
@@ -4,16 +4,35 @@
 #include <flame/config_def.hpp>
 #include <opencv2/opencv.hpp>
 #include <chrono>
+#include <fstream>
+#include <ctime>
+#include <cstdlib>
+#include <sys/resource.h>
 
 using namespace flame;
 using namespace std;
 using namespace cv;
+using namespace Basler_UniversalCameraParams;
 
 /* create component instance */
 static basler_gige_cam_grabber* _instance = nullptr;
 flame::component::object* create(){ if(!_instance) _instance = new basler_gige_cam_grabber(); return _instance; }
 void release(){ if(_instance){ delete _instance; _instance = nullptr; }}
 
+/* cpu time of the calling thread (ns) */
+static uint64_t thread_cpu_ns(){
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* user + system cpu time of this process (s) */
+static double process_cpu_s(){
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)*1e-6;
+}
+
 
 bool basler_gige_cam_grabber::onInit(){
 
@@ -25,29 +44,120 @@ bool basler_gige_cam_grabber::onInit(){
         /* read profile */
         _use_image_stream_monitoring.store(parameters.value("use_image_stream_monitoring", false));
         _use_image_stream.store(parameters.value("use_image_stream", false));
+        _use_frame_sync.store(parameters.value("use_frame_sync", false));
+
+        /* benchmark : pylon camera emulators instead of GigE cameras (number of emulators is set before initialize) */
+        json benchmark_config = parameters.value("benchmark", json::object());
+        _benchmark = benchmark_config.value("enable", false);
+        if(_benchmark)
+            setenv("PYLON_CAMEMU", fmt::format("{}", benchmark_config.value("cameras", 2)).c_str(), 0);
 
         /* pylon initialize */
         PylonInitialize();
 
-        /* find GigE cameras in same netwrok */
+        /* find GigE cameras in same netwrok (or camera emulators for benchmark) */
         CTlFactory& tlFactory = CTlFactory::GetInstance();
         DeviceInfoList_t devices;
-        tlFactory.EnumerateDevices(devices);
+        if(_benchmark){
+            DeviceInfoList_t filter;
+            filter.push_back(CDeviceInfo().SetDeviceClass(BaslerCamEmuDeviceClass));
+            tlFactory.EnumerateDevices(devices, filter);
+        }
+        else
+            tlFactory.EnumerateDevices(devices);
         if(devices.size()>=1)
             logger::info("[{}] Found {} cameras", get_name(), devices.size());
 
-        /* create device & insert to device container */
+        /* create device & insert to device container (emulators have no user defined name, numbered from 1) */
         for(int idx=0;idx<(int)devices.size();idx++){
-            _device_map.insert(make_pair(stoi(devices[idx].GetUserDefinedName().c_str()), new CBaslerUniversalInstantCamera(tlFactory.CreateDevice(devices[idx]))));
+            int camera_id = _benchmark ? idx+1 : stoi(devices[idx].GetUserDefinedName().c_str());
+            _device_map.insert(make_pair(camera_id, new CBaslerUniversalInstantCamera(tlFactory.CreateDevice(devices[idx]))));
             logger::info("[{}] Found Camera ID {}, (SN:{}, Address : {})", get_name(), devices[idx].GetUserDefinedName().c_str(), devices[idx].GetSerialNumber().c_str(), devices[idx].GetIpAddress().c_str());
         }
 
+        /* frame set synchronizer for hardware triggered cameras */
+        if(_use_frame_sync.load()){
+            json sync_config = parameters.value("frame_sync", json::object());
+            double tolerance_us = sync_config.value("tolerance_us", 1000.0);
+            unsigned int timeout_ms = sync_config.value("timeout_ms", 200);
+            size_t max_pending = sync_config.value("max_pending", 16);
+
+            vector<int> camera_ids;
+            for(const auto& camera:_device_map)
+                camera_ids.push_back(camera.first);
+
+            _frame_sync = make_unique<frame_sync>(camera_ids, (uint64_t)(tolerance_us*1000.0), timeout_ms, max_pending);
+            _frame_sync_worker = thread(&basler_gige_cam_grabber::_frame_sync_task, this);
+            logger::info("[{}] Frame synchronizer is running (tolerance : {}us, timeout : {}ms)", get_name(), tolerance_us, timeout_ms);
+        }
+
+        /* frame recorder (writer thread is separated from the grab threads) */
+        json record_config = parameters.value("recorder", json::object());
+        if(!record_config.empty()){
+            frame_recorder::config conf;
+            conf.path = record_config.value("path", conf.path);
+            conf.prefix = record_config.value("prefix", conf.prefix);
+            conf.segment_size = record_config.value("segment_size_mb", (size_t)1024)<<20;
+            conf.slot_size = record_config.value("slot_size_mb", (size_t)4)<<20;
+            conf.n_slots = record_config.value("slots", conf.n_slots);
+            conf.max_batch = record_config.value("max_batch", conf.max_batch);
+            conf.max_segments = record_config.value("max_segments", conf.max_segments);
+            conf.direct_io = record_config.value("direct_io", conf.direct_io);
+            _record_format = record_config.value("format", "raw")=="jpeg" ? frame_recorder::format::jpeg : frame_recorder::format::raw;
+            _recorder = make_unique<frame_recorder>(conf);
+            if(record_config.value("enable", false))
+                _record_command(true);
+        }
+
+        /* telemetry for each camera (created before grab workers start) */
+        for(const auto& camera:_device_map){
+            _telemetry[camera.first] = make_unique<grab_telemetry>();
+            _camera_control[camera.first] = make_unique<camera_control>();
+            _last_grabbed[camera.first] = 0;
+            if(_use_image_stream.load() || _use_frame_sync.load() || (_recorder && _record_format==frame_recorder::format::jpeg))
+                _encode_queue[camera.first] = make_unique<encode_queue>(parameters.value("encode_queue_size", 8));
+            if(_use_image_stream_monitoring.load()){
+                _frame_tap[camera.first] = make_unique<frame_tap>();
+
+                /* monitor bandwidth budget of the port (bytes/s, 0 : unlimited) */
+                json rate_config = parameters.value("monitor_rate", json::object());
+                json port_config = get_profile()->dataport().value(fmt::format("image_stream_monitor_{}", camera.first), json::object());
+                monitor_rate_control::config conf;
+                conf.budget_bytes_per_s = port_config.value("budget_bytes_per_s", 0.0);
+                conf.target_fps = rate_config.value("target_fps", conf.target_fps);
+                conf.min_quality = rate_config.value("min_quality", conf.min_quality);
+                conf.max_quality = rate_config.value("max_quality", conf.max_quality);
+                conf.quality_step = rate_config.value("quality_step", conf.quality_step);
+                conf.scales = rate_config.value("scales", conf.scales);
+                conf.adapt_interval_s = rate_config.value("adapt_interval_s", conf.adapt_interval_s);
+                conf.burst_s = rate_config.value("burst_s", conf.burst_s);
+                _monitor_rate[camera.first] = make_unique<monitor_rate_control>(conf);
+                if(conf.budget_bytes_per_s>0.0)
+                    logger::info("[{}] Camera #{} monitor stream budget : {} bytes/s", get_name(), camera.first, conf.budget_bytes_per_s);
+            }
+        }
+        _last_status_time = chrono::steady_clock::now();
+        if(_benchmark){
+            for(const auto& camera:_device_map)
+                _benchmark_stats[camera.first] = make_unique<benchmark_stats>();
+            _benchmark_start = chrono::steady_clock::now();
+            logger::info("[{}] Benchmark mode with {} emulated camera(s)", get_name(), _device_map.size());
+        }
+
         /* device control handle assign for each camera */
         for(const auto& camera:_device_map){
             _camera_grab_worker[camera.first] = thread(&basler_gige_cam_grabber::_image_stream_task, this, camera.first, camera.second);
             logger::info("[{}] Camera #{} Grabber is running...", get_name(), camera.first);
         }
 
+        /* encode workers (archival path, the grab threads only retrieve and hand off) */
+        for(const auto& queue:_encode_queue)
+            _encode_worker[queue.first] = thread(&basler_gige_cam_grabber::_encode_task, this, queue.first);
+
+        /* monitor stream workers (always encode the newest frame, never stall the grab threads) */
+        for(const auto& tap:_frame_tap)
+            _monitor_worker[tap.first] = thread(&basler_gige_cam_grabber::_monitor_task, this, tap.first);
+
     }
     catch(const GenericException& e){
         logger::error("[{}] Pylon Generic Exception : {}", get_name(), e.GetDescription());
@@ -63,6 +173,12 @@ bool basler_gige_cam_grabber::onInit(){
 
 void basler_gige_cam_grabber::onLoop(){
 
+    /* publish camera telemetry periodically */
+    _publish_status();
+
+    if(_benchmark)
+        _benchmark_update();
+
 }
 
 
@@ -76,6 +192,7 @@ void basler_gige_cam_grabber::onClose(){
     /* work stop signal */
     _use_image_stream_monitoring.store(false);
     _use_image_stream.store(false);
+    _use_frame_sync.store(false);
     _worker_stop.store(true);
 
     /* stop camera grab workers */
@@ -88,6 +205,43 @@ void basler_gige_cam_grabber::onClose(){
 
     _camera_grab_worker.clear();
 
+    /* stop encode workers (before the frame synchronizer and the recorder they feed) */
+    for(auto& queue:_encode_queue)
+        queue.second->stop();
+    for_each(_encode_worker.begin(), _encode_worker.end(), [](auto& t) {
+        if(t.second.joinable()){
+            t.second.join();
+            logger::info("- Camera #{} Encoder is now stopped", t.first);
+        }
+    });
+    _encode_worker.clear();
+
+    /* stop monitor stream workers */
+    for(auto& tap:_frame_tap)
+        tap.second->stop();
+    for_each(_monitor_worker.begin(), _monitor_worker.end(), [](auto& t) {
+        if(t.second.joinable()){
+            t.second.join();
+            logger::info("- Camera #{} Monitor stream is now stopped", t.first);
+        }
+    });
+    _monitor_worker.clear();
+
+    /* stop frame synchronizer */
+    if(_frame_sync)
+        _frame_sync->stop();
+    if(_frame_sync_worker.joinable()){
+        _frame_sync_worker.join();
+        logger::info("- Frame synchronizer is now stopped");
+    }
+    _frame_sync.reset();
+
+    /* flush & close recording */
+    if(_recorder){
+        _recorder->stop();
+        logger::info("- Frame recorder is now stopped");
+    }
+
     /* camera close and delete */
     for(auto& camera:_device_map){
         if(camera.second->IsOpen()){
@@ -100,7 +254,57 @@ void basler_gige_cam_grabber::onClose(){
 }
 
 void basler_gige_cam_grabber::onData(flame::component::ZData& data){
-    
+
+    try{
+        /* command message is the last json part (topic or other parts are skipped) */
+        json command;
+        while(!data.empty()){
+            json part = json::parse(data.popstr(), nullptr, false);
+            if(!part.is_discarded() && part.is_object())
+                command = part;
+        }
+
+        /* recording start/stop */
+        if(command.value("command", "")=="record"){
+            _record_command(command.at("enable").get<bool>());
+            return;
+        }
+
+        if(command.value("command", "")!="camera_control")
+            return;
+
+        /* batch of parameter changes */
+        camera_settings settings;
+        if(command.contains("exposure_time")) settings.exposure_time = command["exposure_time"].get<double>();
+        if(command.contains("gain")) settings.gain = command["gain"].get<double>();
+        if(command.contains("frame_rate")) settings.frame_rate = command["frame_rate"].get<double>();
+        if(command.contains("roi")){
+            const json& roi = command["roi"];
+            settings.roi = camera_roi{roi.value("x", 0), roi.value("y", 0), roi.at("width").get<int>(), roi.at("height").get<int>()};
+        }
+        if(command.contains("auto_exposure")) settings.auto_exposure = command["auto_exposure"].get<bool>();
+        if(command.contains("auto_exposure_roi")){
+            const json& roi = command["auto_exposure_roi"];
+            settings.auto_exposure_roi = roi.is_object() ? camera_roi{roi.value("x", 0), roi.value("y", 0), roi.value("width", 0), roi.value("height", 0)} : camera_roi();
+        }
+
+        /* target cameras (others are untouched) */
+        vector<int> camera_ids;
+        if(command.at("camera").is_array())
+            camera_ids = command["camera"].get<vector<int>>();
+        else
+            camera_ids.push_back(command["camera"].get<int>());
+
+        for(int camera_id:camera_ids){
+            if(_camera_control.contains(camera_id))
+                _camera_control[camera_id]->post(settings);
+            else
+                logger::warn("[{}] Camera #{} is not found for camera control", get_name(), camera_id);
+        }
+    }
+    catch(const json::exception& e){
+        logger::error("[{}] Camera control command error : {}", get_name(), e.what());
+    }
 }
 
 
@@ -119,36 +323,61 @@ void basler_gige_cam_grabber::_image_stream_task(int camera_id, CBaslerUniversal
         string trigger_source = parameters.value("trigger_source", "Line2");
         string trigger_activation = parameters.value("trigger_activation", "RisingEdge");
         int heartbeat_timeout = parameters.value("heartbeat_timeout", 5000);
-        string id_str = fmt::format("{}",camera_id);
-        string image_stream_port = fmt::format("image_stream_{}", camera_id);
-        string image_stream_monitor_port = fmt::format("image_stream_monitor_{}", camera_id); //portname = topic
-
-        int monitoring_width = 0;
-        int monitoring_height = 0;
-        string monitoring_topic {""};
-        try{
-            if(parameters.contains(image_stream_monitor_port)){
-
-                monitoring_width = dataport_config.at(image_stream_monitor_port).at("resolution").value("width", 640);
-                monitoring_height = dataport_config.at(image_stream_monitor_port).at("resolution").value("height", 480);
-                monitoring_topic = fmt::format("{}/{}", get_name(), image_stream_monitor_port);
-                logger::info("[{}] Camera #{} monitoring image resolution : {}x{}", get_name(), camera_id, monitoring_width, monitoring_height);
+        frame_tap* tap = _frame_tap.contains(camera_id) ? _frame_tap.at(camera_id).get() : nullptr;
+        encode_queue* encoder = _encode_queue.contains(camera_id) ? _encode_queue.at(camera_id).get() : nullptr;
+
+        /* grab strategy & buffer count (profile default, can be overridden per camera) */
+        string grab_strategy = parameters.value("grab_strategy", "OneByOne"); // OneByOne, LatestImageOnly, LatestImages, UpcomingImage
+        int max_num_buffer = parameters.value("max_num_buffer", 0); // 0 : pylon default
+        int output_queue_size = parameters.value("output_queue_size", 0); // LatestImages only
+        for(auto& param:parameters["cameras"]){
+            if(param["id"].get<int>()==camera_id){
+                grab_strategy = param.value("grab_strategy", grab_strategy);
+                max_num_buffer = param.value("max_num_buffer", max_num_buffer);
+                output_queue_size = param.value("output_queue_size", output_queue_size);
             }
         }
-        catch(const json::exception& e){
-            logger::error("[{}] Camera #{} monitoring image resolution error : {}", get_name(), camera_id, e.what());
-        }
+        EGrabStrategy strategy = GrabStrategy_OneByOne;
+        if(grab_strategy=="LatestImageOnly") strategy = GrabStrategy_LatestImageOnly;
+        else if(grab_strategy=="LatestImages") strategy = GrabStrategy_LatestImages;
+        else if(grab_strategy=="UpcomingImage") strategy = GrabStrategy_UpcomingImage;
+        else if(grab_strategy!="OneByOne")
+            logger::warn("[{}] Camera #{} unknown grab strategy {}, OneByOne is used", get_name(), camera_id, grab_strategy);
+
+        /* software auto exposure (profile default, can be overridden per camera) */
+        json ae_config = parameters.value("auto_exposure", json::object());
+        auto_exposure::config ae_conf;
+        ae_conf.target = ae_config.value("target", ae_conf.target);
+        ae_conf.highlight_percentile = ae_config.value("highlight_percentile", ae_conf.highlight_percentile);
+        ae_conf.highlight_limit = ae_config.value("highlight_limit", ae_conf.highlight_limit);
+        ae_conf.max_saturated = ae_config.value("max_saturated", ae_conf.max_saturated);
+        ae_conf.saturation_level = ae_config.value("saturation_level", ae_conf.saturation_level);
+        ae_conf.damping = ae_config.value("damping", ae_conf.damping);
+        ae_conf.deadband = ae_config.value("deadband", ae_conf.deadband);
+        ae_conf.min_exposure_us = ae_config.value("min_exposure_us", ae_conf.min_exposure_us);
+        ae_conf.max_exposure_us = ae_config.value("max_exposure_us", ae_conf.max_exposure_us);
+        ae_conf.min_gain_db = ae_config.value("min_gain_db", ae_conf.min_gain_db);
+        ae_conf.max_gain_db = ae_config.value("max_gain_db", ae_conf.max_gain_db);
+        ae_conf.roi_weight = ae_config.value("roi_weight", ae_conf.roi_weight);
+        ae_conf.row_step = ae_config.value("row_step", ae_conf.row_step);
+        ae_conf.block_step = ae_config.value("block_step", ae_conf.block_step);
+        ae_conf.interval = ae_config.value("interval", ae_conf.interval);
+        auto_exposure ae(ae_conf);
+        bool use_auto_exposure = ae_config.value("enable", false);
+        double exposure_set_us = 100.0;
+        double gain_set_db = 0.0;
 
-        
         // camera exposure time set (initial)
         for(auto& param:parameters["cameras"]){
             int id = param["id"].get<int>();
             if(id==camera_id){
+                use_auto_exposure = param.value("auto_exposure", use_auto_exposure);
                 double exposure_time = param.value("exposure_time", 100.0);
                 CEnumerationPtr(camera->GetNodeMap().GetNode("ExposureAuto"))->FromString("Off");
                 CFloatParameter exposureTime(camera->GetNodeMap(), "ExposureTime");
                 if(exposureTime.IsWritable()) {
                     exposureTime.SetValue(exposure_time);
+                    exposure_set_us = exposure_time;
                     logger::info("[{}] Camera #{} Exposure Time set : {}", get_name(), camera_id, exposure_time);
                 }
             }
@@ -162,87 +391,185 @@ void basler_gige_cam_grabber::_image_stream_task(int camera_id, CBaslerUniversal
         logger::info("[{}]* Camera Trigger Activation : {}", get_name(), trigger_activation);
         
         /* set camera parameters */
-        camera->AcquisitionMode.SetValue(acquisition_mode.c_str());
-        camera->AcquisitionFrameRate.SetValue(acquisition_fps);
-        camera->AcquisitionFrameRateEnable.SetValue(false);
-        camera->TriggerSelector.SetValue(trigger_selector.c_str());
-        camera->TriggerMode.SetValue(trigger_mode.c_str());
-        camera->TriggerSource.SetValue(trigger_source.c_str());
-        camera->TriggerActivation.SetValue(trigger_activation.c_str());
-        camera->GevHeartbeatTimeout.SetValue(heartbeat_timeout);
+        if(_benchmark)
+            _setup_emulated_camera(camera_id, camera);
+        else{
+            camera->AcquisitionMode.SetValue(acquisition_mode.c_str());
+            camera->AcquisitionFrameRate.SetValue(acquisition_fps);
+            camera->AcquisitionFrameRateEnable.SetValue(false);
+            camera->TriggerSelector.SetValue(trigger_selector.c_str());
+            camera->TriggerMode.SetValue(trigger_mode.c_str());
+            camera->TriggerSource.SetValue(trigger_source.c_str());
+            camera->TriggerActivation.SetValue(trigger_activation.c_str());
+            camera->GevHeartbeatTimeout.SetValue(heartbeat_timeout);
+        }
+
+        /* chunk data : timestamp, trigger counter, frame id, exposure time, gain */
+        camera->ChunkModeActive.TrySetValue(true);
+        for(auto selector:{ChunkSelector_Timestamp, ChunkSelector_CounterValue, ChunkSelector_FrameID, ChunkSelector_ExposureTime, ChunkSelector_Gain}){
+            if(camera->ChunkSelector.TrySetValue(selector))
+                camera->ChunkEnable.TrySetValue(true);
+        }
+
+        /* count trigger signals from zero on every camera */
+        camera->CounterSelector.TrySetValue(CounterSelector_Counter1);
+        camera->CounterEventSource.TrySetValue(CounterEventSource_FrameTrigger);
+        camera->CounterResetSource.TrySetValue(CounterResetSource_Software);
+        camera->CounterReset.TryExecute();
+
+        /* common time base for frame set synchronization : PTP or timestamp reset at start */
+        if(_use_frame_sync.load()){
+            json sync_config = parameters.value("frame_sync", json::object());
+            if(sync_config.value("use_ptp", false)){
+                camera->PtpEnable.TrySetValue(true);
+                camera->GevIEEE1588.TrySetValue(true);
+            }
+            else{
+                camera->TimestampReset.TryExecute();
+                camera->GevTimestampControlReset.TryExecute();
+            }
+            logger::info("[{}] Camera #{} frame sync enabled (PTP : {})", get_name(), camera_id, sync_config.value("use_ptp", false));
+        }
+
+        /* camera timestamp tick to host monotonic clock mapping (re-estimated periodically between grabs) */
+        double timestamp_tick_ns = 1.0;
+        if(camera->GevTimestampTickFrequency.IsReadable() && camera->GevTimestampTickFrequency.GetValue()>0)
+            timestamp_tick_ns = 1e9/(double)camera->GevTimestampTickFrequency.GetValue();
+        chrono::milliseconds clock_sync_period(parameters.value("clock_sync_period_ms", 1000));
+        camera_clock clock(timestamp_tick_ns, parameters.value("clock_sync_window", 32));
+        if(!_sync_camera_clock(camera, clock))
+            logger::warn("[{}] Camera #{} timestamp latch is not supported, frame timestamp is not available", get_name(), camera_id);
+        auto last_clock_sync = chrono::steady_clock::now();
 
         /* start grabbing */
-        camera->StartGrabbing(Pylon::GrabStrategy_OneByOne, Pylon::GrabLoop_ProvidedByUser);
-        CGrabResultPtr ptrGrabResult;
+        if(max_num_buffer>0)
+            camera->MaxNumBuffer.TrySetValue(max_num_buffer);
+        if(strategy==GrabStrategy_LatestImages && output_queue_size>0)
+            camera->OutputQueueSize.TrySetValue(output_queue_size);
+        camera->StartGrabbing(strategy, Pylon::GrabLoop_ProvidedByUser);
+        logger::info("[{}] Camera #{} grab strategy : {} (buffers : {})", get_name(), camera_id, grab_strategy, camera->MaxNumBuffer.GetValue());
+        CBaslerUniversalGrabResultPtr ptrGrabResult;
 
         logger::info("[{}] Camera #{} grabber is now running...",get_name(), camera_id);
-        unsigned long long camera_grab_counter = 0;
+        grab_telemetry* telemetry = _telemetry.at(camera_id).get();
+        camera_control* control = _camera_control.at(camera_id).get();
+        uint64_t last_frame_id = 0;
+        bool first_frame = true;
         while(!_worker_stop.load()){
             try{
                 if(!camera->IsGrabbing())
                     break;
                 
                 bool success = camera->RetrieveResult(5000, ptrGrabResult, Pylon::TimeoutHandling_ThrowException); //trigger mode makes it blocked
+                uint64_t grab_ns = camera_clock::host_now_ns();
+                uint64_t grab_cpu_ns = thread_cpu_ns();
                 if(!success){
                     logger::warn("[{}] Camera #{} will be terminated by force.", get_name(), camera_id);
                     break;
                 }
                 else { // no timeout, success
+                    if(camera->NumReadyBuffers.IsReadable())
+                        telemetry->set_queue_depth((uint64_t)camera->NumReadyBuffers.GetValue());
+
                     if(ptrGrabResult.IsValid()){
                         if(ptrGrabResult->GrabSucceeded()){
-    
-                            auto start = std::chrono::system_clock::now();
-    
+
                             /* grabbed imgae stores into buffer */
                             const uint8_t* pImageBuffer = (uint8_t*)ptrGrabResult->GetBuffer();
     
-                            /* get image properties */
-                            size_t size = ptrGrabResult->GetWidth() * ptrGrabResult->GetHeight();
-                            cv::Mat image(ptrGrabResult->GetHeight(), ptrGrabResult->GetWidth(), CV_8UC1, (void*)pImageBuffer);
-    
-                            /* push image into image_stream pipeline  */
-                            if(_use_image_stream.load()){
+                            /* frame timestamp : exposure midpoint in host monotonic clock (chunk timestamp is exposure start) */
+                            uint64_t ticks = ptrGrabResult->ChunkTimestamp.IsReadable() ? (uint64_t)ptrGrabResult->ChunkTimestamp.GetValue() : ptrGrabResult->GetTimeStamp();
+                            double exposure_us = ptrGrabResult->ChunkExposureTime.IsReadable() ? ptrGrabResult->ChunkExposureTime.GetValue() : 0.0;
+                            uint64_t frame_id = ptrGrabResult->ChunkFrameID.IsReadable() ? (uint64_t)ptrGrabResult->ChunkFrameID.GetValue() : ptrGrabResult->GetBlockID();
+                            uint64_t trigger_count = ptrGrabResult->ChunkCounterValue.IsReadable() ? (uint64_t)ptrGrabResult->ChunkCounterValue.GetValue() : frame_id;
+                            uint64_t timestamp_ns = (clock.valid() ? clock.to_host_ns(ticks) : (uint64_t)((double)ticks*timestamp_tick_ns)) + (uint64_t)(exposure_us*500.0);
 
-                                //jpg encoding
-                                std::vector<unsigned char> encoded_image;
-                                cv::imencode(".jpg", image, encoded_image);
-    
-                                pipe_data msg_image(encoded_image.data(), encoded_image.size());
-    
-                                if(get_port(image_stream_port)->handle()!=nullptr){
-                                    zmq::multipart_t msg_multipart_image_stream;
-                                    msg_multipart_image_stream.addstr(id_str);
-                                    msg_multipart_image_stream.addmem(encoded_image.data(), encoded_image.size());
-                                    msg_multipart_image_stream.send(*get_port(image_stream_port), ZMQ_DONTWAIT);
-                                }
-                                else{
-                                    logger::warn("[{}] {} socket handle is not valid ", get_name(), camera_id);
+                            /* telemetry : frame id gap(dropped), camera to host latency */
+                            telemetry->grabbed.fetch_add(1, memory_order_relaxed);
+                            if(!first_frame && frame_id>last_frame_id+1)
+                                telemetry->dropped.fetch_add(frame_id-last_frame_id-1, memory_order_relaxed);
+                            last_frame_id = frame_id;
+                            first_frame = false;
+                            if(clock.valid() && grab_ns>timestamp_ns)
+                                telemetry->exposure_to_grab.record(grab_ns-timestamp_ns);
+
+                            /* software auto exposure (measured with the exposure/gain this frame was actually taken with) */
+                            double gain_db = ptrGrabResult->ChunkGain.IsReadable() ? ptrGrabResult->ChunkGain.GetValue() : gain_set_db;
+                            if(use_auto_exposure){
+                                uint64_t ae_start_ns = camera_clock::host_now_ns();
+                                double new_exposure_us = 0.0, new_gain_db = 0.0;
+                                size_t stride = ptrGrabResult->GetWidth() + ptrGrabResult->GetPaddingX();
+                                if(ae.update(pImageBuffer, (int)ptrGrabResult->GetWidth(), (int)ptrGrabResult->GetHeight(), stride,
+                                            exposure_us>0.0 ? exposure_us : exposure_set_us, gain_db, new_exposure_us, new_gain_db)){
+                                    if(camera->ExposureTime.TrySetValue(new_exposure_us, FloatValueCorrection_ClipToRange))
+                                        exposure_set_us = new_exposure_us;
+                                    if(camera->Gain.TrySetValue(new_gain_db, FloatValueCorrection_ClipToRange))
+                                        gain_set_db = new_gain_db;
                                 }
+                                telemetry->auto_exposure.record(camera_clock::host_now_ns()-ae_start_ns);
                             }
-    
-    
-                            /* publish for monitoring (size reduction for performance)*/
-                            if(_use_image_stream_monitoring.load()){
-                                
-                                cv::Mat monitor_image;
-                                cv::resize(image, monitor_image, cv::Size(monitoring_width, monitoring_height));
-
-                                std::vector<unsigned char> encoded_monitor_image;
-                                cv::imencode(".jpg", monitor_image, encoded_monitor_image);
-                                pipe_data msg_monitor_image(encoded_monitor_image.data(), encoded_monitor_image.size());
-    
-                                zmq::multipart_t msg_multipart_stream_monitor;
-                                msg_multipart_stream_monitor.addstr(monitoring_topic);
-                                msg_multipart_stream_monitor.addstr(id_str);
-                                msg_multipart_stream_monitor.addmem(encoded_monitor_image.data(), encoded_monitor_image.size());
-                                msg_multipart_stream_monitor.send(*get_port(image_stream_monitor_port), ZMQ_DONTWAIT);
-                            }
+
+                            /* frame meta (plain values, serialized into a reused buffer only when published) */
+                            frame_meta meta;
+                            meta.frame_id = frame_id;
+                            meta.trigger = trigger_count;
+                            meta.timestamp_ns = timestamp_ns;
+                            meta.exposure_us = exposure_us;
+                            meta.gain_db = gain_db;
+                            meta.luminance = use_auto_exposure ? ae.get_luminance() : -1.0;
+                            meta.host_clock = clock.valid();
+                            meta.clock_uncertainty_ns = clock.get_uncertainty_ns();
+                            telemetry->last_timestamp_ns.store(timestamp_ns, memory_order_relaxed);
+
+                            /* newest frame for monitoring (resized & encoded by the monitor worker) */
+                            if(tap)
+                                tap->put(pImageBuffer, (int)ptrGrabResult->GetWidth(), (int)ptrGrabResult->GetHeight(),
+                                        ptrGrabResult->GetWidth()+ptrGrabResult->GetPaddingX(), timestamp_ns, meta);
+
+                            /* archival path : handed off to the encode worker (dropped and counted if it is behind by the whole queue) */
+                            bool recording = _recorder && _recorder->is_recording();
+                            bool record_jpeg = recording && _record_format==frame_recorder::format::jpeg;
+                            if(encoder && (_use_image_stream.load() || _use_frame_sync.load() || record_jpeg))
+                                encoder->push(pImageBuffer, (int)ptrGrabResult->GetWidth(), (int)ptrGrabResult->GetHeight(),
+                                            ptrGrabResult->GetWidth()+ptrGrabResult->GetPaddingX(), grab_ns, record_jpeg, meta);
+
+                            /* raw record (copied into a preallocated slot, written by the recorder thread) */
+                            if(recording && _record_format==frame_recorder::format::raw)
+                                _recorder->push(camera_id, _record_format, (int)ptrGrabResult->GetWidth(), (int)ptrGrabResult->GetHeight(), frame_id, timestamp_ns, pImageBuffer, ptrGrabResult->GetImageSize());
+
+                            telemetry->frame_cpu.record(thread_cpu_ns()-grab_cpu_ns);
                         }
                         else{
+                            telemetry->grab_failed.fetch_add(1, memory_order_relaxed);
                             logger::warn("[{}] Error-code({}) : {}", get_name(), ptrGrabResult->GetErrorCode(), ptrGrabResult->GetErrorDescription().c_str());
                         }
                     }
                 }
+
+                /* re-estimate camera clock mapping & read stream statistics at frame boundary */
+                if(chrono::steady_clock::now()-last_clock_sync>=clock_sync_period){
+                    _sync_camera_clock(camera, clock);
+                    _read_stream_statistics(camera, telemetry);
+                    last_clock_sync = chrono::steady_clock::now();
+                }
+
+                /* apply requested parameter changes at frame boundary (this camera only) */
+                camera_settings settings;
+                if(control->take(settings)){
+                    if(settings.auto_exposure)
+                        use_auto_exposure = *settings.auto_exposure;
+                    else if(settings.exposure_time || settings.gain)
+                        use_auto_exposure = false; /* manual exposure overrides auto exposure */
+                    if(settings.auto_exposure_roi){
+                        const camera_roi& roi = *settings.auto_exposure_roi;
+                        ae.set_roi((roi.width>0 && roi.height>0) ? optional<camera_roi>(roi) : nullopt);
+                    }
+                    if(settings.exposure_time) exposure_set_us = *settings.exposure_time;
+                    if(settings.gain) gain_set_db = *settings.gain;
+
+                    _apply_camera_settings(camera_id, camera, settings, strategy);
+                    logger::info("[{}] Camera #{} auto exposure : {}", get_name(), camera_id, use_auto_exposure?"On":"Off");
+                }
                 
             }
             catch(Pylon::RuntimeException& e){
@@ -253,10 +580,6 @@ void basler_gige_cam_grabber::_image_stream_task(int camera_id, CBaslerUniversal
                 logger::error("[{}] Camera {} Generic Exception ({})", get_name(), camera_id, e.what());
                 break;
             }
-            catch(const zmq::error_t& e){
-                logger::error("[{}] {}", get_name(), e.what());
-                break;
-            }
         }
 
         /* stop grabbing */
@@ -269,4 +592,505 @@ void basler_gige_cam_grabber::_image_stream_task(int camera_id, CBaslerUniversal
     }
 }
 
+bool basler_gige_cam_grabber::_sync_camera_clock(CBaslerUniversalInstantCamera* camera, camera_clock& clock){
+
+    /* latch camera timestamp between host clock reads, keep the fastest round-trip of a few trials */
+    uint64_t best_ticks = 0, best_before = 0, best_after = 0;
+    for(int trial=0;trial<3;trial++){
+        uint64_t before = camera_clock::host_now_ns();
+        if(camera->TimestampLatch.IsWritable())
+            camera->TimestampLatch.Execute();
+        else if(camera->GevTimestampControlLatch.IsWritable())
+            camera->GevTimestampControlLatch.Execute();
+        else
+            return false;
+        uint64_t after = camera_clock::host_now_ns();
+
+        uint64_t ticks = camera->TimestampLatchValue.IsReadable() ? (uint64_t)camera->TimestampLatchValue.GetValue() : (uint64_t)camera->GevTimestampValue.GetValue();
+        if(trial==0 || after-before<best_after-best_before){
+            best_ticks = ticks;
+            best_before = before;
+            best_after = after;
+        }
+    }
+
+    clock.add_sample(best_ticks, best_before, best_after);
+    return true;
+}
+
+void basler_gige_cam_grabber::_apply_camera_settings(int camera_id, CBaslerUniversalInstantCamera* camera, const camera_settings& settings, EGrabStrategy strategy){
+
+    /* width/height change needs to restart grabbing (payload size), offsets can be changed while grabbing */
+    bool restart = settings.roi && (settings.roi->width!=camera->Width.GetValue() || settings.roi->height!=camera->Height.GetValue());
+
+    try{
+        if(restart)
+            camera->StopGrabbing();
+
+        if(settings.exposure_time){
+            camera->ExposureAuto.TrySetValue(ExposureAuto_Off);
+            if(!camera->ExposureTime.TrySetValue(*settings.exposure_time, FloatValueCorrection_ClipToRange))
+                logger::warn("[{}] Camera #{} Exposure Time is not writable", get_name(), camera_id);
+        }
+
+        if(settings.gain){
+            camera->GainAuto.TrySetValue(GainAuto_Off);
+            if(!camera->Gain.TrySetValue(*settings.gain, FloatValueCorrection_ClipToRange))
+                logger::warn("[{}] Camera #{} Gain is not writable", get_name(), camera_id);
+        }
+
+        if(settings.frame_rate){
+            bool limit = *settings.frame_rate>0.0;
+            camera->AcquisitionFrameRateEnable.TrySetValue(limit);
+            if(limit && !camera->AcquisitionFrameRate.TrySetValue(*settings.frame_rate, FloatValueCorrection_ClipToRange))
+                logger::warn("[{}] Camera #{} Acquisition Framerate is not writable", get_name(), camera_id);
+        }
+
+        if(settings.roi){
+            const camera_roi& roi = *settings.roi;
+            if(restart){
+                camera->OffsetX.TrySetValue(0);
+                camera->OffsetY.TrySetValue(0);
+                camera->Width.TrySetValue(roi.width, IntegerValueCorrection_Nearest);
+                camera->Height.TrySetValue(roi.height, IntegerValueCorrection_Nearest);
+            }
+            camera->OffsetX.TrySetValue(roi.x, IntegerValueCorrection_Nearest);
+            camera->OffsetY.TrySetValue(roi.y, IntegerValueCorrection_Nearest);
+        }
+    }
+    catch(const GenericException& e){
+        logger::error("[{}] Camera #{} parameter change error : {}", get_name(), camera_id, e.GetDescription());
+    }
+
+    if(restart && !camera->IsGrabbing())
+        camera->StartGrabbing(strategy, Pylon::GrabLoop_ProvidedByUser);
+
+    logger::info("[{}] Camera #{} parameters changed (exposure : {}, gain : {}, framerate : {}, roi : {}x{}+{}+{})", get_name(), camera_id,
+                    camera->ExposureTime.GetValue(), camera->Gain.GetValue(), camera->AcquisitionFrameRate.GetValue(),
+                    camera->Width.GetValue(), camera->Height.GetValue(), camera->OffsetX.GetValue(), camera->OffsetY.GetValue());
+}
+
+void basler_gige_cam_grabber::_read_stream_statistics(CBaslerUniversalInstantCamera* camera, grab_telemetry* telemetry){
+
+    INodeMap& nodemap = camera->GetStreamGrabberNodeMap();
+    auto read = [&nodemap](const char* name, atomic<uint64_t>& value){
+        CIntegerParameter statistic(nodemap, name);
+        if(statistic.IsReadable())
+            value.store((uint64_t)statistic.GetValue(), memory_order_relaxed);
+    };
+    read("Statistic_Total_Buffer_Count", telemetry->total_buffers);
+    read("Statistic_Failed_Buffer_Count", telemetry->failed_buffers);
+    read("Statistic_Buffer_Underrun_Count", telemetry->buffer_underruns);
+    read("Statistic_Resend_Request_Count", telemetry->resend_requests);
+    read("Statistic_Resend_Packet_Count", telemetry->resend_packets);
+}
+
+void basler_gige_cam_grabber::_count_publish(grab_telemetry* telemetry, bool sent, size_t bytes){
+    if(sent){
+        telemetry->published.fetch_add(1, memory_order_relaxed);
+        telemetry->published_bytes.fetch_add(bytes, memory_order_relaxed);
+    }
+    else
+        telemetry->publish_failed.fetch_add(1, memory_order_relaxed);
+}
+
+void basler_gige_cam_grabber::_record_command(bool enable){
+    if(!_recorder){
+        logger::warn("[{}] Frame recorder is not configured", get_name());
+        return;
+    }
+
+    if(enable){
+        if(_recorder->start())
+            logger::info("[{}] Frame recording is started ({})", get_name(), _recorder->get_session_path());
+        else
+            logger::error("[{}] Frame recording cannot be started", get_name());
+    }
+    else{
+        _recorder->stop();
+        logger::info("[{}] Frame recording is stopped (recorded : {}, dropped : {})", get_name(), _recorder->get_recorded_count(), _recorder->get_dropped_count());
+    }
+}
+
+void basler_gige_cam_grabber::_publish_status(){
+
+    auto now = chrono::steady_clock::now();
+    double elapsed = chrono::duration<double>(now-_last_status_time).count();
+    _last_status_time = now;
+
+    auto to_json = [](const latency_histogram::summary& s){
+        return json{{"count", s.count}, {"mean", s.mean_us}, {"p50", s.p50_us}, {"p90", s.p90_us}, {"p99", s.p99_us}, {"max", s.max_us}};
+    };
+
+    json status;
+    status["timestamp_ns"] = camera_clock::host_now_ns();
+    status["cameras"] = json::object();
+    for(auto& [camera_id, telemetry]:_telemetry){
+        benchmark_stats* bench = _benchmark_measuring ? _benchmark_stats[camera_id].get() : nullptr;
+        uint64_t grabbed = telemetry->grabbed.load(memory_order_relaxed);
+        json camera;
+        camera["fps"] = elapsed>0.0 ? (double)(grabbed-_last_grabbed[camera_id])/elapsed : 0.0;
+        camera["grabbed"] = grabbed;
+        camera["grab_failed"] = telemetry->grab_failed.load(memory_order_relaxed);
+        camera["dropped"] = telemetry->dropped.load(memory_order_relaxed);
+        camera["encoded"] = telemetry->encoded.load(memory_order_relaxed);
+        camera["published"] = telemetry->published.load(memory_order_relaxed);
+        camera["publish_failed"] = telemetry->publish_failed.load(memory_order_relaxed);
+        camera["published_bytes"] = telemetry->published_bytes.load(memory_order_relaxed);
+        camera["stream"] = {
+            {"total_buffers", telemetry->total_buffers.load(memory_order_relaxed)},
+            {"failed_buffers", telemetry->failed_buffers.load(memory_order_relaxed)},
+            {"buffer_underruns", telemetry->buffer_underruns.load(memory_order_relaxed)},
+            {"resend_requests", telemetry->resend_requests.load(memory_order_relaxed)},
+            {"resend_packets", telemetry->resend_packets.load(memory_order_relaxed)}
+        };
+        camera["queue_depth"] = telemetry->queue_depth.load(memory_order_relaxed);
+        camera["queue_depth_max"] = telemetry->queue_depth_max.exchange(0, memory_order_relaxed);
+        uint64_t last_timestamp_ns = telemetry->last_timestamp_ns.load(memory_order_relaxed);
+        uint64_t now_ns = camera_clock::host_now_ns();
+        camera["age_ms"] = (last_timestamp_ns>0 && now_ns>last_timestamp_ns) ? (double)(now_ns-last_timestamp_ns)/1e6 : -1.0;
+        if(_encode_queue.contains(camera_id)){
+            camera["encode_dropped"] = _encode_queue[camera_id]->get_dropped_count();
+            camera["encode_queue_max"] = _encode_queue[camera_id]->take_depth_max();
+        }
+        if(_frame_tap.contains(camera_id))
+            camera["monitor_skipped"] = _frame_tap[camera_id]->get_overwritten_count();
+        if(_monitor_rate.contains(camera_id)){
+            monitor_operating_point point = _monitor_rate[camera_id]->get_operating_point();
+            camera["monitor"] = {
+                {"scale", point.scale},
+                {"quality", point.quality},
+                {"fps", point.fps},
+                {"bytes_per_s", point.bytes_per_s},
+                {"bytes_per_frame", point.bytes_per_frame},
+                {"decimated", point.decimated}
+            };
+        }
+        camera["latency_us"] = {
+            {"exposure_to_grab", to_json(telemetry->exposure_to_grab.take())},
+            {"grab_to_encode", to_json(telemetry->grab_to_encode.take(bench ? &bench->grab_to_encode : nullptr))},
+            {"encode_to_send", to_json(telemetry->encode_to_send.take())},
+            {"auto_exposure", to_json(telemetry->auto_exposure.take())},
+            {"frame_cpu", to_json(telemetry->frame_cpu.take(bench ? &bench->frame_cpu : nullptr))},
+            {"monitor_encode", to_json(telemetry->monitor_encode.take())},
+            {"monitor_age", to_json(telemetry->monitor_age.take())}
+        };
+        status["cameras"][fmt::format("{}", camera_id)] = camera;
+        _last_grabbed[camera_id] = grabbed;
+    }
+
+    /* frame set sync health (cumulative) */
+    if(_frame_sync){
+        status["frame_sync"] = {
+            {"complete", _frame_sync->get_complete_count()},
+            {"incomplete", _frame_sync->get_incomplete_count()},
+            {"rejected", _frame_sync->get_rejected_count()},
+            {"realigned", _frame_sync->get_realigned_count()}
+        };
+    }
+
+    if(_recorder){
+        status["recorder"] = {
+            {"recording", _recorder->is_recording()},
+            {"recorded", _recorder->get_recorded_count()},
+            {"dropped", _recorder->get_dropped_count()},
+            {"written_bytes", _recorder->get_written_bytes()},
+            {"write_errors", _recorder->get_write_error_count()},
+            {"segments", _recorder->get_segment_count()},
+            {"free_slots_min", _recorder->get_free_slots_min()},
+            {"write_latency_us", to_json(_recorder->get_write_latency().take())}
+        };
+    }
+
+    try{
+        if(get_port("status")->handle()!=nullptr){
+            zmq::multipart_t msg_multipart_status;
+            msg_multipart_status.addstr(fmt::format("{}/status", get_name()));
+            msg_multipart_status.addstr(status.dump());
+            msg_multipart_status.send(*get_port("status"), ZMQ_DONTWAIT);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Status publish error : {}", get_name(), e.what());
+    }
+}
+
+void basler_gige_cam_grabber::_setup_emulated_camera(int camera_id, CBaslerUniversalInstantCamera* camera){
+    json benchmark_config = get_profile()->parameters().value("benchmark", json::object());
+    int width = benchmark_config.value("width", 1920);
+    int height = benchmark_config.value("height", 1200);
+    double fps = benchmark_config.value("fps", 30.0);
+
+    /* free running emulator with moving test image at the given rate */
+    camera->PixelFormat.TrySetValue(PixelFormat_Mono8);
+    camera->OffsetX.TrySetValue(0);
+    camera->OffsetY.TrySetValue(0);
+    camera->Width.TrySetValue(width, IntegerValueCorrection_Nearest);
+    camera->Height.TrySetValue(height, IntegerValueCorrection_Nearest);
+    camera->AcquisitionMode.TrySetValue(AcquisitionMode_Continuous);
+    camera->TriggerMode.TrySetValue(TriggerMode_Off);
+    camera->AcquisitionFrameRateEnable.TrySetValue(true);
+    camera->AcquisitionFrameRate.TrySetValue(fps, FloatValueCorrection_ClipToRange);
+    camera->TestImageSelector.TrySetValue(TestImageSelector_Testimage2);
+
+    logger::info("[{}] Camera #{} emulated : {}x{} @ {} fps", get_name(), camera_id, camera->Width.GetValue(), camera->Height.GetValue(), fps);
+}
+
+void basler_gige_cam_grabber::_benchmark_update(){
+    json benchmark_config = get_profile()->parameters().value("benchmark", json::object());
+    double warmup_s = benchmark_config.value("warmup_s", 5.0);
+    double duration_s = benchmark_config.value("duration_s", 30.0);
+
+    auto now = chrono::steady_clock::now();
+
+    /* measured window starts after warmup (histograms are accumulated from the next status period) */
+    if(!_benchmark_measuring && !_benchmark_reported){
+        if(chrono::duration<double>(now-_benchmark_start).count()<warmup_s)
+            return;
+        for(auto& [camera_id, bench]:_benchmark_stats){
+            grab_telemetry* telemetry = _telemetry.at(camera_id).get();
+            bench->grabbed = telemetry->grabbed.load(memory_order_relaxed);
+            bench->dropped = telemetry->dropped.load(memory_order_relaxed);
+            bench->grab_failed = telemetry->grab_failed.load(memory_order_relaxed);
+            bench->publish_failed = telemetry->publish_failed.load(memory_order_relaxed);
+        }
+        _benchmark_cpu_start = process_cpu_s();
+        _benchmark_measure_start = now;
+        _benchmark_measuring = true;
+        logger::info("[{}] Benchmark measuring for {} s...", get_name(), duration_s);
+        return;
+    }
+
+    if(!_benchmark_measuring || chrono::duration<double>(now-_benchmark_measure_start).count()<duration_s)
+        return;
+
+    /* report */
+    _benchmark_measuring = false;
+    _benchmark_reported = true;
+    double elapsed = chrono::duration<double>(now-_benchmark_measure_start).count();
+    double cpu_s = process_cpu_s()-_benchmark_cpu_start;
+
+    auto to_json = [](const latency_histogram::summary& s){
+        return json{{"count", s.count}, {"mean", s.mean_us}, {"p50", s.p50_us}, {"p90", s.p90_us}, {"p99", s.p99_us}, {"max", s.max_us}};
+    };
+
+    json report;
+    report["duration_s"] = elapsed;
+    report["cameras"] = json::object();
+    uint64_t total_frames = 0;
+    for(auto& [camera_id, bench]:_benchmark_stats){
+        grab_telemetry* telemetry = _telemetry.at(camera_id).get();
+        uint64_t frames = telemetry->grabbed.load(memory_order_relaxed)-bench->grabbed;
+        latency_histogram::summary encode = bench->grab_to_encode.take();
+        latency_histogram::summary cpu = bench->frame_cpu.take();
+        total_frames += frames;
+
+        json camera;
+        camera["frames"] = frames;
+        camera["fps"] = (double)frames/elapsed;
+        camera["dropped"] = telemetry->dropped.load(memory_order_relaxed)-bench->dropped;
+        camera["grab_failed"] = telemetry->grab_failed.load(memory_order_relaxed)-bench->grab_failed;
+        camera["publish_failed"] = telemetry->publish_failed.load(memory_order_relaxed)-bench->publish_failed;
+        camera["grab_to_encode_us"] = to_json(encode);
+        camera["frame_cpu_us"] = to_json(cpu);
+        report["cameras"][fmt::format("{}", camera_id)] = camera;
+
+        logger::info("[{}] Benchmark Camera #{} : {:.2f} fps, dropped {}, encode p50/p99 {:.0f}/{:.0f} us, cpu/frame {:.0f} us",
+                    get_name(), camera_id, camera["fps"].get<double>(), camera["dropped"].get<uint64_t>(), encode.p50_us, encode.p99_us, cpu.mean_us);
+    }
+    report["process_cpu_percent"] = 100.0*cpu_s/elapsed;
+    report["process_cpu_us_per_frame"] = total_frames ? cpu_s*1e6/(double)total_frames : 0.0;
+    logger::info("[{}] Benchmark process cpu : {:.1f} %, {:.0f} us/frame", get_name(), report["process_cpu_percent"].get<double>(), report["process_cpu_us_per_frame"].get<double>());
+
+    string report_path = benchmark_config.value("report", "");
+    if(!report_path.empty()){
+        ofstream file(report_path);
+        if(file.is_open()){
+            file << report.dump(4) << endl;
+            logger::info("[{}] Benchmark report is saved : {}", get_name(), report_path);
+        }
+        else
+            logger::error("[{}] Benchmark report cannot be saved : {}", get_name(), report_path);
+    }
+}
+
+void basler_gige_cam_grabber::_encode_task(int camera_id){
 
+    string image_stream_port = fmt::format("image_stream_{}", camera_id);
+    string id_str = fmt::format("{}", camera_id);
+    encode_queue* queue = _encode_queue.at(camera_id).get();
+    grab_telemetry* telemetry = _telemetry.at(camera_id).get();
+
+    queued_frame frame;
+    std::vector<unsigned char> encoded_image;
+    string meta_buffer;
+    try{
+        while(!_worker_stop.load()){
+            if(!queue->pop(frame, 100))
+                continue;
+
+            //jpg encoding (shared by image_stream, jpeg recording and frame sync)
+            cv::Mat image(frame.height, frame.width, CV_8UC1, frame.image.data());
+            cv::imencode(".jpg", image, encoded_image);
+            uint64_t encoded_ns = camera_clock::host_now_ns();
+            telemetry->encoded.fetch_add(1, memory_order_relaxed);
+            telemetry->grab_to_encode.record(encoded_ns-frame.grab_ns);
+
+            /* push image into image_stream pipeline  */
+            if(_use_image_stream.load()){
+                if(get_port(image_stream_port)->handle()!=nullptr){
+                    frame.meta.write(meta_buffer);
+                    zmq::multipart_t msg_multipart_image_stream;
+                    msg_multipart_image_stream.addstr(id_str);
+                    msg_multipart_image_stream.addmem(encoded_image.data(), encoded_image.size());
+                    msg_multipart_image_stream.addstr(meta_buffer);
+                    _count_publish(telemetry, msg_multipart_image_stream.send(*get_port(image_stream_port), ZMQ_DONTWAIT), encoded_image.size());
+                }
+                else{
+                    logger::warn("[{}] {} socket handle is not valid ", get_name(), camera_id);
+                }
+            }
+
+            /* record (copied into a preallocated slot, written by the recorder thread) */
+            if(frame.record && _recorder)
+                _recorder->push(camera_id, frame_recorder::format::jpeg, frame.width, frame.height, frame.meta.frame_id, frame.meta.timestamp_ns, encoded_image.data(), encoded_image.size());
+
+            /* push image into frame synchronizer (matched by trigger count & timestamp) */
+            if(_use_frame_sync.load() && _frame_sync){
+                grabbed_frame synced;
+                synced.camera_id = camera_id;
+                synced.trigger_count = frame.meta.trigger;
+                synced.timestamp_ns = frame.meta.timestamp_ns;
+                synced.encoded = std::move(encoded_image);
+                _frame_sync->push(std::move(synced));
+            }
+
+            telemetry->encode_to_send.record(camera_clock::host_now_ns()-encoded_ns);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Camera #{} image stream : {}", get_name(), camera_id, e.what());
+    }
+    catch(const cv::Exception& e){
+        logger::error("[{}] Camera #{} image stream : {}", get_name(), camera_id, e.what());
+    }
+}
+
+void basler_gige_cam_grabber::_monitor_task(int camera_id){
+
+    string monitor_port = fmt::format("image_stream_monitor_{}", camera_id); //portname = topic
+    string monitor_topic = fmt::format("{}/{}", get_name(), monitor_port);
+    string id_str = fmt::format("{}", camera_id);
+    frame_tap* tap = _frame_tap.at(camera_id).get();
+    monitor_rate_control* rate = _monitor_rate.at(camera_id).get();
+    grab_telemetry* telemetry = _telemetry.at(camera_id).get();
+
+    int monitoring_width = 640;
+    int monitoring_height = 480;
+    try{
+        json dataport_config = get_profile()->dataport();
+        if(dataport_config.contains(monitor_port)){
+            monitoring_width = dataport_config.at(monitor_port).at("resolution").value("width", 640);
+            monitoring_height = dataport_config.at(monitor_port).at("resolution").value("height", 480);
+        }
+        logger::info("[{}] Camera #{} monitoring image resolution : {}x{}", get_name(), camera_id, monitoring_width, monitoring_height);
+    }
+    catch(const json::exception& e){
+        logger::error("[{}] Camera #{} monitoring image resolution error : {}", get_name(), camera_id, e.what());
+    }
+
+    tapped_frame frame;
+    cv::Mat monitor_image;
+    std::vector<unsigned char> encoded_monitor_image;
+    string meta_buffer;
+    try{
+        while(!_worker_stop.load()){
+            if(!tap->take(frame, 100))
+                continue;
+
+            /* frame decimation by the bandwidth budget (before encoding) */
+            uint64_t encode_start_ns = camera_clock::host_now_ns();
+            if(!rate->admit(encode_start_ns))
+                continue;
+
+            /* size reduction for monitoring performance (resolution level & quality chosen by the budget) */
+            cv::Mat image(frame.height, frame.width, CV_8UC1, frame.image.data());
+            cv::Size size(max(2, (int)(monitoring_width*rate->get_scale()) & ~1), max(2, (int)(monitoring_height*rate->get_scale()) & ~1));
+            cv::resize(image, monitor_image, size, 0, 0, cv::INTER_AREA);
+            cv::imencode(".jpg", monitor_image, encoded_monitor_image, {cv::IMWRITE_JPEG_QUALITY, rate->get_quality()});
+            uint64_t encoded_ns = camera_clock::host_now_ns();
+            telemetry->monitor_encode.record(encoded_ns-encode_start_ns);
+
+            /* frame meta with stream age at send */
+            frame.meta.write_open(meta_buffer);
+            fmt::format_to(back_inserter(meta_buffer), ",\"age_ms\":{},\"monitor\":{{\"width\":{},\"height\":{},\"quality\":{}}}}}",
+                            encoded_ns>frame.timestamp_ns ? (double)(encoded_ns-frame.timestamp_ns)/1e6 : 0.0, size.width, size.height, rate->get_quality());
+
+            if(get_port(monitor_port)->handle()!=nullptr){
+                zmq::multipart_t msg_multipart_stream_monitor;
+                msg_multipart_stream_monitor.addstr(monitor_topic);
+                msg_multipart_stream_monitor.addstr(id_str);
+                msg_multipart_stream_monitor.addmem(encoded_monitor_image.data(), encoded_monitor_image.size());
+                msg_multipart_stream_monitor.addstr(meta_buffer);
+                _count_publish(telemetry, msg_multipart_stream_monitor.send(*get_port(monitor_port), ZMQ_DONTWAIT), encoded_monitor_image.size());
+            }
+
+            rate->update(encoded_ns, encoded_monitor_image.size());
+            uint64_t sent_ns = camera_clock::host_now_ns();
+            if(sent_ns>frame.timestamp_ns)
+                telemetry->monitor_age.record(sent_ns-frame.timestamp_ns);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Camera #{} monitor stream : {}", get_name(), camera_id, e.what());
+    }
+    catch(const cv::Exception& e){
+        logger::error("[{}] Camera #{} monitor stream : {}", get_name(), camera_id, e.what());
+    }
+}
+
+void basler_gige_cam_grabber::_frame_sync_task(){
+
+    string sync_port = "image_stream_sync";
+    string sync_topic = fmt::format("{}/{}", get_name(), sync_port);
+
+    try{
+        while(!_worker_stop.load()){
+            frame_set set;
+            if(!_frame_sync->pop(set, 100))
+                continue;
+
+            /* frame set header */
+            json header;
+            header["trigger"] = set.trigger_count;
+            header["timestamp_ns"] = set.timestamp_ns;
+            header["cameras"] = json::array();
+            for(const auto& frame:set.frames)
+                header["cameras"].push_back(frame.camera_id);
+            header["missing"] = set.missing;
+
+            if(!set.complete())
+                logger::debug("[{}] Frame set #{} is incomplete (missing : {} camera(s))", get_name(), set.trigger_count, set.missing.size());
+
+            if(get_port(sync_port)->handle()!=nullptr){
+                /* complete set : header + (id, image) pairs, incomplete set : header only */
+                zmq::multipart_t msg_multipart_sync;
+                msg_multipart_sync.addstr(sync_topic);
+                msg_multipart_sync.addstr(header.dump());
+                if(set.complete()){
+                    for(const auto& frame:set.frames){
+                        msg_multipart_sync.addstr(fmt::format("{}", frame.camera_id));
+                        msg_multipart_sync.addmem(frame.encoded.data(), frame.encoded.size());
+                    }
+                }
+                msg_multipart_sync.send(*get_port(sync_port), ZMQ_DONTWAIT);
+            }
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] {}", get_name(), e.what());
+    }
+    catch(const json::exception& e){
+        logger::error("[{}] Frame set header error : {}", get_name(), e.what());
+    }
+}
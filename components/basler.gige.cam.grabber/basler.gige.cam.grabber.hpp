@@ -19,6 +19,18 @@
 #include <thread>
 #include <string>
 #include <atomic>
+#include <memory>
+
+#include "frame_sync.hpp"
+#include "camera_clock.hpp"
+#include "grab_telemetry.hpp"
+#include "camera_control.hpp"
+#include "auto_exposure.hpp"
+#include "frame_recorder.hpp"
+#include "frame_meta.hpp"
+#include "frame_tap.hpp"
+#include "encode_queue.hpp"
+#include "monitor_rate.hpp"
 
 #include <pylon/PylonIncludes.h>
 #include <pylon/BaslerUniversalInstantCamera.h>
@@ -27,6 +39,16 @@ using namespace std;
 using namespace Pylon;
 using namespace GenApi;
 
+/* benchmark accumulation of a camera (measured window after warmup) */
+struct benchmark_stats {
+    uint64_t grabbed {0};           /* counters at the start of the measured window */
+    uint64_t dropped {0};
+    uint64_t grab_failed {0};
+    uint64_t publish_failed {0};
+    latency_histogram grab_to_encode;
+    latency_histogram frame_cpu;
+};
+
 class basler_gige_cam_grabber : public flame::component::object {
     public:
         basler_gige_cam_grabber() = default;
@@ -48,10 +70,56 @@ class basler_gige_cam_grabber : public flame::component::object {
         atomic<bool> _worker_stop {false};
         atomic<bool> _use_image_stream_monitoring {false};
         atomic<bool> _use_image_stream {false};
+        atomic<bool> _use_frame_sync {false};
+
+        /* for multi-camera frame set synchronization */
+        unique_ptr<frame_sync> _frame_sync;
+        thread _frame_sync_worker;
+
+        /* for frame recording (raw or jpeg into segment files) */
+        unique_ptr<frame_recorder> _recorder;
+        frame_recorder::format _record_format {frame_recorder::format::raw};
+
+        /* for archival path (jpeg encode, image_stream, jpeg recording, frame sync) off the grab threads */
+        map<int, unique_ptr<encode_queue>> _encode_queue; // (camera id, bounded frame queue)
+        unordered_map<int, thread> _encode_worker; // (camera id, thread)
+
+        /* for latest-image-only monitor stream (decoupled from the grab threads) */
+        map<int, unique_ptr<frame_tap>> _frame_tap; // (camera id, newest frame mailbox)
+        unordered_map<int, thread> _monitor_worker; // (camera id, thread)
+        map<int, unique_ptr<monitor_rate_control>> _monitor_rate; // (camera id, bandwidth budget control)
+
+        /* for runtime parameter change requests */
+        map<int, unique_ptr<camera_control>> _camera_control; // (camera id, change request mailbox)
+
+        /* for per-camera telemetry (published on status port) */
+        map<int, unique_ptr<grab_telemetry>> _telemetry; // (camera id, telemetry)
+        map<int, uint64_t> _last_grabbed; // (camera id, grabbed count at last status)
+        chrono::steady_clock::time_point _last_status_time;
+
+        /* for benchmark with emulated cameras */
+        bool _benchmark {false};
+        bool _benchmark_measuring {false};
+        bool _benchmark_reported {false};
+        chrono::steady_clock::time_point _benchmark_start;
+        chrono::steady_clock::time_point _benchmark_measure_start;
+        double _benchmark_cpu_start {0.0}; /* process cpu time (s) */
+        map<int, unique_ptr<benchmark_stats>> _benchmark_stats; // (camera id, stats)
 
     private:
         /* private task */
         void _image_stream_task(int camera_id, CBaslerUniversalInstantCamera* camera); /* image capture & flush in pipeline */ 
+        void _frame_sync_task(); /* publish synchronized frame sets */
+        void _encode_task(int camera_id); /* encode & publish, record, frame sync of every queued frame */
+        void _monitor_task(int camera_id); /* encode & publish the newest frame for monitoring */
+        bool _sync_camera_clock(CBaslerUniversalInstantCamera* camera, camera_clock& clock); /* latch camera timestamp for host clock mapping */
+        void _read_stream_statistics(CBaslerUniversalInstantCamera* camera, grab_telemetry* telemetry); /* GigE stream grabber statistics */
+        void _apply_camera_settings(int camera_id, CBaslerUniversalInstantCamera* camera, const camera_settings& settings, EGrabStrategy strategy); /* apply at frame boundary */
+        void _count_publish(grab_telemetry* telemetry, bool sent, size_t bytes);
+        void _record_command(bool enable); /* start/stop recording */
+        void _publish_status(); /* publish telemetry of all cameras */
+        void _setup_emulated_camera(int camera_id, CBaslerUniversalInstantCamera* camera); /* benchmark camera configuration */
+        void _benchmark_update(); /* start measuring after warmup, report after duration */
 
 }; /* class */
 
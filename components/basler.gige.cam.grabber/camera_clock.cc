@@ -0,0 +1,78 @@
+
+#include "camera_clock.hpp"
+#include <algorithm>
+
+camera_clock::camera_clock(double nominal_tick_ns, size_t window, uint64_t min_span_ns)
+:_nominal_tick_ns(nominal_tick_ns), _min_span_ns(min_span_ns), _samples(max(window, (size_t)2)), _slope(nominal_tick_ns){
+
+}
+
+void camera_clock::add_sample(uint64_t ticks, uint64_t host_before_ns, uint64_t host_after_ns){
+    if(host_after_ns<host_before_ns)
+        return;
+
+    sample& s = _samples[_next];
+    s.ticks = ticks;
+    s.rtt_ns = host_after_ns - host_before_ns;
+    s.host_ns = host_before_ns + s.rtt_ns/2;
+
+    _next = (_next+1)%_samples.size();
+    _n_samples = min(_n_samples+1, _samples.size());
+
+    _fit();
+}
+
+uint64_t camera_clock::to_host_ns(uint64_t ticks) const {
+    double dt = ((double)ticks - (double)_ref_ticks)*_slope + _offset;
+    return (uint64_t)((int64_t)_ref_host + (int64_t)dt);
+}
+
+void camera_clock::_fit(){
+
+    /* accept only samples with short round-trip (latch command not delayed) */
+    uint64_t min_rtt = UINT64_MAX;
+    for(size_t i=0;i<_n_samples;i++)
+        min_rtt = min(min_rtt, _samples[i].rtt_ns);
+    uint64_t max_rtt = min_rtt*2;
+
+    const sample* latest = nullptr;
+    uint64_t host_min = UINT64_MAX, host_max = 0;
+    size_t n = 0;
+    for(size_t i=0;i<_n_samples;i++){
+        const sample& s = _samples[i];
+        if(s.rtt_ns>max_rtt) continue;
+        if(!latest || s.host_ns>latest->host_ns) latest = &s;
+        host_min = min(host_min, s.host_ns);
+        host_max = max(host_max, s.host_ns);
+        n++;
+    }
+
+    _ref_ticks = latest->ticks;
+    _ref_host = latest->host_ns;
+    _uncertainty_ns = min_rtt/2;
+
+    /* not enough time span to estimate drift, use nominal tick period through the latest sample */
+    if(n<2 || host_max-host_min<_min_span_ns){
+        _slope = _nominal_tick_ns;
+        _offset = 0.0;
+        return;
+    }
+
+    /* least square fit (relative to the latest sample) */
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for(size_t i=0;i<_n_samples;i++){
+        const sample& s = _samples[i];
+        if(s.rtt_ns>max_rtt) continue;
+        double x = (double)s.ticks - (double)_ref_ticks;
+        double y = (double)((int64_t)s.host_ns - (int64_t)_ref_host);
+        sx += x; sy += y; sxx += x*x; sxy += x*y;
+    }
+    double denom = (double)n*sxx - sx*sx;
+    if(denom<=0.0){
+        _slope = _nominal_tick_ns;
+        _offset = 0.0;
+        return;
+    }
+    _slope = ((double)n*sxy - sx*sy)/denom;
+    _offset = (sy - _slope*sx)/(double)n;
+}
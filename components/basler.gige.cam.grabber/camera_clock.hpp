@@ -0,0 +1,73 @@
+/**
+ * @file camera_clock.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Camera timestamp tick to host monotonic clock mapping
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_CAMERA_CLOCK_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_CAMERA_CLOCK_HPP_INCLUDED
+
+#include <vector>
+#include <cstdint>
+#include <chrono>
+
+using namespace std;
+
+/**
+ * @brief linear mapping (host_ns = offset + slope*ticks) estimated from latched camera timestamps.
+ * each sample is a camera timestamp latched between two host clock reads. samples with large round-trip time
+ * are ignored, and the slope(clock drift) is fitted only when the samples span enough time.
+ * not thread-safe, owned by the camera grab thread.
+ */
+class camera_clock {
+    public:
+        camera_clock(double nominal_tick_ns = 1.0, size_t window = 32, uint64_t min_span_ns = 2000000000ULL);
+        ~camera_clock() = default;
+
+        /* add a latched camera timestamp with host time before/after the latch command */
+        void add_sample(uint64_t ticks, uint64_t host_before_ns, uint64_t host_after_ns);
+
+        /* true if at least one sample is available */
+        bool valid() const { return _n_samples>0; }
+
+        /* convert camera ticks to host monotonic time (ns) */
+        uint64_t to_host_ns(uint64_t ticks) const;
+
+        /* host monotonic clock (CLOCK_MONOTONIC on linux) in ns */
+        static uint64_t host_now_ns() { return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count(); }
+
+        double get_tick_ns() const { return _slope; }
+        double get_drift_ppm() const { return (_slope/_nominal_tick_ns - 1.0)*1e6; }
+        uint64_t get_uncertainty_ns() const { return _uncertainty_ns; } /* half round-trip of the best sample in window */
+
+    private:
+        void _fit();
+
+    private:
+        struct sample {
+            uint64_t ticks {0};
+            uint64_t host_ns {0};   /* midpoint of the latch command */
+            uint64_t rtt_ns {0};
+        };
+
+        double _nominal_tick_ns {1.0};
+        uint64_t _min_span_ns {0};
+        vector<sample> _samples;    /* ring buffer */
+        size_t _next {0};
+        size_t _n_samples {0};
+
+        /* fitted model : host_ns = _ref_host + (ticks-_ref_ticks)*_slope + _offset */
+        uint64_t _ref_ticks {0};
+        uint64_t _ref_host {0};
+        double _slope {1.0};
+        double _offset {0.0};
+        uint64_t _uncertainty_ns {0};
+
+}; /* class */
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file camera_control.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Runtime camera parameter change requests (applied by the camera grab thread between grabs)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_CAMERA_CONTROL_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_CAMERA_CONTROL_HPP_INCLUDED
+
+#include <optional>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+/* region of interest */
+struct camera_roi {
+    int x {0};
+    int y {0};
+    int width {0};
+    int height {0};
+};
+
+/* batch of parameter changes (only set fields are changed) */
+struct camera_settings {
+    optional<double> exposure_time;     /* us */
+    optional<double> gain;              /* dB */
+    optional<double> frame_rate;        /* fps, 0 to disable frame rate limit */
+    optional<camera_roi> roi;
+    optional<bool> auto_exposure;           /* software auto exposure on/off */
+    optional<camera_roi> auto_exposure_roi; /* region weighted by auto exposure (zero size to clear) */
+
+    /* newer request overrides the fields of older one */
+    void merge(const camera_settings& other){
+        if(other.exposure_time) exposure_time = other.exposure_time;
+        if(other.gain) gain = other.gain;
+        if(other.frame_rate) frame_rate = other.frame_rate;
+        if(other.roi) roi = other.roi;
+        if(other.auto_exposure) auto_exposure = other.auto_exposure;
+        if(other.auto_exposure_roi) auto_exposure_roi = other.auto_exposure_roi;
+    }
+
+    bool empty() const { return !exposure_time && !gain && !frame_rate && !roi && !auto_exposure && !auto_exposure_roi; }
+};
+
+/**
+ * @brief change request mailbox of a camera.
+ * post() can be called from any thread, take() is called by the camera grab thread at every frame boundary
+ * and costs only an atomic load when nothing is pending.
+ */
+class camera_control {
+    public:
+        void post(const camera_settings& settings){
+            if(settings.empty())
+                return;
+            lock_guard<mutex> lock(_mutex);
+            _pending.merge(settings);
+            _has_pending.store(true, memory_order_release);
+        }
+
+        bool take(camera_settings& settings){
+            if(!_has_pending.load(memory_order_acquire))
+                return false;
+            lock_guard<mutex> lock(_mutex);
+            settings = _pending;
+            _pending = camera_settings();
+            _has_pending.store(false, memory_order_release);
+            return !settings.empty();
+        }
+
+    private:
+        mutex _mutex;
+        camera_settings _pending;
+        atomic<bool> _has_pending {false};
+
+}; /* class */
+
+#endif
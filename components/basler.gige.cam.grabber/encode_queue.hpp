@@ -0,0 +1,113 @@
+/**
+ * @file encode_queue.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Bounded frame queue from a grab thread to its encode worker (archival path : jpeg encode, publish, record, frame sync)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_ENCODE_QUEUE_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_ENCODE_QUEUE_HPP_INCLUDED
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "frame_meta.hpp"
+
+using namespace std;
+
+/* a frame waiting for encoding (8bit, packed rows) */
+struct queued_frame {
+    vector<uint8_t> image;
+    int width {0};
+    int height {0};
+    uint64_t grab_ns {0};       /* host time of retrieve */
+    bool record {false};        /* recording (jpeg) was on when grabbed */
+    frame_meta meta;
+};
+
+/**
+ * @brief fixed ring of frame slots (FIFO).
+ * push() copies the frame into the next slot, or drops it if every slot is still waiting, so the grab thread never blocks.
+ * pop() swaps the oldest slot with the caller's frame, so buffers circulate between the ring and the worker without allocation.
+ */
+class encode_queue {
+    public:
+        explicit encode_queue(size_t capacity):_slots(max<size_t>(capacity, 1)){}
+
+        /* false if the queue is full (frame dropped) */
+        bool push(const uint8_t* image, int width, int height, size_t stride, uint64_t grab_ns, bool record, const frame_meta& meta){
+            {
+                lock_guard<mutex> lock(_mutex);
+                if(_count==_slots.size()){
+                    _n_dropped.fetch_add(1, memory_order_relaxed);
+                    return false;
+                }
+                queued_frame& slot = _slots[(_head+_count)%_slots.size()];
+                slot.image.resize((size_t)width*height);
+                for(int y=0;y<height;y++)
+                    memcpy(slot.image.data()+(size_t)y*width, image+(size_t)y*stride, (size_t)width);
+                slot.width = width;
+                slot.height = height;
+                slot.grab_ns = grab_ns;
+                slot.record = record;
+                slot.meta = meta;
+                _count++;
+                _depth_max = max(_depth_max, _count);
+            }
+            _cv.notify_one();
+            return true;
+        }
+
+        /* wait for a frame up to wait_ms, return false if nothing is queued (or stopped) */
+        bool pop(queued_frame& frame, unsigned int wait_ms){
+            unique_lock<mutex> lock(_mutex);
+            if(!_cv.wait_for(lock, chrono::milliseconds(wait_ms), [&]{ return _count>0 || _stop; }) || _count==0)
+                return false;
+            swap(frame, _slots[_head]);
+            _head = (_head+1)%_slots.size();
+            _count--;
+            return true;
+        }
+
+        void stop(){
+            {
+                lock_guard<mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+        }
+
+        /* frames not queued because the worker was behind by the whole capacity */
+        uint64_t get_dropped_count() const { return _n_dropped.load(memory_order_relaxed); }
+
+        /* max number of waiting frames since the last call */
+        size_t take_depth_max(){
+            lock_guard<mutex> lock(_mutex);
+            size_t depth = _depth_max;
+            _depth_max = _count;
+            return depth;
+        }
+
+    private:
+        mutex _mutex;
+        condition_variable _cv;
+        vector<queued_frame> _slots;
+        size_t _head {0};
+        size_t _count {0};
+        size_t _depth_max {0};
+        bool _stop {false};
+        atomic<uint64_t> _n_dropped {0};
+
+}; /* class */
+
+#endif
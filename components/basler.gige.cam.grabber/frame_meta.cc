@@ -0,0 +1,19 @@
+
+#include "frame_meta.hpp"
+#include <fmt/format.h>
+#include <iterator>
+
+void frame_meta::write(string& out) const {
+    write_open(out);
+    out.push_back('}');
+}
+
+void frame_meta::write_open(string& out) const {
+    out.clear();
+    auto it = back_inserter(out);
+    fmt::format_to(it, "{{\"frame_id\":{},\"trigger\":{},\"timestamp_ns\":{},\"exposure_us\":{},\"gain_db\":{}",
+                    frame_id, trigger, timestamp_ns, exposure_us, gain_db);
+    if(luminance>=0.0)
+        fmt::format_to(it, ",\"luminance\":{}", luminance);
+    fmt::format_to(it, ",\"host_clock\":{},\"clock_uncertainty_ns\":{}", host_clock, clock_uncertainty_ns);
+}
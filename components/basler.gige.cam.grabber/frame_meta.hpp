@@ -0,0 +1,38 @@
+/**
+ * @file frame_meta.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Per-frame meta (filled by the grab thread, serialized to json without heap allocation)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_META_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_META_HPP_INCLUDED
+
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+/* frame meta published with every image (plain values, copied by value between threads) */
+struct frame_meta {
+    uint64_t frame_id {0};
+    uint64_t trigger {0};               /* raw trigger counter of the camera */
+    uint64_t timestamp_ns {0};          /* exposure midpoint in host monotonic clock */
+    double exposure_us {0.0};
+    double gain_db {0.0};
+    double luminance {-1.0};            /* mean luminance of the auto exposure (<0 : auto exposure off, not serialized) */
+    bool host_clock {false};            /* timestamp is mapped to the host clock */
+    uint64_t clock_uncertainty_ns {0};
+
+    /* json object into out. out is cleared, not shrunk : a reused string stops allocating once it has grown */
+    void write(string& out) const;
+
+    /* same without the closing brace, for callers appending their own fields (",\"key\":value" ... "}") */
+    void write_open(string& out) const;
+};
+
+#endif
@@ -0,0 +1,300 @@
+
+#include "frame_recorder.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+namespace fs = std::filesystem;
+
+static size_t align_up(size_t size, size_t align){
+    return (size + align - 1)/align*align;
+}
+
+static uint64_t now_ns(){
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+frame_recorder::frame_recorder(const config& conf)
+:_config(conf){
+
+    _config.slot_size = align_up(max(_config.slot_size, sizeof(frame_record_header)+1), io_align);
+    _config.segment_size = align_up(max(_config.segment_size, _config.slot_size), io_align);
+    _config.n_slots = max(_config.n_slots, (size_t)2);
+    _config.max_batch = clamp(_config.max_batch, (size_t)1, (size_t)64);
+
+    /* slots are touched once here, so the grab threads never page-fault on them */
+    _buffer = static_cast<uint8_t*>(aligned_alloc(io_align, _config.slot_size*_config.n_slots));
+    if(_buffer)
+        memset(_buffer, 0, _config.slot_size*_config.n_slots);
+    else
+        _config.n_slots = 0;
+
+    _record_size.assign(_config.n_slots, 0);
+    _free.reserve(_config.n_slots);
+    for(size_t i=_config.n_slots;i>0;i--)
+        _free.push_back(i-1);
+    _free_min = _free.size();
+}
+
+frame_recorder::~frame_recorder(){
+    stop();
+    free(_buffer);
+}
+
+bool frame_recorder::start(){
+    if(is_recording() || _buffer==nullptr)
+        return is_recording();
+
+    /* session directory named by local start time */
+    time_t t = time(nullptr);
+    tm local {};
+    localtime_r(&t, &local);
+    char name[32];
+    strftime(name, sizeof(name), "%Y%m%d_%H%M%S", &local);
+
+    /* a new directory for every session (a restart within the same second gets a suffix, never reuses one) */
+    error_code ec;
+    fs::create_directories(_config.path, ec);
+    if(ec)
+        return false;
+    fs::path session = fs::path(_config.path)/name;
+    for(int suffix=1;!fs::create_directory(session, ec);suffix++){
+        if(ec || suffix>=100)
+            return false;
+        session = fs::path(_config.path)/(string(name)+"_"+to_string(suffix));
+    }
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        _session_path = session.string();
+        /* a frame queued after the previous session was drained does not belong to this one */
+        while(!_ready.empty()){
+            _free.push_back(_ready.front());
+            _ready.pop_front();
+        }
+    }
+    _segment_seq = 0;
+    _segments.clear();
+    _stop.store(false);
+    _recording.store(true, memory_order_release);
+    _writer = thread(&frame_recorder::_writer_task, this);
+    return true;
+}
+
+void frame_recorder::stop(){
+    _recording.store(false, memory_order_release);
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stop.store(true);
+    }
+    _cv.notify_all();
+    if(_writer.joinable())
+        _writer.join();
+}
+
+bool frame_recorder::push(int camera_id, format fmt, int width, int height, uint64_t frame_id, uint64_t timestamp_ns, const void* data, size_t size){
+    if(!is_recording())
+        return false;
+
+    size_t record_size = align_up(sizeof(frame_record_header)+size, io_align);
+    if(record_size>_config.slot_size){
+        _n_dropped.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    size_t slot = 0;
+    {
+        lock_guard<mutex> lock(_mutex);
+        if(_free.empty()){
+            _n_dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        slot = _free.back();
+        _free.pop_back();
+        _free_min = min(_free_min, _free.size());
+    }
+
+    /* fill the slot outside of the lock */
+    uint8_t* p = _buffer + slot*_config.slot_size;
+    frame_record_header header;
+    header.format = static_cast<uint16_t>(fmt);
+    header.camera_id = (uint32_t)camera_id;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.payload_size = (uint32_t)size;
+    header.frame_id = frame_id;
+    header.timestamp_ns = timestamp_ns;
+    memcpy(p, &header, sizeof(header));
+    memcpy(p+sizeof(header), data, size);
+    memset(p+sizeof(header)+size, 0, record_size-sizeof(header)-size);
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        /* stop() may have come after the is_recording() check, the writer is then draining or gone */
+        if(_stop.load()){
+            _free.push_back(slot);
+            return false;
+        }
+        _record_size[slot] = record_size;
+        _ready.push_back(slot);
+    }
+    _cv.notify_one();
+    return true;
+}
+
+size_t frame_recorder::get_free_slots_min(){
+    lock_guard<mutex> lock(_mutex);
+    size_t free_min = _free_min;
+    _free_min = _free.size();
+    return free_min;
+}
+
+string frame_recorder::get_session_path() const {
+    lock_guard<mutex> lock(_mutex);
+    return _session_path;
+}
+
+void frame_recorder::_writer_task(){
+    vector<size_t> batch;
+    batch.reserve(_config.max_batch);
+
+    while(true){
+        {
+            unique_lock<mutex> lock(_mutex);
+            _cv.wait(lock, [&]{ return !_ready.empty() || _stop.load(); });
+            if(_ready.empty())
+                break; /* stopped & drained */
+
+            batch.clear();
+            while(!_ready.empty() && batch.size()<_config.max_batch){
+                batch.push_back(_ready.front());
+                _ready.pop_front();
+            }
+        }
+
+        _write_batch(batch);
+
+        {
+            lock_guard<mutex> lock(_mutex);
+            for(size_t slot:batch)
+                _free.push_back(slot);
+        }
+    }
+
+    _close_segment();
+}
+
+void frame_recorder::_write_batch(const vector<size_t>& slots){
+    uint64_t start_ns = now_ns();
+
+    iovec iov[64];
+    frame_index_entry entries[64];
+
+    size_t i = 0;
+    while(i<slots.size()){
+        /* rotate if the next record does not fit into the current segment */
+        if(_fd<0 || _segment_offset+_record_size[slots[i]]>_config.segment_size){
+            _close_segment();
+            if(!_open_segment()){
+                _n_write_errors.fetch_add(slots.size()-i, memory_order_relaxed);
+                return;
+            }
+        }
+
+        /* contiguous records fitting in this segment are written at once */
+        size_t n = 0;
+        size_t bytes = 0;
+        while(i+n<slots.size() && _segment_offset+bytes+_record_size[slots[i+n]]<=_config.segment_size){
+            size_t slot = slots[i+n];
+            const frame_record_header* header = reinterpret_cast<const frame_record_header*>(_buffer + slot*_config.slot_size);
+            iov[n].iov_base = _buffer + slot*_config.slot_size;
+            iov[n].iov_len = _record_size[slot];
+            entries[n].frame_id = header->frame_id;
+            entries[n].timestamp_ns = header->timestamp_ns;
+            entries[n].offset = _segment_offset + bytes;
+            entries[n].camera_id = header->camera_id;
+            entries[n].size = (uint32_t)_record_size[slot];
+            bytes += _record_size[slot];
+            n++;
+        }
+
+        ssize_t written = pwritev(_fd, iov, (int)n, (off_t)_segment_offset);
+        if(written!=(ssize_t)bytes){
+            /* short write leaves the segment in an unknown state, continue on a new one */
+            _n_write_errors.fetch_add(n, memory_order_relaxed);
+            _close_segment();
+        }
+        else{
+            _segment_offset += bytes;
+            if(::write(_index_fd, entries, n*sizeof(frame_index_entry))!=(ssize_t)(n*sizeof(frame_index_entry)))
+                _n_write_errors.fetch_add(1, memory_order_relaxed);
+            _n_recorded.fetch_add(n, memory_order_relaxed);
+            _n_bytes.fetch_add(bytes, memory_order_relaxed);
+        }
+        i += n;
+    }
+
+    _write_latency.record(now_ns()-start_ns);
+}
+
+bool frame_recorder::_open_segment(){
+    char name[64];
+    snprintf(name, sizeof(name), "%s_%06zu", _config.prefix.c_str(), _segment_seq);
+    string base = (fs::path(_session_path)/name).string();
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    _fd = -1;
+    if(_config.direct_io)
+        _fd = ::open((base+".seg").c_str(), flags | O_DIRECT, 0644);
+    if(_fd<0) /* direct I/O is not supported by the filesystem (e.g. tmpfs) */
+        _fd = ::open((base+".seg").c_str(), flags, 0644);
+    if(_fd<0)
+        return false;
+
+    /* preallocate whole segment (no block allocation while recording) */
+    if(fallocate(_fd, 0, 0, (off_t)_config.segment_size)!=0)
+        posix_fallocate(_fd, 0, (off_t)_config.segment_size);
+
+    _index_fd = ::open((base+".idx").c_str(), flags | O_APPEND, 0644);
+    if(_index_fd<0){
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    _segment_offset = 0;
+    _segments.push_back(_segment_seq++);
+    _n_segments.fetch_add(1, memory_order_relaxed);
+
+    /* retention */
+    while(_config.max_segments>0 && _segments.size()>_config.max_segments){
+        snprintf(name, sizeof(name), "%s_%06zu", _config.prefix.c_str(), _segments.front());
+        string old = (fs::path(_session_path)/name).string();
+        ::unlink((old+".seg").c_str());
+        ::unlink((old+".idx").c_str());
+        _segments.pop_front();
+    }
+    return true;
+}
+
+void frame_recorder::_close_segment(){
+    if(_fd>=0){
+        /* trim unused preallocation */
+        if(ftruncate(_fd, (off_t)_segment_offset)!=0)
+            _n_write_errors.fetch_add(1, memory_order_relaxed);
+        fdatasync(_fd);
+        ::close(_fd);
+        _fd = -1;
+    }
+    if(_index_fd>=0){
+        fdatasync(_index_fd);
+        ::close(_index_fd);
+        _index_fd = -1;
+    }
+}
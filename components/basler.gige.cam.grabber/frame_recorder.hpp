@@ -0,0 +1,137 @@
+/**
+ * @file frame_recorder.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Raw/encoded frame recorder into preallocated segment files (direct I/O, indexed, rotated)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_RECORDER_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_RECORDER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "grab_telemetry.hpp"
+
+using namespace std;
+
+/* frame record in a segment file : header + payload, padded to io alignment */
+struct frame_record_header {
+    uint32_t magic {0x304d5246};    /* "FRM0" */
+    uint16_t version {1};
+    uint16_t format {0};            /* 0 : raw, 1 : jpeg */
+    uint32_t camera_id {0};
+    uint32_t width {0};
+    uint32_t height {0};
+    uint32_t payload_size {0};      /* bytes (without padding) */
+    uint64_t frame_id {0};
+    uint64_t timestamp_ns {0};      /* host monotonic clock */
+    uint8_t reserved[24] {};
+};
+static_assert(sizeof(frame_record_header)==64, "frame record header must be 64 bytes");
+
+/* index entry (one per record, in <segment>.idx) */
+struct frame_index_entry {
+    uint64_t frame_id {0};
+    uint64_t timestamp_ns {0};
+    uint64_t offset {0};            /* record offset in the segment file */
+    uint32_t camera_id {0};
+    uint32_t size {0};              /* record size (with header & padding) */
+};
+static_assert(sizeof(frame_index_entry)==32, "frame index entry must be 32 bytes");
+
+/**
+ * @brief frame recorder.
+ * push() copies a frame into a preallocated aligned slot and returns immediately (dropped if no slot is free),
+ * the writer thread writes ready slots in batches (pwritev) into a preallocated segment file opened with O_DIRECT,
+ * and rotates to the next segment when the current one is full.
+ */
+class frame_recorder {
+    public:
+        enum class format : uint16_t { raw = 0, jpeg = 1 };
+
+        static constexpr size_t io_align = 4096; /* direct I/O alignment (offset, size, memory) */
+
+        struct config {
+            string path {"./record"};           /* a session directory (start time) is created under this path */
+            string prefix {"frames"};
+            size_t segment_size {1ull<<30};     /* bytes, preallocated */
+            size_t slot_size {4ull<<20};        /* max record size (header + frame) */
+            size_t n_slots {128};
+            size_t max_batch {16};              /* max records per write */
+            size_t max_segments {0};            /* oldest segments are removed over this (0 : unlimited) */
+            bool direct_io {true};
+        };
+
+        frame_recorder(const config& conf);
+        ~frame_recorder();
+
+        /* start a new recording session, return false if the session directory cannot be created */
+        bool start();
+
+        /* write all queued frames and close the segment */
+        void stop();
+
+        bool is_recording() const { return _recording.load(memory_order_acquire); }
+
+        /* queue a frame (called from camera grab threads, never blocks on disk) */
+        bool push(int camera_id, format fmt, int width, int height, uint64_t frame_id, uint64_t timestamp_ns, const void* data, size_t size);
+
+        /* statistics */
+        uint64_t get_recorded_count() const { return _n_recorded.load(memory_order_relaxed); }
+        uint64_t get_dropped_count() const { return _n_dropped.load(memory_order_relaxed); }
+        uint64_t get_written_bytes() const { return _n_bytes.load(memory_order_relaxed); }
+        uint64_t get_write_error_count() const { return _n_write_errors.load(memory_order_relaxed); }
+        uint64_t get_segment_count() const { return _n_segments.load(memory_order_relaxed); }
+        size_t get_free_slots_min(); /* min free slots since the last call */
+        latency_histogram& get_write_latency() { return _write_latency; }
+        string get_session_path() const;
+
+    private:
+        void _writer_task();
+        bool _open_segment(); /* (writer thread) */
+        void _close_segment(); /* (writer thread) */
+        void _write_batch(const vector<size_t>& slots); /* (writer thread) */
+
+    private:
+        config _config;
+
+        /* preallocated aligned slots */
+        uint8_t* _buffer {nullptr};
+        vector<size_t> _record_size; /* record size of each slot */
+        vector<size_t> _free;        /* free slot indices */
+        deque<size_t> _ready;        /* slots waiting for write (in push order) */
+        size_t _free_min {0};
+        mutable mutex _mutex;
+        condition_variable _cv;
+
+        /* writer */
+        thread _writer;
+        atomic<bool> _recording {false};
+        atomic<bool> _stop {false};
+        string _session_path;
+        int _fd {-1};
+        int _index_fd {-1};
+        size_t _segment_seq {0};
+        size_t _segment_offset {0};
+        deque<size_t> _segments; /* sequence numbers of segments on disk */
+
+        atomic<uint64_t> _n_recorded {0};
+        atomic<uint64_t> _n_dropped {0};
+        atomic<uint64_t> _n_bytes {0};
+        atomic<uint64_t> _n_write_errors {0};
+        atomic<uint64_t> _n_segments {0};
+        latency_histogram _write_latency;
+
+}; /* class */
+
+#endif
@@ -0,0 +1,123 @@
+
+#include "frame_sync.hpp"
+#include <algorithm>
+
+frame_sync::frame_sync(const vector<int>& camera_ids, uint64_t tolerance_ns, unsigned int timeout_ms, size_t max_pending)
+:_camera_ids(camera_ids), _tolerance_ns(tolerance_ns), _timeout(timeout_ms), _max_pending(max(max_pending, (size_t)1)){
+    sort(_camera_ids.begin(), _camera_ids.end());
+    for(int id:_camera_ids)
+        _trigger_offset[id] = 0;
+}
+
+void frame_sync::push(grabbed_frame&& frame){
+
+    lock_guard<mutex> lock(_mutex);
+    if(_stop || !_trigger_offset.contains(frame.camera_id))
+        return;
+
+    uint64_t trigger = (uint64_t)((int64_t)frame.trigger_count + _trigger_offset[frame.camera_id]);
+    auto it = _pending.find(trigger);
+    bool matched = (it!=_pending.end()) && !it->second.frames.contains(frame.camera_id) && _within_tolerance(it->second.ref_timestamp_ns, frame.timestamp_ns);
+
+    /* trigger counter is not aligned with the others (missed trigger or counter not reset), realign by timestamp */
+    if(!matched){
+        for(auto p=_pending.begin(); p!=_pending.end(); ++p){
+            if(!p->second.frames.contains(frame.camera_id) && _within_tolerance(p->second.ref_timestamp_ns, frame.timestamp_ns)){
+                _trigger_offset[frame.camera_id] = (int64_t)p->first - (int64_t)frame.trigger_count;
+                _n_realigned++;
+                trigger = p->first;
+                it = p;
+                matched = true;
+                break;
+            }
+        }
+    }
+
+    /* new trigger */
+    if(!matched){
+        if(it!=_pending.end()){ // same trigger count, but timestamp is out of tolerance
+            _n_rejected++;
+            return;
+        }
+        if(_pending.size()>=_max_pending)
+            _expire(true);
+        it = _pending.emplace(trigger, slot{frame.timestamp_ns, chrono::steady_clock::now(), {}}).first;
+    }
+
+    int camera_id = frame.camera_id;
+    it->second.frames.emplace(camera_id, std::move(frame));
+    if(it->second.frames.size()==_camera_ids.size()){
+        _release(it);
+        _cv.notify_one();
+    }
+}
+
+bool frame_sync::pop(frame_set& set, unsigned int wait_ms){
+
+    unique_lock<mutex> lock(_mutex);
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(wait_ms);
+
+    while(true){
+        _expire(false);
+
+        if(!_ready.empty()){
+            set = std::move(_ready.front());
+            _ready.pop_front();
+            return true;
+        }
+
+        auto now = chrono::steady_clock::now();
+        if(_stop || now>=deadline)
+            return false;
+
+        /* wake up at the deadline or when the oldest pending slot expires */
+        auto wakeup = deadline;
+        for(const auto& p:_pending)
+            wakeup = min(wakeup, p.second.created + _timeout);
+        _cv.wait_until(lock, wakeup);
+    }
+}
+
+void frame_sync::stop(){
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+}
+
+bool frame_sync::_within_tolerance(uint64_t a, uint64_t b) const {
+    return (a>b ? a-b : b-a) <= _tolerance_ns;
+}
+
+void frame_sync::_expire(bool force_oldest){
+    if(force_oldest && !_pending.empty())
+        _release(_pending.begin());
+
+    auto now = chrono::steady_clock::now();
+    for(auto it=_pending.begin(); it!=_pending.end();){
+        auto next = std::next(it);
+        if(now - it->second.created >= _timeout)
+            _release(it);
+        it = next;
+    }
+}
+
+void frame_sync::_release(map<uint64_t, slot>::iterator it){
+    frame_set set;
+    set.trigger_count = it->first;
+    set.timestamp_ns = it->second.ref_timestamp_ns;
+    for(int id:_camera_ids){
+        auto f = it->second.frames.find(id);
+        if(f!=it->second.frames.end())
+            set.frames.emplace_back(std::move(f->second));
+        else
+            set.missing.emplace_back(id);
+    }
+
+    if(set.complete()) _n_complete++;
+    else _n_incomplete++;
+
+    _ready.emplace_back(std::move(set));
+    _pending.erase(it);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file frame_sync.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Multi-camera frame set synchronizer (match frames of the same hardware trigger)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_SYNC_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_SYNC_HPP_INCLUDED
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+/* a frame from one camera, pushed by the camera grab thread */
+struct grabbed_frame {
+    int camera_id {0};
+    uint64_t trigger_count {0};     /* raw trigger counter of the camera (chunk counter or block id) */
+    uint64_t timestamp_ns {0};      /* camera timestamp (ns) */
+    vector<unsigned char> encoded;  /* encoded image */
+};
+
+/* frames of all cameras for the same trigger */
+struct frame_set {
+    uint64_t trigger_count {0};     /* common (aligned) trigger count */
+    uint64_t timestamp_ns {0};      /* timestamp of the first arrived frame */
+    vector<grabbed_frame> frames;   /* ordered by camera id */
+    vector<int> missing;            /* camera ids which did not arrive in time (empty if complete) */
+
+    bool complete() const { return missing.empty(); }
+};
+
+class frame_sync {
+    public:
+        frame_sync(const vector<int>& camera_ids, uint64_t tolerance_ns, unsigned int timeout_ms, size_t max_pending);
+        ~frame_sync() = default;
+
+        /* push a grabbed frame (called from camera grab threads) */
+        void push(grabbed_frame&& frame);
+
+        /* pop a complete or expired frame set, wait up to wait_ms. return false if nothing is ready */
+        bool pop(frame_set& set, unsigned int wait_ms);
+
+        /* wake up all waiting consumers */
+        void stop();
+
+        /* statistics */
+        uint64_t get_complete_count() const { return _n_complete.load(); }
+        uint64_t get_incomplete_count() const { return _n_incomplete.load(); }
+        uint64_t get_rejected_count() const { return _n_rejected.load(); }
+        uint64_t get_realigned_count() const { return _n_realigned.load(); }
+
+    private:
+        struct slot {
+            uint64_t ref_timestamp_ns {0};
+            chrono::steady_clock::time_point created;
+            map<int, grabbed_frame> frames; // (camera id, frame)
+        };
+
+        bool _within_tolerance(uint64_t a, uint64_t b) const;
+        void _expire(bool force_oldest); /* move timed-out pending slots into ready queue (lock must be held) */
+        void _release(map<uint64_t, slot>::iterator it); /* (lock must be held) */
+
+    private:
+        vector<int> _camera_ids;
+        uint64_t _tolerance_ns {1000000};
+        chrono::milliseconds _timeout {200};
+        size_t _max_pending {16};
+
+        map<int, int64_t> _trigger_offset;  // (camera id, offset to the common trigger count)
+        map<uint64_t, slot> _pending;       // (common trigger count, slot)
+        deque<frame_set> _ready;
+
+        mutex _mutex;
+        condition_variable _cv;
+        bool _stop {false};
+
+        atomic<uint64_t> _n_complete {0};
+        atomic<uint64_t> _n_incomplete {0};
+        atomic<uint64_t> _n_rejected {0};
+        atomic<uint64_t> _n_realigned {0};
+
+}; /* class */
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file frame_tap.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Latest-image-only frame tap (grab thread -> monitor thread, older frames are overwritten)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_TAP_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_FRAME_TAP_HPP_INCLUDED
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+#include "frame_meta.hpp"
+
+using namespace std;
+
+/* a tapped frame (8bit, packed rows) */
+struct tapped_frame {
+    vector<uint8_t> image;
+    int width {0};
+    int height {0};
+    uint64_t timestamp_ns {0};  /* exposure midpoint in host monotonic clock */
+    frame_meta meta;
+};
+
+/**
+ * @brief single slot mailbox of the newest frame.
+ * put() copies the frame into the slot (overwriting an unconsumed one), take() swaps the slot with the caller's frame,
+ * so buffers are reused and the consumer never sees a frame older than the newest grabbed one.
+ */
+class frame_tap {
+    public:
+        void put(const uint8_t* image, int width, int height, size_t stride, uint64_t timestamp_ns, const frame_meta& meta){
+            {
+                lock_guard<mutex> lock(_mutex);
+                if(_ready)
+                    _n_overwritten.fetch_add(1, memory_order_relaxed);
+                _slot.image.resize((size_t)width*height);
+                for(int y=0;y<height;y++)
+                    memcpy(_slot.image.data()+(size_t)y*width, image+(size_t)y*stride, (size_t)width);
+                _slot.width = width;
+                _slot.height = height;
+                _slot.timestamp_ns = timestamp_ns;
+                _slot.meta = meta;
+                _ready = true;
+            }
+            _cv.notify_one();
+        }
+
+        /* wait for a new frame up to wait_ms, return false if nothing new (or stopped) */
+        bool take(tapped_frame& frame, unsigned int wait_ms){
+            unique_lock<mutex> lock(_mutex);
+            if(!_cv.wait_for(lock, chrono::milliseconds(wait_ms), [&]{ return _ready || _stop; }) || !_ready)
+                return false;
+            swap(frame, _slot);
+            _ready = false;
+            return true;
+        }
+
+        void stop(){
+            {
+                lock_guard<mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_all();
+        }
+
+        /* frames replaced before the consumer took them */
+        uint64_t get_overwritten_count() const { return _n_overwritten.load(memory_order_relaxed); }
+
+    private:
+        mutex _mutex;
+        condition_variable _cv;
+        tapped_frame _slot;
+        bool _ready {false};
+        bool _stop {false};
+        atomic<uint64_t> _n_overwritten {0};
+
+}; /* class */
+
+#endif
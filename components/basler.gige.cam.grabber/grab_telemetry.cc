@@ -0,0 +1,77 @@
+
+#include "grab_telemetry.hpp"
+#include <bit>
+#include <algorithm>
+
+void latency_histogram::record(uint64_t ns){
+    _buckets[_index(ns/1000)].fetch_add(1, memory_order_relaxed);
+    _count.fetch_add(1, memory_order_relaxed);
+    _sum_ns.fetch_add(ns, memory_order_relaxed);
+
+    uint64_t prev = _max_ns.load(memory_order_relaxed);
+    while(ns>prev && !_max_ns.compare_exchange_weak(prev, ns, memory_order_relaxed));
+}
+
+latency_histogram::summary latency_histogram::take(latency_histogram* total_histogram){
+    summary s;
+
+    array<uint64_t, n_buckets> buckets;
+    uint64_t total = 0;
+    for(size_t i=0;i<n_buckets;i++){
+        buckets[i] = _buckets[i].exchange(0, memory_order_relaxed);
+        total += buckets[i];
+    }
+    s.count = _count.exchange(0, memory_order_relaxed);
+    uint64_t sum_ns = _sum_ns.exchange(0, memory_order_relaxed);
+    uint64_t max_ns = _max_ns.exchange(0, memory_order_relaxed);
+    if(total==0 || s.count==0)
+        return s;
+
+    if(total_histogram){
+        for(size_t i=0;i<n_buckets;i++)
+            total_histogram->_buckets[i].fetch_add(buckets[i], memory_order_relaxed);
+        total_histogram->_count.fetch_add(s.count, memory_order_relaxed);
+        total_histogram->_sum_ns.fetch_add(sum_ns, memory_order_relaxed);
+        uint64_t prev = total_histogram->_max_ns.load(memory_order_relaxed);
+        while(max_ns>prev && !total_histogram->_max_ns.compare_exchange_weak(prev, max_ns, memory_order_relaxed));
+    }
+
+    s.mean_us = (double)sum_ns/(double)s.count/1000.0;
+    s.max_us = (double)max_ns/1000.0;
+
+    /* percentile as the upper bound of the bucket (not beyond max) */
+    auto percentile = [&](double p){
+        uint64_t rank = max((uint64_t)1, (uint64_t)(p*(double)total + 0.5));
+        uint64_t acc = 0;
+        for(size_t i=0;i<n_buckets;i++){
+            acc += buckets[i];
+            if(acc>=rank)
+                return min(_upper_us(i), s.max_us);
+        }
+        return s.max_us;
+    };
+    s.p50_us = percentile(0.50);
+    s.p90_us = percentile(0.90);
+    s.p99_us = percentile(0.99);
+    return s;
+}
+
+size_t latency_histogram::_index(uint64_t us){
+    if(us<sub_buckets)
+        return (size_t)us;
+
+    /* power of 2 group + 2 bits below the msb */
+    size_t msb = 63 - countl_zero(us);
+    size_t sub = (size_t)((us >> (msb-2)) & (sub_buckets-1));
+    size_t index = (msb-1)*sub_buckets + sub;
+    return min(index, n_buckets-1);
+}
+
+double latency_histogram::_upper_us(size_t index){
+    if(index<sub_buckets)
+        return (double)(index+1);
+
+    size_t msb = index/sub_buckets + 1;
+    size_t sub = index%sub_buckets;
+    return (double)((uint64_t)(sub_buckets+sub+1) << (msb-2));
+}
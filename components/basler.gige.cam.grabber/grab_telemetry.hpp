@@ -0,0 +1,95 @@
+/**
+ * @file grab_telemetry.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Per-camera grab/encode/publish counters and latency histograms (lock-free)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_GRAB_TELEMETRY_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_GRAB_TELEMETRY_HPP_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief log-linear latency histogram in microseconds (4 sub-buckets per power of 2, up to ~1 s).
+ * record() is wait-free and called from the camera thread, take() reads and clears it from the reporting thread.
+ */
+class latency_histogram {
+    public:
+        static constexpr size_t sub_buckets = 4;
+        static constexpr size_t n_buckets = 21*sub_buckets;
+
+        struct summary {
+            uint64_t count {0};
+            double mean_us {0.0};
+            double p50_us {0.0};
+            double p90_us {0.0};
+            double p99_us {0.0};
+            double max_us {0.0};
+        };
+
+        void record(uint64_t ns);
+        summary take(latency_histogram* total = nullptr); /* summary of the records since the last take() (also added into total) */
+
+    private:
+        static size_t _index(uint64_t us);
+        static double _upper_us(size_t index);
+
+    private:
+        array<atomic<uint64_t>, n_buckets> _buckets {};
+        atomic<uint64_t> _count {0};
+        atomic<uint64_t> _sum_ns {0};
+        atomic<uint64_t> _max_ns {0};
+
+}; /* class */
+
+/* counters & histograms of a camera (written by its grab thread) */
+struct grab_telemetry {
+    /* frame counters (cumulative) */
+    atomic<uint64_t> grabbed {0};           /* successfully grabbed frames */
+    atomic<uint64_t> grab_failed {0};       /* incomplete/failed grab results */
+    atomic<uint64_t> dropped {0};           /* frame id gaps (lost in camera/network/driver) */
+    atomic<uint64_t> encoded {0};
+    atomic<uint64_t> published {0};
+    atomic<uint64_t> publish_failed {0};    /* ZMQ_DONTWAIT send failures (queue full) */
+    atomic<uint64_t> published_bytes {0};
+
+    /* GigE stream grabber statistics (cumulative, updated periodically) */
+    atomic<uint64_t> total_buffers {0};
+    atomic<uint64_t> failed_buffers {0};
+    atomic<uint64_t> buffer_underruns {0};
+    atomic<uint64_t> resend_requests {0};
+    atomic<uint64_t> resend_packets {0};
+
+    /* output queue depth (ready buffers waiting to be retrieved) */
+    atomic<uint64_t> queue_depth {0};
+    atomic<uint64_t> queue_depth_max {0};
+
+    /* newest grabbed frame (exposure midpoint in host monotonic clock) for stream age */
+    atomic<uint64_t> last_timestamp_ns {0};
+
+    /* latencies */
+    latency_histogram exposure_to_grab;     /* exposure midpoint -> retrieved by host */
+    latency_histogram grab_to_encode;       /* retrieved -> encoding done */
+    latency_histogram encode_to_send;       /* encoding done -> all sends returned */
+    latency_histogram auto_exposure;        /* software auto exposure cost per frame */
+    latency_histogram frame_cpu;            /* grab thread cpu time per frame (retrieved -> all sends returned) */
+    latency_histogram monitor_encode;       /* monitor tap resize & encoding */
+    latency_histogram monitor_age;          /* exposure midpoint -> monitor frame sent */
+
+    void set_queue_depth(uint64_t depth){
+        queue_depth.store(depth, memory_order_relaxed);
+        uint64_t prev = queue_depth_max.load(memory_order_relaxed);
+        while(depth>prev && !queue_depth_max.compare_exchange_weak(prev, depth, memory_order_relaxed));
+    }
+};
+
+#endif
@@ -0,0 +1,102 @@
+
+#include "monitor_rate.hpp"
+#include <algorithm>
+#include <cmath>
+
+monitor_rate_control::monitor_rate_control(const config& conf)
+:_config(conf){
+
+    if(_config.scales.empty())
+        _config.scales.push_back(1.0);
+    _config.quality_step = max(_config.quality_step, 1);
+    _config.min_quality = clamp(_config.min_quality, 1, 100);
+    _config.max_quality = clamp(_config.max_quality, _config.min_quality, 100);
+
+    /* (scale, quality) ladder ordered by rough jpeg size model : scale^2 * (0.1 + 0.9*(q/100)^2) */
+    for(double scale:_config.scales){
+        for(int q=_config.max_quality;q>=_config.min_quality;q-=_config.quality_step){
+            double f = (double)q/100.0;
+            _ladder.push_back(level{scale, q, scale*scale*(0.1 + 0.9*f*f)});
+        }
+    }
+    stable_sort(_ladder.begin(), _ladder.end(), [](const level& a, const level& b){ return a.cost>b.cost; });
+
+    _point.scale = _ladder[0].scale;
+    _point.quality = _ladder[0].quality;
+}
+
+bool monitor_rate_control::admit(uint64_t now_ns){
+    if(_config.budget_bytes_per_s<=0.0)
+        return true;
+
+    /* refill */
+    double depth = _config.budget_bytes_per_s*_config.burst_s;
+    if(_last_ns==0)
+        _tokens = depth;
+    else if(now_ns>_last_ns)
+        _tokens = min(depth, _tokens + _config.budget_bytes_per_s*(double)(now_ns-_last_ns)*1e-9);
+    _last_ns = now_ns;
+
+    /* budget exhausted : decimate (and let the level follow) */
+    if(_tokens<=0.0){
+        lock_guard<mutex> lock(_mutex);
+        _point.decimated++;
+        _adapt(now_ns);
+        return false;
+    }
+    return true;
+}
+
+void monitor_rate_control::update(uint64_t now_ns, size_t bytes){
+    _tokens -= (double)bytes;
+    _bytes_per_frame = (_bytes_per_frame>0.0) ? 0.7*_bytes_per_frame + 0.3*(double)bytes : (double)bytes;
+
+    lock_guard<mutex> lock(_mutex);
+    if(_window_start_ns==0)
+        _window_start_ns = now_ns;
+    _window_frames++;
+    _window_bytes += bytes;
+
+    double elapsed = (double)(now_ns-_window_start_ns)*1e-9;
+    if(elapsed>=1.0){
+        _point.fps = (double)_window_frames/elapsed;
+        _point.bytes_per_s = (double)_window_bytes/elapsed;
+        _window_start_ns = now_ns;
+        _window_frames = 0;
+        _window_bytes = 0;
+    }
+    _point.bytes_per_frame = _bytes_per_frame;
+    _adapt(now_ns);
+}
+
+monitor_operating_point monitor_rate_control::get_operating_point(){
+    lock_guard<mutex> lock(_mutex);
+    return _point;
+}
+
+void monitor_rate_control::_adapt(uint64_t now_ns){
+    if(_config.budget_bytes_per_s<=0.0 || _bytes_per_frame<=0.0)
+        return;
+    if(_last_adapt_ns!=0 && (double)(now_ns-_last_adapt_ns)*1e-9<_config.adapt_interval_s)
+        return;
+
+    /* frame rate the budget allows at the current level, and at the next better level (estimated) */
+    double fps = _config.budget_bytes_per_s/_bytes_per_frame;
+    size_t next = _level;
+    if(fps<_config.target_fps && _level+1<_ladder.size())
+        next = _level+1;
+    else if(_level>0){
+        double better_fps = fps*_ladder[_level].cost/_ladder[_level-1].cost;
+        if(better_fps>=_config.target_fps*1.2) /* hysteresis */
+            next = _level-1;
+    }
+
+    if(next!=_level){
+        /* expected size at the new level until measured */
+        _bytes_per_frame *= _ladder[next].cost/_ladder[_level].cost;
+        _level = next;
+        _point.scale = _ladder[_level].scale;
+        _point.quality = _ladder[_level].quality;
+    }
+    _last_adapt_ns = now_ns;
+}
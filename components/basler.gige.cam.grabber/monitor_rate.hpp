@@ -0,0 +1,94 @@
+/**
+ * @file monitor_rate.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Monitor stream rate control (jpeg quality, resolution level, frame decimation) under a bytes/s budget
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_BASLER_GIGE_CAM_GRABBER_MONITOR_RATE_HPP_INCLUDED
+#define FLAME_BASLER_GIGE_CAM_GRABBER_MONITOR_RATE_HPP_INCLUDED
+
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+/* chosen operating point (reported) */
+struct monitor_operating_point {
+    double scale {1.0};         /* of the configured monitor resolution */
+    int quality {90};           /* jpeg quality */
+    double fps {0.0};           /* sent frames per second */
+    double bytes_per_s {0.0};   /* sent bytes per second */
+    double bytes_per_frame {0.0};
+    uint64_t decimated {0};     /* frames skipped by the budget (cumulative) */
+};
+
+/**
+ * @brief monitor stream rate controller.
+ * a token bucket refilled at the budget decides whether a frame is sent (decimation), and the (scale, quality) level is
+ * stepped along a ladder ordered by estimated frame size, so that the measured bytes per frame allows target_fps in budget.
+ */
+class monitor_rate_control {
+    public:
+        struct config {
+            double budget_bytes_per_s {0.0};    /* 0 : unlimited */
+            double target_fps {10.0};           /* preferred output rate, quality/resolution are lowered to keep it */
+            int min_quality {30};
+            int max_quality {90};
+            int quality_step {15};
+            vector<double> scales {1.0, 0.75, 0.5, 0.25};
+            double adapt_interval_s {1.0};      /* min time between level changes */
+            double burst_s {0.5};               /* token bucket depth */
+        };
+
+        monitor_rate_control(const config& conf);
+        ~monitor_rate_control() = default;
+
+        /* true if a frame arriving now may be sent (call before encoding) */
+        bool admit(uint64_t now_ns);
+
+        /* a frame of bytes was sent */
+        void update(uint64_t now_ns, size_t bytes);
+
+        /* current level */
+        double get_scale() const { return _ladder[_level].scale; }
+        int get_quality() const { return _ladder[_level].quality; }
+
+        monitor_operating_point get_operating_point();
+
+    private:
+        struct level {
+            double scale;
+            int quality;
+            double cost; /* estimated relative frame size */
+        };
+
+        void _adapt(uint64_t now_ns);
+
+    private:
+        config _config;
+        vector<level> _ladder; /* best (largest) first */
+        size_t _level {0};
+
+        double _tokens {0.0};
+        uint64_t _last_ns {0};
+        uint64_t _last_adapt_ns {0};
+        double _bytes_per_frame {0.0}; /* ewma at current level */
+
+        /* rate measurement (for report) */
+        uint64_t _window_start_ns {0};
+        uint64_t _window_frames {0};
+        uint64_t _window_bytes {0};
+
+        mutex _mutex; /* operating point is read by the status thread */
+        monitor_operating_point _point;
+
+}; /* class */
+
+#endif
@@ -22,49 +22,23 @@ bool baumer_inclination_sensor::onInit(){
 
         _node_id = parameters.value("node_id", 0);
 
-        /* initialize */
-        canInitializeLibrary();
-
-        /* open CAN channel */
-        _can_channel = parameters.value("can_channel", 0);
-        _can_handle = canOpenChannel(_can_channel, canOPEN_ACCEPT_VIRTUAL);
-        if(_can_handle<0){
-            char err[512] = {0,};
-            canGetErrorText((canStatus)_can_handle, err, sizeof(err));
-            logger::error("[{}] Failed to open CAN Channel : {}", get_name(), err);
+        /* open the CAN channel (shared with the other components of the process, can.bus.broker) */
+        canbus::channel_config can_config;
+        can_config.channel = parameters.value("can_channel", 0);
+        can_config.bitrate = parameters.value("can_bitrate", 500000UL);
+        can_config.timer_scale_us = parameters.value("can_timer_scale_us", 10UL);
+        _can_channel = can_config.channel;
+        string error;
+        _can = canbus::channel::open(can_config, error);
+        if(!_can){
+            logger::error("[{}] Failed to open CAN Channel : {}", get_name(), error);
             return false;
         }
 
-        /* set bitrate */
-        unsigned long bitrate = parameters.value("can_bitrate", 500000);
-        canStatus stat;
-        switch(bitrate){
-            case 1000000: stat = canSetBusParams(_can_handle, canBITRATE_1M, 0, 0, 0, 0, 0); break;
-            case 500000: stat = canSetBusParams(_can_handle, canBITRATE_500K, 0, 0, 0, 0, 0); break;
-            case 250000: stat = canSetBusParams(_can_handle, canBITRATE_250K, 0, 0, 0, 0, 0); break;
-            case 125000: stat = canSetBusParams(_can_handle, canBITRATE_125K, 0, 0, 0, 0, 0); break;
-            case 100000: stat = canSetBusParams(_can_handle, canBITRATE_100K, 0, 0, 0, 0, 0); break;
-            case 62000: stat = canSetBusParams(_can_handle, canBITRATE_62K, 0, 0, 0, 0, 0); break;
-            case 50000: stat = canSetBusParams(_can_handle, canBITRATE_50K, 0, 0, 0, 0, 0); break;
-            case 83000: stat = canSetBusParams(_can_handle, canBITRATE_83K, 0, 0, 0, 0, 0); break;
-            case 10000: stat = canSetBusParams(_can_handle, canBITRATE_10K, 0, 0, 0, 0, 0); break;
-            default:
-                stat = canSetBusParams(_can_handle, canBITRATE_500K, 0, 0, 0, 0, 0);
-        }
-
-        if(stat!=canOK){
-            char err[512] = {0,};
-            canGetErrorText(stat, err, sizeof(err));
-            logger::error("[{}] Failed to set bitrate : {}", get_name(), err);
-            return false;
-        }
-
-        /* bus on */
-        stat = canBusOn(_can_handle);
-        if(stat!=canOK){
-            char err[512] = {0,};
-            canGetErrorText(stat, err, sizeof(err));
-            logger::error("[{}] Failed to go bus ON : {}", get_name(), err);
+        /* TPDO1 of the node only */
+        _can_rx = _can->subscribe(get_name(), {{(uint32_t)(0x180+_node_id), 0x7FF, false}}, 256);
+        if(!_can_rx){
+            logger::error("[{}] No free subscription on CAN channel {}", get_name(), _can_channel);
             return false;
         }
 
@@ -97,13 +71,12 @@ void baumer_inclination_sensor::onClose(){
         _can_rcv_worker.join();
     }
     
-    if(_can_handle != canINVALID_HANDLE){
-        canBusOff(_can_handle);
-        canClose(_can_handle);
-        _can_handle = canINVALID_HANDLE;
+    if(_can){
+        _can->unsubscribe(_can_rx);
+        _can_rx = nullptr;
+        _can.reset();
     }
-    canUnloadLibrary();
-    
+
     logger::info("[{}] Component successfully closed.", get_name());
 
 }
@@ -119,17 +92,15 @@ string baumer_inclination_sensor::_set_precision_str(double value, int precision
 }
 
 void baumer_inclination_sensor::_send_nmt_start_remote_node(){
-    if(_can_handle>=0){
-        long id = 0x000; /* CANOpen NMT Master to Slave */
-        unsigned char data[2];
-        data[0] = 0x01; /* Start remote node command */
-        data[1] = _node_id; /* Node ID */
-
-        canStatus stat = canWrite(_can_handle, id, data, 2, 0);
-        if(stat!=canOK) {
-            char err[512] = {0,};
-            canGetErrorText(stat, err, sizeof(err));
-            logger::error("[{}] {}", get_name(), err);
+    if(_can){
+        canbus::frame nmt;
+        nmt.id = 0x000;         /* CANOpen NMT Master to Slave */
+        nmt.dlc = 2;
+        nmt.data[0] = 0x01;     /* Start remote node command */
+        nmt.data[1] = _node_id; /* Node ID */
+
+        if(!_can->send(nmt)) {
+            logger::error("[{}] CAN transmit queue full", get_name());
         }
         else {
             logger::info("[{}] Request to activate PDO", get_name());
@@ -143,38 +114,23 @@ void baumer_inclination_sensor::_send_nmt_start_remote_node(){
 void baumer_inclination_sensor::_can_rcv_task(){
     
     try{
-        json tag;
-        auto last_time = chrono::high_resolution_clock::now();
-        const double resolution = 0.1;
+        auto last_report = chrono::steady_clock::now();
+
         while(!_worker_stop.load()){
-            long id;
-            unsigned char data[8];
-            unsigned int dlc;
-            unsigned int flags;
-            unsigned long time;
-
-            canStatus stat = canRead(_can_handle, &id, data, &dlc, &flags, &time);
-            if(stat==canOK) {
-                std::ostringstream oss;
-                for(unsigned char d:data){
-                    oss << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << static_cast<int>(d) << " ";
-                }
-                logger::debug("[{}] ID({}) | DLC({}) | Data({})", get_name(), id, dlc, oss.str());
-
-                if(id==(0x180+_node_id)){
-                    int16_t temperature = data[0] | (data[1] << 8);
-                    int16_t slope_z = data[2] | (data[3] << 8);
-                    int16_t slope_y = data[4] | (data[5] << 8);
-
-                    double slope_z_deg = static_cast<double>(slope_z)*resolution;
-                    double slope_y_deg = static_cast<double>(slope_y)*resolution;
-
-                    logger::info("[{}] Y({:.3f}), Z({:.3f}), Temp({})", get_name(), slope_y_deg, slope_z_deg, to_string(temperature));
-                }
-            }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            /* woken once per received batch (the timeout keeps the stop flag responsive) */
+            if(_can_rx->wait(100)){
+                canbus::frame f;
+                while(_can_rx->pop(f))
+                    _handle_frame(f);
+            }
 
+            /* status every second (the status port is only used by this thread) */
+            auto now = chrono::steady_clock::now();
+            if(now-last_report>=chrono::seconds(1)){
+                last_report = now;
+                _publish_status();
+            }
 
         } /* end while */
 
@@ -191,5 +147,62 @@ void baumer_inclination_sensor::_can_rcv_task(){
     }
 }
 
+void baumer_inclination_sensor::_handle_frame(const canbus::frame& f){
+    if(f.dlc<6)
+        return;
+    const uint8_t* data = f.data;
+
+    const double resolution = 0.1;
+    int16_t temperature = data[0] | (data[1] << 8);
+    int16_t slope_z = data[2] | (data[3] << 8);
+    int16_t slope_y = data[4] | (data[5] << 8);
+
+    double slope_z_deg = static_cast<double>(slope_z)*resolution;
+    double slope_y_deg = static_cast<double>(slope_y)*resolution;
+
+    logger::debug("[{}] Y({:.3f}), Z({:.3f}), Temp({})", get_name(), slope_y_deg, slope_z_deg, to_string(temperature));
+
+    /* publish (pose estimator pitch input, hardware receive time) */
+    json tag;
+    tag["slope_y"] = slope_y_deg;
+    tag["slope_z"] = slope_z_deg;
+    tag["temperature"] = temperature;
+    tag["timestamp_ns"] = f.timestamp_ns;
+    if(get_port("status")->handle()!=nullptr){
+        zmq::multipart_t msg_multipart;
+        msg_multipart.addstr(fmt::format("{}/inclination", get_name()));
+        msg_multipart.addstr(tag.dump());
+        msg_multipart.send(*get_port("status"), ZMQ_DONTWAIT);
+    }
+}
 
-
+void baumer_inclination_sensor::_publish_status(){
+    const canbus::channel_stats can = _can->get_stats();
+
+    json status;
+    status["can"] = {
+        {"frames", can.rx_frames},
+        {"wakeups", can.rx_wakeups},
+        {"max_batch", can.rx_max_batch},
+        {"overruns", can.rx_overruns},
+        {"error_frames", can.rx_error_frames},
+        {"unrouted", can.rx_unrouted},
+        {"received", _can_rx->get_received()},
+        {"dropped", _can_rx->get_dropped()},
+        {"tx_frames", can.tx_frames},
+        {"tx_errors", can.tx_errors},
+        {"tx_error_counter", can.tx_error_counter},
+        {"rx_error_counter", can.rx_error_counter},
+        {"overrun_counter", can.overrun_counter},
+        {"error_passive", can.error_passive},
+        {"bus_off", can.bus_off},
+        {"subscribers", can.subscribers}
+    };
+
+    if(get_port("status")->handle()!=nullptr){
+        zmq::multipart_t msg_multipart;
+        msg_multipart.addstr(fmt::format("{}/status", get_name()));
+        msg_multipart.addstr(status.dump());
+        msg_multipart.send(*get_port("status"), ZMQ_DONTWAIT);
+    }
+}
@@ -23,9 +23,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-extern "C" {
-    #include <canlib.h>
-}
+#include "../can.bus.broker/can_bus_broker.hpp"
 
 
 using namespace std;
@@ -45,6 +43,10 @@ class baumer_inclination_sensor : public flame::component::object {
     private:
         /* CAN Receive Task function */
         void _can_rcv_task();
+        void _handle_frame(const canbus::frame& f);
+
+        /* receive counters and bus error state */
+        void _publish_status();
 
         /* activate PDO */
         void _send_nmt_start_remote_node();
@@ -54,7 +56,8 @@ class baumer_inclination_sensor : public flame::component::object {
 
     private:
         int _can_channel {0};
-        CanHandle _can_handle { canINVALID_HANDLE };
+        shared_ptr<canbus::channel> _can;
+        canbus::subscription* _can_rx { nullptr };
         thread _can_rcv_worker;
         int _node_id {0};
 
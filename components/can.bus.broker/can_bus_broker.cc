@@ -0,0 +1,446 @@
+
+#include "can_bus_broker.hpp"
+#include <map>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+namespace canbus {
+
+    static int64_t _system_ns(){
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static string _error_text(canStatus stat){
+        char err[512] = {0,};
+        canGetErrorText(stat, err, sizeof(err));
+        return string(err);
+    }
+
+    long bitrate_constant(unsigned long bitrate){
+        switch(bitrate){
+            case 1000000: return canBITRATE_1M;
+            case 500000: return canBITRATE_500K;
+            case 250000: return canBITRATE_250K;
+            case 125000: return canBITRATE_125K;
+            case 100000: return canBITRATE_100K;
+            case 62000: return canBITRATE_62K;
+            case 50000: return canBITRATE_50K;
+            case 83000: return canBITRATE_83K;
+            case 10000: return canBITRATE_10K;
+            default: return canBITRATE_500K;
+        }
+    }
+
+    static void _notify(int fd){
+        const uint64_t one = 1;
+        if(write(fd, &one, sizeof(one))<0) {}
+    }
+
+    /* subscription */
+
+    subscription::subscription(const string& name, const vector<filter>& filters, size_t capacity, bool transmitted)
+        :_name(name), _filters(filters), _queue(capacity), _transmitted(transmitted) {
+        _event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    }
+
+    subscription::~subscription(){
+        if(_event_fd>=0)
+            close(_event_fd);
+    }
+
+    bool subscription::wait(int timeout_ms){
+        pollfd p {_event_fd, POLLIN, 0};
+        if(poll(&p, 1, timeout_ms)<=0)
+            return false;
+        uint64_t count = 0;
+        if(read(_event_fd, &count, sizeof(count))<0) {}
+        return true;
+    }
+
+    bool subscription::_matches(const frame& f) const {
+        const bool extended = (f.flags & FRAME_EXTENDED)!=0;
+        for(const filter& flt:_filters)
+            if(flt.extended==extended && (f.id & flt.mask)==(flt.code & flt.mask))
+                return true;
+        return false;
+    }
+
+    /* channel */
+
+    static mutex _registry_mutex;
+    static map<int, weak_ptr<channel>> _registry;
+
+    shared_ptr<channel> channel::open(const channel_config& config, string& error){
+        lock_guard<mutex> lock(_registry_mutex);
+
+        static bool initialized = false;
+        if(!initialized){
+            canInitializeLibrary();
+            initialized = true;
+        }
+
+        auto it = _registry.find(config.channel);
+        if(it!=_registry.end()){
+            if(shared_ptr<channel> shared = it->second.lock()){
+                if(shared->_config.bitrate!=config.bitrate){
+                    error = "channel " + to_string(config.channel) + " is already open at " + to_string(shared->_config.bitrate) + " bps";
+                    return nullptr;
+                }
+                return shared;
+            }
+        }
+
+        shared_ptr<channel> created(new channel(config));
+        if(!created->_open(error))
+            return nullptr;
+        _registry[config.channel] = created;
+        return created;
+    }
+
+    channel::channel(const channel_config& config):_config(config){
+        for(int i=0;i<n_priorities;i++)
+            _tx_queues.emplace_back(make_unique<mpmc_queue<frame>>(256));
+        _tx_event_fd = eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC);
+    }
+
+    channel::~channel(){
+        _stop.store(true);
+        _notify(_tx_event_fd);
+        if(_tx_worker.joinable())
+            _tx_worker.join();
+        if(_rx_worker.joinable())
+            _rx_worker.join();
+
+        for(canHandle handle:{_rx_handle, _tx_handle}){
+            if(handle>=0){
+                canBusOff(handle);
+                canClose(handle);
+            }
+        }
+        if(_tx_event_fd>=0)
+            close(_tx_event_fd);
+    }
+
+    bool channel::_open(string& error){
+        canHandle* handles[] = {&_rx_handle, &_tx_handle};
+        for(canHandle* handle:handles){
+            *handle = canOpenChannel(_config.channel, canOPEN_ACCEPT_VIRTUAL);
+            if(*handle<0){
+                error = "failed to open CAN channel " + to_string(_config.channel) + " : " + _error_text((canStatus)*handle);
+                return false;
+            }
+            canStatus stat = canSetBusParams(*handle, bitrate_constant(_config.bitrate), 0, 0, 0, 0, 0);
+            if(stat!=canOK){
+                error = "failed to set bitrate : " + _error_text(stat);
+                return false;
+            }
+        }
+
+        /* hardware timestamp resolution (us) of the received frames */
+        canIoCtl(_rx_handle, canIOCTL_SET_TIMER_SCALE, &_config.timer_scale_us, sizeof(_config.timer_scale_us));
+
+        /* transmitted frames are echoed to the receive handle (canMSG_LOCAL_TXACK), only routed to the subscribers asking for them */
+        unsigned char echo = 1;
+        canIoCtl(_tx_handle, canIOCTL_SET_LOCAL_TXECHO, &echo, sizeof(echo));
+
+        /* nothing is routed until the first subscription */
+        _update_routes();
+        _apply_filters();
+
+        for(canHandle* handle:handles){
+            canStatus stat = canBusOn(*handle);
+            if(stat!=canOK){
+                error = "failed to go bus ON : " + _error_text(stat);
+                return false;
+            }
+        }
+
+        _rx_worker = thread(&channel::_rx_task, this);
+        _tx_worker = thread(&channel::_tx_task, this);
+        return true;
+    }
+
+    subscription* channel::subscribe(const string& name, const vector<filter>& filters, size_t capacity, bool transmitted){
+        lock_guard<mutex> lock(_config_mutex);
+        for(int i=0;i<max_subscribers;i++){
+            if(_slots[i].load()!=nullptr)
+                continue;
+            _owned.emplace_back(new subscription(name, filters, capacity, transmitted));
+            _slots[i].store(_owned.back().get(), memory_order_release);
+            _update_routes();
+            return _owned.back().get();
+        }
+        return nullptr;
+    }
+
+    void channel::unsubscribe(subscription* s){
+        lock_guard<mutex> lock(_config_mutex);
+        for(int i=0;i<max_subscribers;i++)
+            if(_slots[i].load()==s)
+                _slots[i].store(nullptr, memory_order_release);
+        _update_routes();
+    }
+
+    void channel::_update_routes(){
+        /* standard ids : one lookup per received frame */
+        bool has_extended = false;
+        uint16_t tx_slots = 0;
+        bool any_std = false, any_ext = false;
+        uint32_t std_code = 0, std_mask = 0x7FF, ext_code = 0, ext_mask = 0x1FFFFFFF;
+        array<uint16_t, 2048> routes {};
+
+        for(int i=0;i<max_subscribers;i++){
+            const subscription* s = _slots[i].load();
+            if(!s)
+                continue;
+            if(s->_transmitted)
+                tx_slots |= (uint16_t)(1u << i);
+            for(const filter& flt:s->_filters){
+                /* widest single code/mask pair passing every filter (bits where all the codes agree) */
+                uint32_t& code = flt.extended ? ext_code : std_code;
+                uint32_t& mask = flt.extended ? ext_mask : std_mask;
+                bool& any = flt.extended ? any_ext : any_std;
+                if(!any){
+                    code = flt.code & flt.mask;
+                    mask = flt.mask;
+                    any = true;
+                }
+                else
+                    mask &= flt.mask & ~(code ^ flt.code);
+                code &= mask;
+
+                if(flt.extended){
+                    has_extended = true;
+                    continue;
+                }
+                for(uint32_t id=0;id<2048;id++)
+                    if((id & flt.mask)==(flt.code & flt.mask))
+                        routes[id] |= (uint16_t)(1u << i);
+            }
+        }
+
+        for(size_t id=0;id<routes.size();id++)
+            _std_routes[id].store(routes[id], memory_order_relaxed);
+        _has_extended.store(has_extended, memory_order_release);
+        _tx_slots.store(tx_slots, memory_order_release);
+
+        /* hardware (or driver) acceptance filters, applied by the receive thread which owns the handle.
+           a type without subscriber only passes its last id */
+        _filter[0].store(any_std ? std_code : 0x7FF);
+        _filter[1].store(any_std ? std_mask : 0x7FF);
+        _filter[2].store(any_ext ? ext_code : 0x1FFFFFFF);
+        _filter[3].store(any_ext ? ext_mask : 0x1FFFFFFF);
+        _filter_changed.store(true, memory_order_release);
+    }
+
+    void channel::_apply_filters(){
+        canSetAcceptanceFilter(_rx_handle, _filter[0].load(), _filter[1].load(), 0);
+        canSetAcceptanceFilter(_rx_handle, _filter[2].load(), _filter[3].load(), 1);
+    }
+
+    bool channel::send(const frame& f, priority p){
+        if(!_tx_queues[(int)p]->push(f)){
+            _tx_dropped.fetch_add(1, memory_order_relaxed);
+            return false;
+        }
+        _notify(_tx_event_fd);
+        return true;
+    }
+
+    size_t channel::send(const frame* frames, size_t count, priority p){
+        size_t n = 0;
+        while(n<count && _tx_queues[(int)p]->push(frames[n]))
+            n++;
+        if(n<count)
+            _tx_dropped.fetch_add(count-n, memory_order_relaxed);
+        if(n>0)
+            _notify(_tx_event_fd);
+        return n;
+    }
+
+    channel_stats channel::get_stats(){
+        channel_stats stats;
+        stats.rx_frames = _rx_frames.load();
+        stats.rx_wakeups = _rx_wakeups.load();
+        stats.rx_max_batch = _rx_max_batch.exchange(0);
+        stats.rx_overruns = _rx_overruns.load();
+        stats.rx_error_frames = _rx_error_frames.load();
+        stats.rx_unrouted = _rx_unrouted.load();
+        stats.tx_frames = _tx_frames.load();
+        stats.tx_errors = _tx_errors.load();
+        stats.tx_dropped = _tx_dropped.load();
+        stats.tx_error_counter = _tx_error_counter.load();
+        stats.rx_error_counter = _rx_error_counter.load();
+        stats.overrun_counter = _overrun_counter.load();
+        stats.error_passive = (_bus_status.load() & canSTAT_ERROR_PASSIVE)!=0;
+        stats.bus_off = (_bus_status.load() & canSTAT_BUS_OFF)!=0;
+        for(const auto& slot:_slots)
+            stats.subscribers += slot.load()!=nullptr;
+        return stats;
+    }
+
+    void channel::_dispatch(const frame& f){
+        uint32_t routes = 0;
+        if(!(f.flags & FRAME_EXTENDED))
+            routes = _std_routes[f.id & 0x7FF].load(memory_order_relaxed);
+        else if(_has_extended.load(memory_order_acquire)){
+            for(int i=0;i<max_subscribers;i++){
+                const subscription* s = _slots[i].load(memory_order_acquire);
+                if(s && s->_matches(f))
+                    routes |= 1u << i;
+            }
+        }
+        if(f.flags & FRAME_TX)
+            routes &= _tx_slots.load(memory_order_acquire);
+        if(!routes){
+            if(!(f.flags & FRAME_TX))
+                _rx_unrouted.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+
+        while(routes){
+            const int i = __builtin_ctz(routes);
+            routes &= routes-1;
+            subscription* s = _slots[i].load(memory_order_acquire);
+            if(!s)
+                continue;
+            if(s->_queue.push(f)){
+                s->_received.fetch_add(1, memory_order_relaxed);
+                s->_pending = true;
+            }
+            else
+                s->_dropped.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    void channel::_rx_task(){
+        auto last_sync = chrono::steady_clock::now();
+        _sync_clock();
+        _read_bus_status();
+
+        while(!_stop.load()){
+            long id;
+            unsigned char data[8];
+            unsigned int dlc;
+            unsigned int flags;
+            unsigned long time;
+
+            /* wait for a frame (the timeout keeps the stop flag responsive), then drain the receive queue */
+            canStatus stat = canReadWait(_rx_handle, &id, data, &dlc, &flags, &time, 100);
+            if(stat==canOK){
+                uint64_t batch = 0;
+                const int64_t offset_ns = _clock_offset_ns.load(memory_order_relaxed);
+                do {
+                    batch++;
+                    if(flags & canMSG_ERROR_FRAME){
+                        _rx_error_frames.fetch_add(1, memory_order_relaxed);
+                        continue;
+                    }
+                    frame f;
+                    f.id = (uint32_t)id;
+                    f.dlc = (uint8_t)(dlc>8 ? 8 : dlc);
+                    f.flags = ((flags & canMSG_EXT) ? FRAME_EXTENDED : 0) | ((flags & canMSG_RTR) ? FRAME_RTR : 0);
+                    if(flags & canMSG_LOCAL_TXACK)
+                        f.flags |= FRAME_TX;
+                    if(flags & canMSGERR_OVERRUN){
+                        f.flags |= FRAME_OVERRUN;
+                        _rx_overruns.fetch_add(1, memory_order_relaxed);
+                    }
+                    memcpy(f.data, data, f.dlc);
+                    f.timestamp_ns = (uint64_t)(offset_ns + (int64_t)time*(int64_t)_config.timer_scale_us*1000);
+                    if(!(f.flags & FRAME_TX))
+                        _rx_frames.fetch_add(1, memory_order_relaxed);
+                    _dispatch(f);
+                } while(canRead(_rx_handle, &id, data, &dlc, &flags, &time)==canOK);
+
+                /* one wakeup per subscriber and batch */
+                for(auto& slot:_slots){
+                    subscription* s = slot.load(memory_order_acquire);
+                    if(s && s->_pending){
+                        s->_pending = false;
+                        _notify(s->_event_fd);
+                    }
+                }
+
+                _rx_wakeups.fetch_add(1, memory_order_relaxed);
+                if(batch>_rx_max_batch.load(memory_order_relaxed))
+                    _rx_max_batch.store(batch, memory_order_relaxed);
+            }
+            else if(stat!=canERR_NOMSG && stat!=canERR_TIMEOUT)
+                this_thread::sleep_for(chrono::milliseconds(100));
+
+            if(_filter_changed.exchange(false, memory_order_acquire))
+                _apply_filters();
+
+            /* clock resync and controller state once per second */
+            auto now = chrono::steady_clock::now();
+            if(now-last_sync>=chrono::seconds(1)){
+                last_sync = now;
+                _sync_clock();
+                _read_bus_status();
+            }
+        }
+    }
+
+    void channel::_tx_task(){
+        while(!_stop.load()){
+            pollfd p {_tx_event_fd, POLLIN, 0};
+            if(poll(&p, 1, 100)>0){
+                uint64_t count = 0;
+                if(read(_tx_event_fd, &count, sizeof(count))<0) {}
+            }
+
+            /* highest priority first, rescanned after every frame */
+            frame f;
+            for(;;){
+                bool found = false;
+                for(int i=0;i<n_priorities && !found;i++)
+                    found = _tx_queues[i]->pop(f);
+                if(!found)
+                    break;
+
+                unsigned int flags = (f.flags & FRAME_EXTENDED) ? canMSG_EXT : canMSG_STD;
+                if(f.flags & FRAME_RTR)
+                    flags |= canMSG_RTR;
+                canStatus stat;
+                while((stat = canWrite(_tx_handle, f.id, f.data, f.dlc, flags))==canERR_TXBUFOFL && !_stop.load())
+                    canWriteSync(_tx_handle, 10);
+                if(stat==canOK)
+                    _tx_frames.fetch_add(1, memory_order_relaxed);
+                else
+                    _tx_errors.fetch_add(1, memory_order_relaxed);
+            }
+        }
+    }
+
+    void channel::_sync_clock(){
+        /* latch the hardware timer between two system clock reads, keep the tightest of a few tries */
+        int64_t best_rtt = INT64_MAX;
+        for(int i=0;i<4;i++){
+            unsigned long timer = 0;
+            const int64_t before = _system_ns();
+            if(canReadTimer(_rx_handle, &timer)!=canOK)
+                return;
+            const int64_t after = _system_ns();
+            if(after-before<best_rtt){
+                best_rtt = after-before;
+                _clock_offset_ns.store(before + best_rtt/2 - (int64_t)timer*(int64_t)_config.timer_scale_us*1000);
+            }
+        }
+    }
+
+    void channel::_read_bus_status(){
+        unsigned int tx_errors = 0, rx_errors = 0, overrun_errors = 0;
+        unsigned long status = 0;
+        canReadErrorCounters(_rx_handle, &tx_errors, &rx_errors, &overrun_errors);
+        canReadStatus(_rx_handle, &status);
+        _tx_error_counter.store(tx_errors);
+        _rx_error_counter.store(rx_errors);
+        _overrun_counter.store(overrun_errors);
+        _bus_status.store(status);
+    }
+
+} /* namespace */
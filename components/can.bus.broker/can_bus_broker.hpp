@@ -0,0 +1,201 @@
+/**
+ * @file can_bus_broker.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Process-wide CAN channel broker (one owner per physical channel, acceptance filters, RX fan-out, prioritized TX)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_CAN_BUS_BROKER_HPP_INCLUDED
+#define FLAME_CAN_BUS_BROKER_HPP_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "lockfree_queue.hpp"
+extern "C" {
+    #include <canlib.h>
+}
+
+using namespace std;
+
+namespace canbus {
+
+    /* frame flags */
+    enum : uint8_t {
+        FRAME_EXTENDED  = 1u << 0,
+        FRAME_RTR       = 1u << 1,
+        FRAME_OVERRUN   = 1u << 2,  /* frames were lost before this one */
+        FRAME_TX        = 1u << 3,  /* sent by this process (local echo of the transmit handle) */
+    };
+
+    /* a CAN frame (32 bytes) */
+    struct frame {
+        uint32_t id {0};
+        uint8_t dlc {0};
+        uint8_t flags {0};
+        uint8_t reserved[2] {0, 0};
+        uint8_t data[8] {0, };
+        uint64_t timestamp_ns {0};      /* hardware receive time on the system clock */
+        uint64_t reserved_64 {0};
+    };
+
+    /* acceptance filter : a frame matches when (id & mask) == (code & mask) */
+    struct filter {
+        uint32_t code {0};
+        uint32_t mask {0};
+        bool extended {false};
+    };
+
+    /* transmit priority (a queued control frame is always written before the lower ones) */
+    enum class priority : int { control = 0, normal = 1, low = 2 };
+    static constexpr int n_priorities = 3;
+
+    struct channel_config {
+        int channel {0};
+        unsigned long bitrate {500000};
+        unsigned long timer_scale_us {10};  /* hardware timestamp resolution */
+    };
+
+    struct channel_stats {
+        uint64_t rx_frames {0};
+        uint64_t rx_wakeups {0};
+        uint64_t rx_max_batch {0};          /* since the last get_stats() */
+        uint64_t rx_overruns {0};
+        uint64_t rx_error_frames {0};
+        uint64_t rx_unrouted {0};           /* passed the hardware filter, matched no subscriber */
+        uint64_t tx_frames {0};
+        uint64_t tx_errors {0};
+        uint64_t tx_dropped {0};            /* transmit queue full */
+        unsigned int tx_error_counter {0};
+        unsigned int rx_error_counter {0};
+        unsigned int overrun_counter {0};
+        bool error_passive {false};
+        bool bus_off {false};
+        int subscribers {0};
+    };
+
+    /* canlib bus parameter constant of a bitrate (bps), 500 kbps if not supported */
+    long bitrate_constant(unsigned long bitrate);
+
+    class channel;
+
+    /**
+     * @brief frames of one consumer. filled by the channel receive thread, drained by the consumer thread.
+     */
+    class subscription {
+        friend class channel;
+        public:
+            ~subscription();
+
+            /* block until frames are queued (or timeout), then drain them with pop() */
+            bool wait(int timeout_ms);
+            bool pop(frame& f) { return _queue.pop(f); }
+
+            const string& get_name() const { return _name; }
+            uint64_t get_received() const { return _received.load(memory_order_relaxed); }
+            uint64_t get_dropped() const { return _dropped.load(memory_order_relaxed); }
+
+        private:
+            subscription(const string& name, const vector<filter>& filters, size_t capacity, bool transmitted);
+            bool _matches(const frame& f) const;
+
+        private:
+            string _name;
+            vector<filter> _filters;
+            spsc_queue<frame> _queue;
+            int _event_fd {-1};
+            bool _transmitted {false};
+            bool _pending {false};          /* frames pushed in the current batch (receive thread only) */
+            atomic<uint64_t> _received {0};
+            atomic<uint64_t> _dropped {0};
+    };
+
+    /**
+     * @brief one physical CAN channel, shared by all the components of the process.
+     * two canlib handles are opened (canlib handles are not thread safe) : the receive thread reads one,
+     * the transmit thread writes the other.
+     */
+    class channel {
+        public:
+            static constexpr int max_subscribers = 16;
+
+            /* the first open of a channel creates it, the next ones share it (same bitrate), nullptr on error */
+            static shared_ptr<channel> open(const channel_config& config, string& error);
+            ~channel();
+
+            /* register a consumer (exact ids : mask 0x7FF / 0x1FFFFFFF), nullptr if all the slots are used.
+               transmitted : also receive the matching frames sent through this channel (FRAME_TX) */
+            subscription* subscribe(const string& name, const vector<filter>& filters, size_t capacity = 1024, bool transmitted = false);
+            void unsubscribe(subscription* s);
+
+            /* queue frames for transmission from any thread (never blocks, false / count when the queue is full) */
+            bool send(const frame& f, priority p = priority::normal);
+            size_t send(const frame* frames, size_t count, priority p = priority::normal);
+
+            channel_stats get_stats();
+            const channel_config& get_config() const { return _config; }
+
+        private:
+            channel(const channel_config& config);
+            bool _open(string& error);
+            void _rx_task();
+            void _tx_task();
+            void _dispatch(const frame& f);
+            void _update_routes();          /* routing table and hardware acceptance filters */
+            void _apply_filters();
+            void _sync_clock();
+            void _read_bus_status();
+
+        private:
+            channel_config _config;
+            canHandle _rx_handle {canINVALID_HANDLE};
+            canHandle _tx_handle {canINVALID_HANDLE};
+            thread _rx_worker;
+            thread _tx_worker;
+            atomic<bool> _stop {false};
+
+            /* subscribers (slots are only cleared, the objects live as long as the channel) */
+            mutex _config_mutex;
+            vector<unique_ptr<subscription>> _owned;
+            array<atomic<subscription*>, max_subscribers> _slots {};
+            array<atomic<uint16_t>, 2048> _std_routes {};  /* standard id -> bit set of the matching slots */
+            atomic<bool> _has_extended {false};
+            atomic<uint16_t> _tx_slots {0};                 /* slots receiving the transmitted frames */
+            array<atomic<uint32_t>, 4> _filter {};          /* standard code, mask, extended code, mask */
+            atomic<bool> _filter_changed {false};
+
+            /* transmit */
+            vector<unique_ptr<mpmc_queue<frame>>> _tx_queues;
+            int _tx_event_fd {-1};
+
+            /* hardware clock (system clock - hardware timer) */
+            atomic<int64_t> _clock_offset_ns {0};
+
+            /* statistics */
+            atomic<uint64_t> _rx_frames {0};
+            atomic<uint64_t> _rx_wakeups {0};
+            atomic<uint64_t> _rx_max_batch {0};
+            atomic<uint64_t> _rx_overruns {0};
+            atomic<uint64_t> _rx_error_frames {0};
+            atomic<uint64_t> _rx_unrouted {0};
+            atomic<uint64_t> _tx_frames {0};
+            atomic<uint64_t> _tx_errors {0};
+            atomic<uint64_t> _tx_dropped {0};
+            atomic<unsigned int> _tx_error_counter {0};
+            atomic<unsigned int> _rx_error_counter {0};
+            atomic<unsigned int> _overrun_counter {0};
+            atomic<unsigned long> _bus_status {0};
+    };
+
+} /* namespace */
+
+#endif
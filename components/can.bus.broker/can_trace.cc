@@ -0,0 +1,298 @@
+
+#include "can_trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace canbus {
+
+    static constexpr size_t writer_buffer_records = 2048;  /* 64 KiB per write */
+
+    static bool _write_all(int fd, const void* data, size_t size){
+        const char* p = (const char*)data;
+        while(size>0){
+            ssize_t n = ::write(fd, p, size);
+            if(n<0){
+                if(errno==EINTR)
+                    continue;
+                return false;
+            }
+            p += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    static uint32_t _index_id(const frame& f){
+        return f.id | ((f.flags & FRAME_EXTENDED) ? 0x80000000u : 0u);
+    }
+
+    /* trace_writer */
+
+    bool trace_writer::open(const string& path, int channel, unsigned long bitrate, uint32_t index_interval){
+        close();
+        _fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+        if(_fd<0)
+            return false;
+
+        _header = trace_header();
+        _header.channel = channel;
+        _header.bitrate = (uint32_t)bitrate;
+        _header.index_interval = index_interval>0 ? index_interval : 1024;
+        _header.start_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        _buffer.clear();
+        _buffer.reserve(writer_buffer_records);
+        _time_index.clear();
+        _id_index.clear();
+        return _write_all(_fd, &_header, sizeof(_header));
+    }
+
+    bool trace_writer::write(const frame& f){
+        if(_fd<0)
+            return false;
+
+        const uint64_t record = _header.n_records++;
+        if(record%_header.index_interval==0)
+            _time_index.push_back({f.timestamp_ns, record});
+
+        const uint32_t id = _index_id(f);
+        auto it = lower_bound(_id_index.begin(), _id_index.end(), id, [](const trace_id_entry& e, uint32_t v){ return e.id<v; });
+        if(it==_id_index.end() || it->id!=id)
+            it = _id_index.insert(it, trace_id_entry{id, 0, 0, record});
+        it->count++;
+
+        _buffer.push_back(f);
+        if(_buffer.size()>=writer_buffer_records)
+            return _flush();
+        return true;
+    }
+
+    bool trace_writer::_flush(){
+        if(_buffer.empty())
+            return true;
+        bool ok = _write_all(_fd, _buffer.data(), _buffer.size()*sizeof(frame));
+        _buffer.clear();
+        return ok;
+    }
+
+    bool trace_writer::close(){
+        if(_fd<0)
+            return true;
+
+        bool ok = _flush();
+        _header.index_offset = sizeof(trace_header) + _header.n_records*sizeof(frame);
+        _header.n_time_entries = (uint32_t)_time_index.size();
+        _header.n_id_entries = (uint32_t)_id_index.size();
+        ok = ok && _write_all(_fd, _time_index.data(), _time_index.size()*sizeof(trace_time_entry));
+        ok = ok && _write_all(_fd, _id_index.data(), _id_index.size()*sizeof(trace_id_entry));
+        ok = ok && pwrite(_fd, &_header, sizeof(_header), 0)==(ssize_t)sizeof(_header);
+        ::close(_fd);
+        _fd = -1;
+        return ok;
+    }
+
+    /* trace_reader */
+
+    bool trace_reader::open(const string& path){
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY|O_CLOEXEC);
+        if(fd<0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st)<0 || (size_t)st.st_size<sizeof(trace_header)){
+            ::close(fd);
+            return false;
+        }
+        _map_size = (size_t)st.st_size;
+        _map = mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(_map==MAP_FAILED){
+            _map = nullptr;
+            return false;
+        }
+
+        memcpy(&_header, _map, sizeof(_header));
+        if(_header.magic!=trace_header().magic || _header.record_size!=sizeof(frame)){
+            close();
+            return false;
+        }
+
+        const char* base = (const char*)_map;
+        _frames = (const frame*)(base + sizeof(trace_header));
+        const size_t index_size = _header.n_time_entries*sizeof(trace_time_entry) + _header.n_id_entries*sizeof(trace_id_entry);
+        if(_header.index_offset!=0 && _header.index_offset+index_size<=_map_size){
+            _n_records = _header.n_records;
+            _time_index = (const trace_time_entry*)(base + _header.index_offset);
+            _n_time_entries = _header.n_time_entries;
+            _id_index = (const trace_id_entry*)(base + _header.index_offset + _header.n_time_entries*sizeof(trace_time_entry));
+            _n_id_entries = _header.n_id_entries;
+        }
+        else{
+            /* not closed : whole records only, no index */
+            _n_records = (_map_size-sizeof(trace_header))/sizeof(frame);
+            _header.n_records = _n_records;
+        }
+
+        madvise(_map, _map_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void trace_reader::close(){
+        if(_map)
+            munmap(_map, _map_size);
+        _map = nullptr;
+        _map_size = 0;
+        _frames = nullptr;
+        _n_records = 0;
+        _time_index = nullptr;
+        _n_time_entries = 0;
+        _id_index = nullptr;
+        _n_id_entries = 0;
+    }
+
+    size_t trace_reader::seek(uint64_t timestamp_ns) const {
+        size_t first = 0, last = _n_records;
+        if(_n_time_entries>0){
+            const trace_time_entry* end = _time_index+_n_time_entries;
+            const trace_time_entry* it = upper_bound(_time_index, end, timestamp_ns, [](uint64_t v, const trace_time_entry& e){ return v<e.timestamp_ns; });
+            if(it!=_time_index)
+                first = (size_t)(it-1)->record;
+            if(it!=end)
+                last = (size_t)it->record;
+        }
+        const frame* found = lower_bound(_frames+first, _frames+last, timestamp_ns, [](const frame& f, uint64_t v){ return f.timestamp_ns<v; });
+        return (size_t)(found-_frames);
+    }
+
+    /* trace_recorder */
+
+    bool trace_recorder::start(const shared_ptr<channel>& can, const string& path, const string& name){
+        stop();
+        if(!can || !_writer.open(path, can->get_config().channel, can->get_config().bitrate))
+            return false;
+
+        /* every standard and extended id, and the frames sent by the process */
+        _subscription = can->subscribe(name, {{0, 0, false}, {0, 0, true}}, 8192, true);
+        if(!_subscription){
+            _writer.close();
+            return false;
+        }
+        _can = can;
+        _stop.store(false);
+        _records.store(0);
+        _worker = thread(&trace_recorder::_task, this);
+        return true;
+    }
+
+    void trace_recorder::stop(){
+        _stop.store(true);
+        if(_worker.joinable())
+            _worker.join();
+        if(_can){
+            _can->unsubscribe(_subscription);
+            _subscription = nullptr;
+            _can.reset();
+        }
+        _writer.close();
+    }
+
+    void trace_recorder::_task(){
+        frame f;
+        while(!_stop.load()){
+            if(!_subscription->wait(100))
+                continue;
+            while(_subscription->pop(f)){
+                _writer.write(f);
+                _records.fetch_add(1, memory_order_relaxed);
+            }
+        }
+        while(_subscription->pop(f)){
+            _writer.write(f);
+            _records.fetch_add(1, memory_order_relaxed);
+        }
+    }
+
+    /* trace_player */
+
+    trace_player::~trace_player(){
+        if(_handle>=0){
+            canBusOff(_handle);
+            canClose(_handle);
+        }
+    }
+
+    bool trace_player::open(string& error){
+        canInitializeLibrary();
+        _handle = canOpenChannel(_config.channel, canOPEN_ACCEPT_VIRTUAL);
+        if(_handle<0){
+            char err[512] = {0,};
+            canGetErrorText((canStatus)_handle, err, sizeof(err));
+            error = err;
+            return false;
+        }
+        canStatus stat = canSetBusParams(_handle, bitrate_constant(_config.bitrate), 0, 0, 0, 0, 0);
+        if(stat==canOK)
+            stat = canBusOn(_handle);
+        if(stat!=canOK){
+            char err[512] = {0,};
+            canGetErrorText(stat, err, sizeof(err));
+            error = err;
+            return false;
+        }
+        return true;
+    }
+
+    static int64_t _monotonic_ns(){
+        timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return (int64_t)t.tv_sec*1000000000LL + t.tv_nsec;
+    }
+
+    trace_player::result trace_player::play(const trace_reader& trace, size_t first, size_t last, const atomic<bool>& stop){
+        result r;
+        last = min(last, trace.size());
+        if(_handle<0 || first>=last)
+            return r;
+
+        do {
+            /* trace time is mapped to absolute deadlines from the first record (no drift) */
+            const int64_t start_ns = _monotonic_ns();
+            const uint64_t trace_start_ns = trace[first].timestamp_ns;
+
+            for(size_t i=first;i<last && !stop.load(memory_order_relaxed);i++){
+                const frame& f = trace[i];
+                if((f.flags & FRAME_TX) && !_config.transmitted)
+                    continue;
+
+                if(_config.speed>0.0){
+                    const int64_t offset_ns = (int64_t)((double)(int64_t)(f.timestamp_ns-trace_start_ns)/_config.speed);
+                    const int64_t deadline_ns = start_ns + max<int64_t>(offset_ns, 0);
+                    timespec deadline {deadline_ns/1000000000LL, deadline_ns%1000000000LL};
+                    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr)==EINTR) {}
+                    r.max_late_ns = max(r.max_late_ns, _monotonic_ns()-deadline_ns);
+                }
+
+                unsigned int flags = (f.flags & FRAME_EXTENDED) ? canMSG_EXT : canMSG_STD;
+                if(f.flags & FRAME_RTR)
+                    flags |= canMSG_RTR;
+                canStatus stat;
+                while((stat = canWrite(_handle, f.id, (void*)f.data, f.dlc, flags))==canERR_TXBUFOFL && !stop.load(memory_order_relaxed))
+                    canWriteSync(_handle, 10);
+                if(stat==canOK)
+                    r.frames++;
+                else
+                    r.errors++;
+            }
+        } while(_config.loop && !stop.load());
+
+        canWriteSync(_handle, 1000);
+        return r;
+    }
+
+} /* namespace */
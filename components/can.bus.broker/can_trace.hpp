@@ -0,0 +1,185 @@
+/**
+ * @file can_trace.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Binary CAN trace (fixed size records with a time/id index) : writer, reader, channel recorder and replayer
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_CAN_BUS_BROKER_CAN_TRACE_HPP_INCLUDED
+#define FLAME_CAN_BUS_BROKER_CAN_TRACE_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "can_bus_broker.hpp"
+
+using namespace std;
+
+namespace canbus {
+
+    /*
+     * trace file :
+     *   trace_header (64 bytes)
+     *   frame records (32 bytes each, in receive order)
+     *   time index (trace_time_entry, one per index_interval records)
+     *   id index (trace_id_entry, one per id, sorted)
+     * a trace which was not closed (index_offset 0) is still readable, its records are counted from the file size.
+     */
+    struct trace_header {
+        uint32_t magic {0x30525443};    /* "CTR0" */
+        uint16_t version {1};
+        uint16_t record_size {sizeof(frame)};
+        int32_t channel {0};
+        uint32_t bitrate {0};
+        uint64_t start_ns {0};          /* system clock at the start of the recording */
+        uint64_t n_records {0};
+        uint64_t index_offset {0};      /* 0 : not closed */
+        uint32_t index_interval {1024};
+        uint32_t n_time_entries {0};
+        uint32_t n_id_entries {0};
+        uint8_t reserved[12] {};
+    };
+    static_assert(sizeof(trace_header)==64, "trace header must be 64 bytes");
+    static_assert(sizeof(frame)==32, "trace record must be 32 bytes");
+
+    struct trace_time_entry {
+        uint64_t timestamp_ns {0};
+        uint64_t record {0};
+    };
+
+    struct trace_id_entry {
+        uint32_t id {0};                /* with bit 31 set for an extended id */
+        uint32_t reserved {0};
+        uint64_t count {0};
+        uint64_t first_record {0};
+    };
+
+    /**
+     * @brief buffered trace file writer (single thread).
+     */
+    class trace_writer {
+        public:
+            trace_writer() = default;
+            ~trace_writer() { close(); }
+
+            bool open(const string& path, int channel, unsigned long bitrate, uint32_t index_interval = 1024);
+            bool write(const frame& f);
+            bool close();               /* flush, append the indexes and finalize the header */
+
+            bool is_open() const { return _fd>=0; }
+            uint64_t get_records() const { return _header.n_records; }
+
+        private:
+            bool _flush();
+
+        private:
+            int _fd {-1};
+            trace_header _header;
+            vector<frame> _buffer;
+            vector<trace_time_entry> _time_index;
+            vector<trace_id_entry> _id_index;   /* sorted by id */
+    };
+
+    /**
+     * @brief memory mapped trace file.
+     */
+    class trace_reader {
+        public:
+            trace_reader() = default;
+            ~trace_reader() { close(); }
+
+            bool open(const string& path);
+            void close();
+
+            const trace_header& get_header() const { return _header; }
+            size_t size() const { return _n_records; }
+            const frame* frames() const { return _frames; }
+            const frame& operator[](size_t i) const { return _frames[i]; }
+
+            /* first record at or after a timestamp (time index, then a search within one interval) */
+            size_t seek(uint64_t timestamp_ns) const;
+
+            /* per id counts (empty for a trace that was not closed) */
+            const trace_id_entry* id_index() const { return _id_index; }
+            size_t id_index_size() const { return _n_id_entries; }
+
+        private:
+            void* _map {nullptr};
+            size_t _map_size {0};
+            trace_header _header;
+            const frame* _frames {nullptr};
+            size_t _n_records {0};
+            const trace_time_entry* _time_index {nullptr};
+            size_t _n_time_entries {0};
+            const trace_id_entry* _id_index {nullptr};
+            size_t _n_id_entries {0};
+    };
+
+    /**
+     * @brief records a broker channel (all ids, received and transmitted) into a trace file from its own thread.
+     */
+    class trace_recorder {
+        public:
+            trace_recorder() = default;
+            ~trace_recorder() { stop(); }
+
+            bool start(const shared_ptr<channel>& can, const string& path, const string& name = "trace");
+            void stop();
+
+            uint64_t get_records() const { return _records.load(); }
+            uint64_t get_dropped() const { return _subscription ? _subscription->get_dropped() : 0; }
+
+        private:
+            void _task();
+
+        private:
+            shared_ptr<channel> _can;
+            subscription* _subscription {nullptr};
+            trace_writer _writer;
+            thread _worker;
+            atomic<bool> _stop {false};
+            atomic<uint64_t> _records {0};
+    };
+
+    /**
+     * @brief writes the frames of a trace to a CAN channel (usually a Kvaser virtual channel) with their original timing.
+     */
+    class trace_player {
+        public:
+            struct config {
+                int channel {0};
+                unsigned long bitrate {500000};
+                double speed {1.0};             /* time scale, 0 : as fast as possible */
+                bool transmitted {false};       /* also replay the frames recorded as sent by the recorder process */
+                bool loop {false};
+            };
+
+            struct result {
+                uint64_t frames {0};
+                uint64_t errors {0};
+                int64_t max_late_ns {0};        /* worst lateness against the scaled trace time */
+            };
+
+            explicit trace_player(const config& conf):_config(conf) {}
+            ~trace_player();
+
+            bool open(string& error);
+
+            /* replay records [first, last) of a trace, returns when done or when stop is set */
+            result play(const trace_reader& trace, size_t first, size_t last, const atomic<bool>& stop);
+
+        private:
+            config _config;
+            canHandle _handle {canINVALID_HANDLE};
+    };
+
+} /* namespace */
+
+#endif
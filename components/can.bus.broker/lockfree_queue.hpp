@@ -0,0 +1,141 @@
+/**
+ * @file lockfree_queue.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Bounded lock-free queues of the CAN bus broker (single producer ring for RX fan-out, multi producer queue for TX)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_CAN_BUS_BROKER_LOCKFREE_QUEUE_HPP_INCLUDED
+#define FLAME_CAN_BUS_BROKER_LOCKFREE_QUEUE_HPP_INCLUDED
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+namespace canbus {
+
+    /* capacity rounded up to a power of two */
+    inline size_t queue_capacity(size_t capacity){
+        size_t n = 2;
+        while(n<capacity)
+            n <<= 1;
+        return n;
+    }
+
+    /**
+     * @brief single producer / single consumer ring. push and pop never block, push fails when full.
+     */
+    template<typename T>
+    class spsc_queue {
+        public:
+            explicit spsc_queue(size_t capacity):_mask(queue_capacity(capacity)-1), _items(new T[_mask+1]) {}
+
+            bool push(const T& item){
+                const size_t head = _head.load(memory_order_relaxed);
+                if(head-_tail_cache>_mask){
+                    _tail_cache = _tail.load(memory_order_acquire);
+                    if(head-_tail_cache>_mask)
+                        return false;
+                }
+                _items[head&_mask] = item;
+                _head.store(head+1, memory_order_release);
+                return true;
+            }
+
+            bool pop(T& item){
+                const size_t tail = _tail.load(memory_order_relaxed);
+                if(tail==_head_cache){
+                    _head_cache = _head.load(memory_order_acquire);
+                    if(tail==_head_cache)
+                        return false;
+                }
+                item = _items[tail&_mask];
+                _tail.store(tail+1, memory_order_release);
+                return true;
+            }
+
+            size_t size() const { return _head.load(memory_order_acquire)-_tail.load(memory_order_acquire); }
+            size_t capacity() const { return _mask+1; }
+
+        private:
+            const size_t _mask;
+            unique_ptr<T[]> _items;
+            alignas(64) atomic<size_t> _head {0};   /* producer */
+            size_t _tail_cache {0};
+            alignas(64) atomic<size_t> _tail {0};   /* consumer */
+            size_t _head_cache {0};
+    };
+
+    /**
+     * @brief multi producer / multi consumer bounded queue (per-cell sequence numbers, D. Vyukov).
+     * push and pop never block, push fails when full.
+     */
+    template<typename T>
+    class mpmc_queue {
+        public:
+            explicit mpmc_queue(size_t capacity):_mask(queue_capacity(capacity)-1), _cells(new cell[_mask+1]) {
+                for(size_t i=0;i<=_mask;i++)
+                    _cells[i].sequence.store(i, memory_order_relaxed);
+            }
+
+            bool push(const T& item){
+                size_t pos = _head.load(memory_order_relaxed);
+                for(;;){
+                    cell& c = _cells[pos&_mask];
+                    const size_t seq = c.sequence.load(memory_order_acquire);
+                    const intptr_t diff = (intptr_t)seq-(intptr_t)pos;
+                    if(diff==0){
+                        if(_head.compare_exchange_weak(pos, pos+1, memory_order_relaxed)){
+                            c.item = item;
+                            c.sequence.store(pos+1, memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if(diff<0)
+                        return false;
+                    else
+                        pos = _head.load(memory_order_relaxed);
+                }
+            }
+
+            bool pop(T& item){
+                size_t pos = _tail.load(memory_order_relaxed);
+                for(;;){
+                    cell& c = _cells[pos&_mask];
+                    const size_t seq = c.sequence.load(memory_order_acquire);
+                    const intptr_t diff = (intptr_t)seq-(intptr_t)(pos+1);
+                    if(diff==0){
+                        if(_tail.compare_exchange_weak(pos, pos+1, memory_order_relaxed)){
+                            item = c.item;
+                            c.sequence.store(pos+_mask+1, memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if(diff<0)
+                        return false;
+                    else
+                        pos = _tail.load(memory_order_relaxed);
+                }
+            }
+
+        private:
+            struct cell {
+                atomic<size_t> sequence;
+                T item;
+            };
+            const size_t _mask;
+            unique_ptr<cell[]> _cells;
+            alignas(64) atomic<size_t> _head {0};
+            alignas(64) atomic<size_t> _tail {0};
+    };
+
+} /* namespace */
+
+#endif
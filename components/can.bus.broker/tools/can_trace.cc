@@ -0,0 +1,226 @@
+/**
+ * @file can_trace.cc
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief CAN trace tool : record a channel, replay a trace onto a (virtual) channel, print a trace summary, import APROS text logs
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage : can_trace record <channel> <bitrate> <trace file> [seconds]
+ *         can_trace replay <trace file> <channel> [speed (0 : as fast as possible)] [--tx] [--loop]
+ *         can_trace info <trace file>
+ *         can_trace import <mobile_can.txt> <trace file> [bitrate]
+ */
+
+#include "../can_trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+using namespace std;
+
+static atomic<bool> _stop {false};
+static void _on_signal(int){ _stop.store(true); }
+
+static int _usage(){
+    fprintf(stderr, "usage : can_trace record <channel> <bitrate> <trace file> [seconds]\n"
+                    "        can_trace replay <trace file> <channel> [speed] [--tx] [--loop]\n"
+                    "        can_trace info <trace file>\n"
+                    "        can_trace import <mobile_can.txt> <trace file> [bitrate]\n");
+    return 2;
+}
+
+static int _record(int argc, char** argv){
+    if(argc<5)
+        return _usage();
+
+    canbus::channel_config config;
+    config.channel = atoi(argv[2]);
+    config.bitrate = strtoul(argv[3], nullptr, 10);
+    const double seconds = (argc>5) ? atof(argv[5]) : 0.0;
+
+    string error;
+    shared_ptr<canbus::channel> can = canbus::channel::open(config, error);
+    if(!can){
+        fprintf(stderr, "CAN channel %d open failed : %s\n", config.channel, error.c_str());
+        return 1;
+    }
+
+    canbus::trace_recorder recorder;
+    if(!recorder.start(can, argv[4])){
+        fprintf(stderr, "cannot record into %s\n", argv[4]);
+        return 1;
+    }
+
+    const auto t0 = chrono::steady_clock::now();
+    while(!_stop.load()){
+        this_thread::sleep_for(chrono::milliseconds(100));
+        if(seconds>0.0 && chrono::duration<double>(chrono::steady_clock::now()-t0).count()>=seconds)
+            break;
+    }
+    const uint64_t dropped = recorder.get_dropped();
+    recorder.stop();
+    printf("recorded %llu frames (%llu dropped) into %s\n", (unsigned long long)recorder.get_records(), (unsigned long long)dropped, argv[4]);
+    return dropped==0 ? 0 : 1;
+}
+
+static int _replay(int argc, char** argv){
+    if(argc<4)
+        return _usage();
+
+    canbus::trace_reader trace;
+    if(!trace.open(argv[2])){
+        fprintf(stderr, "cannot read trace %s\n", argv[2]);
+        return 1;
+    }
+
+    canbus::trace_player::config config;
+    config.channel = atoi(argv[3]);
+    config.bitrate = trace.get_header().bitrate ? trace.get_header().bitrate : 500000;
+    for(int i=4;i<argc;i++){
+        if(!strcmp(argv[i], "--tx"))
+            config.transmitted = true;
+        else if(!strcmp(argv[i], "--loop"))
+            config.loop = true;
+        else
+            config.speed = atof(argv[i]);
+    }
+
+    canbus::trace_player player(config);
+    string error;
+    if(!player.open(error)){
+        fprintf(stderr, "CAN channel %d open failed : %s\n", config.channel, error.c_str());
+        return 1;
+    }
+
+    const auto t0 = chrono::steady_clock::now();
+    canbus::trace_player::result r = player.play(trace, 0, trace.size(), _stop);
+    const double elapsed = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    printf("replayed %llu frames (%llu errors) in %.3f s, %.0f frames/s, max late %.3f ms\n",
+            (unsigned long long)r.frames, (unsigned long long)r.errors, elapsed, (elapsed>0.0) ? r.frames/elapsed : 0.0, r.max_late_ns/1e6);
+    return r.errors==0 ? 0 : 1;
+}
+
+static int _info(int argc, char** argv){
+    if(argc<3)
+        return _usage();
+
+    canbus::trace_reader trace;
+    if(!trace.open(argv[2])){
+        fprintf(stderr, "cannot read trace %s\n", argv[2]);
+        return 1;
+    }
+
+    const canbus::trace_header& h = trace.get_header();
+    const time_t start = (time_t)(h.start_ns/1000000000ULL);
+    char start_str[32] = {0, };
+    strftime(start_str, sizeof(start_str), "%Y-%m-%d %H:%M:%S", localtime(&start));
+    printf("channel   : %d (%u bps)\n", h.channel, h.bitrate);
+    printf("started   : %s\n", start_str);
+    printf("records   : %zu%s\n", trace.size(), h.index_offset ? "" : " (not closed, no index)");
+    if(trace.size()>0){
+        const double duration = (double)(trace[trace.size()-1].timestamp_ns-trace[0].timestamp_ns)/1e9;
+        printf("duration  : %.3f s (%.0f frames/s)\n", duration, (duration>0.0) ? trace.size()/duration : 0.0);
+    }
+
+    for(size_t i=0;i<trace.id_index_size();i++){
+        const canbus::trace_id_entry& e = trace.id_index()[i];
+        const uint32_t id = e.id & 0x7FFFFFFF;
+        if(e.id & 0x80000000)
+            printf("  0x%08X : %10llu frames\n", id, (unsigned long long)e.count);
+        else
+            printf("  0x%03X      : %10llu frames\n", id, (unsigned long long)e.count);
+    }
+    return 0;
+}
+
+/* APROS raw log line : "[YYYY-mm-dd HH:MM:SS.mmm] ID: 0x301 | Data: AA BB ..." (local time) */
+static bool _parse_apros_line(const char* line, canbus::frame& f){
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    int ms = 0;
+    unsigned int id = 0;
+    int consumed = 0;
+    if(sscanf(line, "[%d-%d-%d %d:%d:%d.%d] ID: 0x%x | Data:%n", &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour, &t.tm_min, &t.tm_sec, &ms, &id, &consumed)!=8 || consumed==0)
+        return false;
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    t.tm_isdst = -1;
+    const time_t seconds = mktime(&t);
+    if(seconds<0)
+        return false;
+
+    f = canbus::frame();
+    f.id = id;
+    f.flags = (id>0x7FF) ? canbus::FRAME_EXTENDED : 0;
+    f.timestamp_ns = (uint64_t)seconds*1000000000ULL + (uint64_t)ms*1000000ULL;
+    const char* p = line+consumed;
+    char* end = nullptr;
+    while(f.dlc<8){
+        const unsigned long byte = strtoul(p, &end, 16);
+        if(end==p)
+            break;
+        f.data[f.dlc++] = (uint8_t)byte;
+        p = end;
+    }
+    return true;
+}
+
+static int _import(int argc, char** argv){
+    if(argc<4)
+        return _usage();
+
+    FILE* in = fopen(argv[2], "r");
+    if(!in){
+        fprintf(stderr, "cannot read %s\n", argv[2]);
+        return 1;
+    }
+    canbus::trace_writer writer;
+    if(!writer.open(argv[3], -1, (argc>4) ? strtoul(argv[4], nullptr, 10) : 500000)){
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        fclose(in);
+        return 1;
+    }
+
+    char line[256];
+    size_t skipped = 0;
+    canbus::frame f;
+    while(fgets(line, sizeof(line), in)){
+        if(_parse_apros_line(line, f))
+            writer.write(f);
+        else
+            skipped++;
+    }
+    fclose(in);
+    const uint64_t records = writer.get_records();
+    if(!writer.close()){
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        return 1;
+    }
+    printf("imported %llu frames (%zu lines skipped) into %s\n", (unsigned long long)records, skipped, argv[3]);
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if(argc<2)
+        return _usage();
+
+    signal(SIGINT, _on_signal);
+    signal(SIGTERM, _on_signal);
+
+    if(!strcmp(argv[1], "record"))
+        return _record(argc, argv);
+    if(!strcmp(argv[1], "replay"))
+        return _replay(argc, argv);
+    if(!strcmp(argv[1], "info"))
+        return _info(argc, argv);
+    if(!strcmp(argv[1], "import"))
+        return _import(argc, argv);
+    return _usage();
+}
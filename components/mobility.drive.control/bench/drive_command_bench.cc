@@ -0,0 +1,67 @@
+/**
+ * @file drive_command_bench.cc
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Drive command ingress cost (binary drive_command decode + sequence check vs. JSON parse)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage : drive_command_bench [iterations]
+ */
+
+#include "../drive_command.hpp"
+#include <json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+using json = nlohmann::json;
+
+int main(int argc, char** argv){
+    const size_t iterations = (argc>1) ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+    /* binary : decode and sequence check of consecutive commands */
+    s1_driver::drive_command command;
+    command.speed_kmh = 2.5f;
+    command.angle_deg = -7.5f;
+    char buffer[sizeof(command)];
+    s1_driver::command_sequencer sequencer;
+    size_t accepted = 0;
+    double binary_check = 0.0;
+    auto t0 = chrono::steady_clock::now();
+    for(size_t i=0;i<iterations;i++){
+        command.sequence = (uint32_t)i;
+        memcpy(buffer, &command, sizeof(command));
+        s1_driver::drive_command decoded;
+        if(s1_driver::is_drive_command(buffer, sizeof(buffer))
+            && s1_driver::decode(buffer, sizeof(buffer), decoded)==s1_driver::command_status::accepted
+            && sequencer.check(decoded, 0)==s1_driver::command_status::accepted){
+            accepted++;
+            binary_check += decoded.speed_kmh + decoded.angle_deg;
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    const double binary_ns = chrono::duration<double, nano>(t1-t0).count()/(double)iterations;
+
+    /* JSON : the previous ingress (parse, command lookup, two values) */
+    const string text = "{\"command\":\"drive\",\"angle\":-7.5,\"velocity\":2.5}";
+    double json_check = 0.0;
+    t0 = chrono::steady_clock::now();
+    for(size_t i=0;i<iterations;i++){
+        json j = json::parse(text.data(), text.data()+text.size());
+        if(j.contains("command") && j["command"]=="drive")
+            json_check += j["angle"].get<float>() + j["velocity"].get<float>();
+    }
+    t1 = chrono::steady_clock::now();
+    const double json_ns = chrono::duration<double, nano>(t1-t0).count()/(double)iterations;
+
+    printf("commands           : %zu (%zu accepted)\n", iterations, accepted);
+    printf("binary             : %8.1f ns/command\n", binary_ns);
+    printf("JSON               : %8.1f ns/command\n", json_ns);
+    printf("speedup            : %8.1f x\n", json_ns/binary_ns);
+    printf("(checks %g %g)\n", binary_check, json_check);
+    return accepted==iterations ? 0 : 1;
+}
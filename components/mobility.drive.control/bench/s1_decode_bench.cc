@@ -0,0 +1,100 @@
+/**
+ * @file s1_decode_bench.cc
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief S1 CAN1 decode throughput (S1Driver::parse with the state snapshot vs. the bare DBC decoder)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage : s1_decode_bench [trace file (can_trace record)] [passes]
+ *         without a trace, one second of vehicle traffic is synthesized from the DBC cycle times
+ */
+
+#include "../s1_driver.hpp"
+#include "../../can.bus.broker/can_trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/* frames sent by the vehicle (not by the ADU), each at its cycle time for one second */
+static vector<canbus::frame> _synthesize(){
+    vector<canbus::frame> frames;
+    mt19937 rng(1);
+    for(uint64_t t_ms=0;t_ms<1000;t_ms++){
+        for(size_t i=0;i<s1_can1::n_messages;i++){
+            const dbc::message_info& m = s1_can1::messages[i];
+            if(string(m.transmitter)=="ADU" || m.cycle_ms==0 || t_ms%m.cycle_ms!=0)
+                continue;
+            canbus::frame f;
+            f.id = m.id;
+            f.dlc = m.dlc;
+            f.flags = m.extended ? canbus::FRAME_EXTENDED : 0;
+            f.timestamp_ns = t_ms*1000000ULL;
+            for(uint8_t b=0;b<f.dlc;b++)
+                f.data[b] = (uint8_t)rng();
+            frames.push_back(f);
+        }
+    }
+    return frames;
+}
+
+int main(int argc, char** argv){
+    vector<canbus::frame> frames;
+    canbus::trace_reader trace;
+    if(argc>1){
+        if(!trace.open(argv[1])){
+            fprintf(stderr, "cannot read trace %s\n", argv[1]);
+            return 1;
+        }
+        frames.assign(trace.frames(), trace.frames()+trace.size());
+    }
+    else
+        frames = _synthesize();
+    const size_t passes = (argc>2) ? strtoul(argv[2], nullptr, 10) : 1000;
+    if(frames.empty()){
+        fprintf(stderr, "no frames\n");
+        return 1;
+    }
+    const size_t n_frames = frames.size()*passes;
+
+    /* driver parse : decode + timestamps + seqlock snapshot store */
+    s1_driver::S1Driver driver;
+    size_t decoded = 0;
+    auto t0 = chrono::steady_clock::now();
+    for(size_t p=0;p<passes;p++)
+        for(const canbus::frame& f:frames)
+            decoded += driver.parse(f.id, f.data, f.dlc, f.timestamp_ns)!=nullptr;
+    auto t1 = chrono::steady_clock::now();
+    const double parse_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_frames;
+
+    /* bare generated decoder */
+    s1_can1::bus bus;
+    size_t decoded_bare = 0;
+    t0 = chrono::steady_clock::now();
+    for(size_t p=0;p<passes;p++)
+        for(const canbus::frame& f:frames)
+            decoded_bare += bus.decode(f.id, f.data, f.dlc)!=nullptr;
+    t1 = chrono::steady_clock::now();
+    const double decode_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_frames;
+
+    /* snapshot read (what the control and status paths pay) */
+    const size_t n_reads = passes*100;
+    double check = 0.0;
+    t0 = chrono::steady_clock::now();
+    for(size_t i=0;i<n_reads;i++)
+        check += driver.get_state().get_vehicle_speed();
+    t1 = chrono::steady_clock::now();
+    const double read_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_reads;
+
+    printf("frames             : %zu x %zu passes (%zu decoded, %zu not in the DBC)\n", frames.size(), passes, decoded/passes, frames.size()-decoded/passes);
+    printf("S1Driver::parse    : %8.1f ns/frame (%.2f M frames/s)\n", parse_ns, 1e3/parse_ns);
+    printf("bus.decode         : %8.1f ns/frame (%.2f M frames/s)\n", decode_ns, 1e3/decode_ns);
+    printf("get_state          : %8.1f ns/read\n", read_ns);
+    printf("(checks %zu %g %llu)\n", decoded_bare, check, (unsigned long long)driver.get_state_version());
+    return 0;
+}
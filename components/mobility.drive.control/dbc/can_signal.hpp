@@ -0,0 +1,106 @@
+#ifndef FLAME_MOBILITY_DRIVE_CONTROL_CAN_SIGNAL_HPP_INCLUDED
+#define FLAME_MOBILITY_DRIVE_CONTROL_CAN_SIGNAL_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+// Runtime support of the DBC generated code (dbc2cpp.py).
+// A frame (up to 8 bytes) is loaded once as a little-endian word and its byte-swapped copy:
+// an Intel (@1) signal is a shift and mask of the first word, a Motorola (@0) signal a shift and mask of the second.
+// All positions are compile-time constants, so extract/insert have no branch.
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the DBC frame word assumes a little-endian host");
+
+namespace dbc {
+
+struct signal_info {
+    const char* name;
+    uint8_t start;          // DBC start bit (LSB for Intel, MSB for Motorola)
+    uint8_t length;
+    bool big_endian;        // Motorola (@0)
+    bool is_signed;
+    double factor;
+    double offset;
+    double minimum;
+    double maximum;
+    const char* unit;
+};
+
+struct message_info {
+    uint32_t id;
+    bool extended;
+    uint8_t dlc;
+    uint16_t cycle_ms;      // 0 : not cyclic
+    const char* name;
+    const char* transmitter;    // sending node
+    const signal_info* signals;
+    size_t n_signals;
+};
+
+inline uint64_t load(const uint8_t* data, size_t length) {
+    uint64_t word = 0;
+    std::memcpy(&word, data, length < 8 ? length : 8);
+    return word;
+}
+
+inline void store(uint64_t word, uint8_t* data) {
+    std::memcpy(data, &word, 8);
+}
+
+inline uint64_t swap(uint64_t word) {
+    return __builtin_bswap64(word);
+}
+
+constexpr uint64_t mask(unsigned length) {
+    return length >= 64 ? ~0ULL : ((1ULL << length) - 1);
+}
+
+// position of the signal LSB in its frame word
+constexpr unsigned shift(unsigned start, unsigned length, bool big_endian) {
+    return big_endian ? 64 - ((start / 8) * 8 + (7 - start % 8) + length) : start;
+}
+
+template <unsigned START, unsigned LENGTH, bool MOTOROLA, bool IS_SIGNED>
+inline int64_t extract(uint64_t le, uint64_t be) {
+    constexpr unsigned s = shift(START, LENGTH, MOTOROLA);
+    const uint64_t raw = ((MOTOROLA ? be : le) >> s) & mask(LENGTH);
+    if constexpr (IS_SIGNED && LENGTH < 64)
+        return (int64_t)(raw << (64 - LENGTH)) >> (64 - LENGTH);
+    else
+        return (int64_t)raw;
+}
+
+template <unsigned START, unsigned LENGTH, bool MOTOROLA>
+inline void insert(uint64_t& le, uint64_t& be, int64_t raw) {
+    constexpr unsigned s = shift(START, LENGTH, MOTOROLA);
+    uint64_t& word = MOTOROLA ? be : le;
+    word = (word & ~(mask(LENGTH) << s)) | (((uint64_t)raw & mask(LENGTH)) << s);
+}
+
+// physical value to raw, clamped to the DBC range (if any) and to the raw range
+template <unsigned LENGTH, bool IS_SIGNED>
+inline int64_t to_raw(double value, double factor, double offset, double minimum, double maximum) {
+    if (minimum < maximum)
+        value = value < minimum ? minimum : (value > maximum ? maximum : value);
+    double raw = std::round((value - offset) / factor);
+    constexpr double lo = IS_SIGNED ? -(double)(1ULL << (LENGTH - 1)) : 0.0;
+    constexpr double hi = IS_SIGNED ? (double)((1ULL << (LENGTH - 1)) - 1) : (double)mask(LENGTH);
+    raw = raw < lo ? lo : (raw > hi ? hi : raw);
+    return (int64_t)raw;
+}
+
+// table-driven decode of one signal (generic tools : logging, tracing)
+inline double decode(const signal_info& signal, uint64_t le, uint64_t be) {
+    const unsigned s = shift(signal.start, signal.length, signal.big_endian);
+    uint64_t raw = ((signal.big_endian ? be : le) >> s) & mask(signal.length);
+    int64_t value = (int64_t)raw;
+    if (signal.is_signed && signal.length < 64)
+        value = (int64_t)(raw << (64 - signal.length)) >> (64 - signal.length);
+    return (double)value * signal.factor + signal.offset;
+}
+
+} // namespace dbc
+
+#endif
@@ -0,0 +1,279 @@
+#!/usr/bin/env python3
+"""
+dbc2cpp.py - Generate a C++ header (constexpr signal tables, branch-free decode/encode per message) from a DBC file.
+
+Usage:
+  python3 dbc2cpp.py <input.dbc> <output.hpp> --namespace s1_can1
+
+The output is regenerated by the Makefile whenever the DBC changes; it is not meant to be edited.
+"""
+
+import re
+import sys
+import os
+import argparse
+
+
+RE_MESSAGE = re.compile(r"^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)")
+RE_SIGNAL = re.compile(
+    r"^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*"
+    r"\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*\"([^\"]*)\"\s*(.*)$"
+)
+RE_CYCLE = re.compile(r"^BA_\s+\"GenMsgCycleTime\"\s+BO_\s+(\d+)\s+(\d+)\s*;")
+RE_VALUES = re.compile(r"^VAL_\s+(\d+)\s+(\w+)\s+(.*);")
+RE_VALUE_ITEM = re.compile(r"(-?\d+)\s+\"([^\"]*)\"")
+
+# pseudo message holding the unused signals (Vector CANdb++)
+INDEPENDENT_SIGNALS_ID = 3221225472
+
+
+def parse_dbc(path: str):
+    """Returns the messages (sorted by id) with their signals, cycle times and value descriptions."""
+    messages = {}
+    current = None
+
+    # DBC files are usually written in a local code page (units, comments), only ASCII is used
+    with open(path, "r", encoding="latin-1") as f:
+        for raw_line in f:
+            line = raw_line.strip()
+            if not line:
+                current = None
+                continue
+
+            m = RE_MESSAGE.match(line)
+            if m:
+                frame_id = int(m.group(1))
+                if frame_id == INDEPENDENT_SIGNALS_ID:
+                    current = None
+                    continue
+                current = {
+                    "id": frame_id & 0x1FFFFFFF,
+                    "extended": bool(frame_id & 0x80000000),
+                    "name": m.group(2),
+                    "dlc": int(m.group(3)),
+                    "transmitter": m.group(4),
+                    "cycle_ms": 0,
+                    "signals": [],
+                }
+                messages[frame_id] = current
+                continue
+
+            m = RE_SIGNAL.match(line)
+            if m:
+                if current is None:
+                    continue
+                current["signals"].append({
+                    "name": m.group(1),
+                    "multiplex": m.group(2) or "",
+                    "start": int(m.group(3)),
+                    "length": int(m.group(4)),
+                    "big_endian": m.group(5) == "0",
+                    "signed": m.group(6) == "-",
+                    "factor": float(m.group(7)),
+                    "offset": float(m.group(8)),
+                    "minimum": float(m.group(9) or 0),
+                    "maximum": float(m.group(10) or 0),
+                    "unit": m.group(11) if m.group(11).isascii() and m.group(11).isprintable() else "",
+                    "values": [],
+                })
+                continue
+
+            m = RE_CYCLE.match(line)
+            if m and int(m.group(1)) in messages:
+                messages[int(m.group(1))]["cycle_ms"] = int(m.group(2))
+                continue
+
+            m = RE_VALUES.match(line)
+            if m and int(m.group(1)) in messages:
+                for signal in messages[int(m.group(1))]["signals"]:
+                    if signal["name"] == m.group(2):
+                        signal["values"] = [(int(v), d) for v, d in RE_VALUE_ITEM.findall(m.group(3))]
+
+    for message in messages.values():
+        for signal in message["signals"]:
+            check_layout(message, signal)
+    return sorted(messages.values(), key=lambda message: message["id"])
+
+
+def check_layout(message, signal):
+    """Rejects a signal that does not fit in the 8 byte frame word."""
+    start, length = signal["start"], signal["length"]
+    if signal["big_endian"]:
+        msb = (start // 8) * 8 + (7 - start % 8)
+        fits = msb + length <= 64
+    else:
+        fits = start + length <= 64
+    if length < 1 or not fits:
+        raise ValueError(f"{message['name']}.{signal['name']} : {start}|{length} does not fit in 64 bits")
+
+
+def identifier(text: str) -> str:
+    name = re.sub(r"\W", "_", text.strip())
+    if not name or name[0].isdigit():
+        name = "_" + name
+    return name
+
+
+def literal(value: float) -> str:
+    text = repr(float(value))
+    return text if ("." in text or "e" in text or "inf" in text) else text + ".0"
+
+
+def generate(messages, namespace: str, source: str) -> str:
+    out = []
+    guard = f"FLAME_MOBILITY_DRIVE_CONTROL_{namespace.upper()}_HPP_INCLUDED"
+    out.append(f"// Generated by dbc2cpp.py from {source}, do not edit.")
+    out.append(f"#ifndef {guard}")
+    out.append(f"#define {guard}")
+    out.append("")
+    out.append("#include \"can_signal.hpp\"")
+    out.append("")
+    out.append(f"namespace {namespace} {{")
+    out.append("")
+
+    for message in messages:
+        name = message["name"]
+        signals = message["signals"]
+        any_motorola = any(s["big_endian"] for s in signals)
+        out.append(f"// {name} (0x{message['id']:X}, {message['dlc']} bytes, "
+                   f"{str(message['cycle_ms']) + ' ms' if message['cycle_ms'] else 'event'}, {message['transmitter']})")
+        out.append(f"struct {name} {{")
+        out.append(f"    static constexpr uint32_t id = 0x{message['id']:X};")
+        out.append(f"    static constexpr bool extended = {'true' if message['extended'] else 'false'};")
+        out.append(f"    static constexpr uint8_t dlc = {message['dlc']};")
+        out.append(f"    static constexpr uint16_t cycle_ms = {message['cycle_ms']};")
+        out.append("")
+
+        # value descriptions
+        for signal in signals:
+            used = set()
+            for value, description in signal["values"]:
+                constant = identifier(f"{signal['name']}_{description}")
+                if constant in used:
+                    continue
+                used.add(constant)
+                out.append(f"    static constexpr int {constant} = {value};")
+        if any(signal["values"] for signal in signals):
+            out.append("")
+
+        # physical values
+        for signal in signals:
+            layout = (f"{signal['start']}|{signal['length']}@{'0' if signal['big_endian'] else '1'}"
+                      f"{'-' if signal['signed'] else '+'} ({signal['factor']:g},{signal['offset']:g}) "
+                      f"[{signal['minimum']:g}|{signal['maximum']:g}]")
+            unit = f" {signal['unit']}" if signal["unit"] else ""
+            mux = f" multiplexed ({signal['multiplex']})" if signal["multiplex"] else ""
+            out.append(f"    double {signal['name']} {{0.0}}; // {layout}{unit}{mux}")
+        out.append("")
+
+        # decode
+        out.append("    bool decode(const uint8_t* data, size_t length) {")
+        out.append("        if (length < dlc) return false;")
+        if signals:
+            out.append("        const uint64_t le = dbc::load(data, length);")
+            out.append(f"        const uint64_t be = {'dbc::swap(le)' if any_motorola else '0'};")
+        for signal in signals:
+            template = (f"{signal['start']}, {signal['length']}, {'true' if signal['big_endian'] else 'false'}, "
+                        f"{'true' if signal['signed'] else 'false'}")
+            value = f"(double)dbc::extract<{template}>(le, be)"
+            if signal["factor"] != 1.0:
+                value += f" * {literal(signal['factor'])}"
+            if signal["offset"] != 0.0:
+                value += f" + {literal(signal['offset'])}"
+            out.append(f"        {signal['name']} = {value};")
+        out.append("        return true;")
+        out.append("    }")
+        out.append("")
+
+        # encode
+        out.append("    void encode(uint8_t* data) const {")
+        out.append("        uint64_t le = 0, be = 0;")
+        for signal in signals:
+            raw = (f"dbc::to_raw<{signal['length']}, {'true' if signal['signed'] else 'false'}>({signal['name']}, "
+                   f"{literal(signal['factor'])}, {literal(signal['offset'])}, "
+                   f"{literal(signal['minimum'])}, {literal(signal['maximum'])})")
+            out.append(f"        dbc::insert<{signal['start']}, {signal['length']}, "
+                       f"{'true' if signal['big_endian'] else 'false'}>(le, be, {raw});")
+        out.append(f"        dbc::store({'le | dbc::swap(be)' if any_motorola else 'le'}, data);")
+        out.append("    }")
+        out.append("};")
+        out.append("")
+
+        # signal table
+        out.append(f"static constexpr dbc::signal_info {name}_signals[] = {{")
+        for signal in signals:
+            out.append(f"    {{\"{signal['name']}\", {signal['start']}, {signal['length']}, "
+                       f"{'true' if signal['big_endian'] else 'false'}, {'true' if signal['signed'] else 'false'}, "
+                       f"{literal(signal['factor'])}, {literal(signal['offset'])}, "
+                       f"{literal(signal['minimum'])}, {literal(signal['maximum'])}, \"{signal['unit']}\"}},")
+        if not signals:
+            out.append("    {\"\", 0, 0, false, false, 1.0, 0.0, 0.0, 0.0, \"\"},")
+        out.append("};")
+        out.append("")
+
+    # message table (sorted by id)
+    out.append("static constexpr dbc::message_info messages[] = {")
+    for message in messages:
+        out.append(f"    {{0x{message['id']:X}, {'true' if message['extended'] else 'false'}, {message['dlc']}, "
+                   f"{message['cycle_ms']}, \"{message['name']}\", \"{message['transmitter']}\", "
+                   f"{message['name']}_signals, {len(message['signals'])}}},")
+    out.append("};")
+    out.append(f"static constexpr size_t n_messages = {len(messages)};")
+    out.append("")
+    out.append("constexpr const dbc::message_info* find(uint32_t id) {")
+    out.append("    size_t lo = 0, hi = n_messages;")
+    out.append("    while (lo < hi) {")
+    out.append("        size_t mid = (lo + hi) / 2;")
+    out.append("        if (messages[mid].id < id) lo = mid + 1;")
+    out.append("        else hi = mid;")
+    out.append("    }")
+    out.append("    return (lo < n_messages && messages[lo].id == id) ? &messages[lo] : nullptr;")
+    out.append("}")
+    out.append("")
+
+    # latest value of every message on the bus
+    out.append("// Latest decoded value of every message of the bus.")
+    out.append("struct bus {")
+    for message in messages:
+        out.append(f"    {message['name']} {message['name']}_;")
+    out.append("")
+    out.append("    // decode a received frame into its message, nullptr if the id is unknown or the frame too short")
+    out.append("    const dbc::message_info* decode(uint32_t id, const uint8_t* data, size_t length) {")
+    out.append("        switch (id) {")
+    for index, message in enumerate(messages):
+        out.append(f"            case 0x{message['id']:X}: return {message['name']}_.decode(data, length) ? &messages[{index}] : nullptr;")
+    out.append("            default: return nullptr;")
+    out.append("        }")
+    out.append("    }")
+    out.append("};")
+    out.append("")
+    out.append(f"}} // namespace {namespace}")
+    out.append("")
+    out.append("#endif")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a C++ CAN decoder/encoder header from a DBC file.")
+    parser.add_argument("dbc", help="Input DBC file")
+    parser.add_argument("output", help="Output header")
+    parser.add_argument("--namespace", required=True, help="C++ namespace of the generated code")
+    args = parser.parse_args()
+
+    try:
+        messages = parse_dbc(args.dbc)
+    except (OSError, ValueError) as e:
+        print(f"[dbc2cpp] {e}", file=sys.stderr)
+        return 1
+
+    text = generate(messages, identifier(args.namespace), os.path.basename(args.dbc))
+    with open(args.output, "w", encoding="utf-8") as f:
+        f.write(text)
+    print(f"[dbc2cpp] {args.dbc} -> {args.output} ({len(messages)} messages, "
+          f"{sum(len(m['signals']) for m in messages)} signals)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,93 @@
+#ifndef FLAME_MOBILITY_DRIVE_CONTROL_DRIVE_COMMAND_HPP_INCLUDED
+#define FLAME_MOBILITY_DRIVE_CONTROL_DRIVE_COMMAND_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Binary drive command (one message part, little-endian, 32 bytes).
+// A sender publishes the complete setpoint every cycle with an increasing sequence number;
+// the JSON commands ({"command":"drive", ...}) are still accepted on the same port.
+// Port : the "command" sub dataport (patroller profile : connects to 127.0.0.1:5302). The motion planner
+// (local planner output) binds a PUB socket there and sends [topic, command], the command being the last part.
+// Without commands the watchdog (command_timeout_ms) keeps the vehicle stopped.
+
+namespace s1_driver {
+
+struct drive_command {
+    uint32_t magic = 0x30435244;    // "DRC0"
+    uint16_t version = 1;
+    int8_t gear = -1;               // -1 : auto (from the speed sign), 1 : D, 2 : N, 3 : R
+    uint8_t flags = 0;              // reserved (0)
+    uint32_t sequence = 0;          // incremented by the sender for every command
+    float speed_kmh = 0.0f;         // signed with gear -1, magnitude otherwise
+    float angle_deg = 0.0f;         // steering angle, positive : left
+    uint32_t reserved = 0;
+    uint64_t deadline_ns = 0;       // not applied after this time (system clock), 0 : no deadline
+};
+static_assert(sizeof(drive_command) == 32, "drive_command must be 32 bytes");
+
+// 명령 검사 결과
+enum class command_status : uint8_t {
+    accepted,
+    malformed,      // wrong size / magic / version, or values out of range
+    duplicate,      // same sequence as the last accepted command
+    reordered,      // older than the last accepted command
+    expired         // deadline passed before the command was received
+};
+
+// decode one message part, false if it is not a binary drive command (JSON fallback)
+inline bool is_drive_command(const void* data, size_t size) {
+    uint32_t magic = 0;
+    if (size != sizeof(drive_command)) return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == drive_command().magic;
+}
+
+inline command_status decode(const void* data, size_t size, drive_command& command) {
+    if (!is_drive_command(data, size)) return command_status::malformed;
+    std::memcpy(&command, data, sizeof(command));
+    if (command.version != drive_command().version) return command_status::malformed;
+    if (!std::isfinite(command.speed_kmh) || !std::isfinite(command.angle_deg)) return command_status::malformed;
+    if (command.gear != -1 && (command.gear < 1 || command.gear > 3)) return command_status::malformed;
+    return command_status::accepted;
+}
+
+// Sequence and deadline check of the accepted commands (one thread : onData).
+// Sequence numbers are compared modulo 2^32. A command up to reorder_window behind the last
+// accepted one is late (reordered / duplicate); a bigger step back, or any command after
+// restart_ns without an accepted one, is taken as a restart of the sender.
+class command_sequencer {
+public:
+    static constexpr int32_t reorder_window = 1024;
+
+    explicit command_sequencer(uint64_t restart_ns = 1000000000) : restart_ns_(restart_ns) {}
+
+    command_status check(const drive_command& command, uint64_t now_ns) {
+        if (command.deadline_ns != 0 && now_ns > command.deadline_ns) return command_status::expired;
+        if (has_last_ && now_ns - last_ns_ <= restart_ns_) {
+            const int32_t step = (int32_t)(command.sequence - last_);
+            if (step == 0) return command_status::duplicate;
+            if (step < 0 && step > -reorder_window) return command_status::reordered;
+            if (step > 1) lost_ += (uint64_t)(step - 1);
+        }
+        last_ = command.sequence;
+        last_ns_ = now_ns;
+        has_last_ = true;
+        return command_status::accepted;
+    }
+
+    uint32_t last() const { return last_; }
+    uint64_t lost() const { return lost_; }     // sequence gaps (commands never received)
+
+private:
+    uint64_t restart_ns_;
+    uint64_t last_ns_ = 0;
+    uint32_t last_ = 0;
+    bool has_last_ = false;
+    uint64_t lost_ = 0;
+};
+
+} // namespace s1_driver
+
+#endif // FLAME_MOBILITY_DRIVE_CONTROL_DRIVE_COMMAND_HPP_INCLUDED
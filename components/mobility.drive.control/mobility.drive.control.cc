@@ -2,11 +2,43 @@
 #include <flame/log.hpp>
 #include <json.hpp>
 #include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
 
 using namespace flame;
 using namespace std;
 using json = nlohmann::json;
 
+static inline int64_t _to_ns(const timespec& t){
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static inline int64_t _monotonic_ns(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return _to_ns(t);
+}
+
+// below this the vehicle is taken as stopped (gear changes)
+static constexpr double gear_change_speed_kmh = 0.1;
+
+static inline uint64_t _system_ns(){
+    timespec t;
+    clock_gettime(CLOCK_REALTIME, &t);
+    return (uint64_t)_to_ns(t);
+}
+
+static inline timespec _to_timespec(int64_t ns){
+    timespec t;
+    t.tv_sec = ns / 1000000000LL;
+    t.tv_nsec = ns % 1000000000LL;
+    return t;
+}
+
 /* create component instance */
 static mobility_drive_control* _instance = nullptr;
 flame::component::Object* Create(){ if(!_instance) _instance = new mobility_drive_control(); return _instance; }
@@ -19,40 +51,59 @@ bool mobility_drive_control::onInit(){
         _can_channel = parameters.value("can_channel", 0);
         _max_speed_limit = parameters.value("max_speed_limit_kmh", 5.0f);
         _max_steering_angle = parameters.value("max_steering_angle_deg", 24.7f);
+        _control_rate_hz = std::clamp(parameters.value("control_rate_hz", 50), 1, 200);
+        _control_priority = std::clamp(parameters.value("control_priority", 0), 0, 99);
+        _control_cpu = parameters.value("control_cpu", -1);
+
+        // setpoint limits (chassis geometry from the profile)
+        s1_driver::shaper_limits limits;
+        limits.max_accel = parameters.value("max_accel_mps2", limits.max_accel);
+        limits.max_decel = parameters.value("max_decel_mps2", limits.max_decel);
+        limits.max_jerk = parameters.value("max_jerk_mps3", limits.max_jerk);
+        limits.timeout_decel = parameters.value("timeout_decel_mps2", limits.timeout_decel);
+        limits.max_steer_rate = parameters.value("max_steer_rate_dps", limits.max_steer_rate);
+        limits.max_lateral_accel = parameters.value("max_lateral_accel_mps2", limits.max_lateral_accel);
+        limits.max_steer_angle = _max_steering_angle;
+        limits.wheelbase = parameters.value("wheelbase_mm", 1150.0) * 1e-3;
+        limits.min_turning_radius = parameters.value("min_turning_radius_m", 2.5);
+        _shaper.set_limits(limits);
+        _command_timeout_ns = (int64_t)(parameters.value("command_timeout_ms", 300.0) * 1e6);
 
-        canInitializeLibrary();
-        _can_handle = canOpenChannel(_can_channel, canOPEN_ACCEPT_VIRTUAL);
-        if(_can_handle < 0){
-            char err[512] = {0,};
-            canGetErrorText((canStatus)_can_handle, err, sizeof(err));
-            logger::error("[{}] Failed to open CAN Channel : {}", getName(), err);
+        // the CAN channel is shared with the other components of the process (can.bus.broker)
+        canbus::channel_config can_config;
+        can_config.channel = _can_channel;
+        can_config.bitrate = parameters.value("can_bitrate", 500000UL);
+        can_config.timer_scale_us = parameters.value("can_timer_scale_us", 10UL);
+        std::string error;
+        _can = canbus::channel::open(can_config, error);
+        if(!_can){
+            logger::error("[{}] Failed to open CAN Channel : {}", getName(), error);
             return false;
         }
 
-        unsigned long bitrate = parameters.value("can_bitrate", 500000);
-        canStatus stat;
-        switch(bitrate){
-            case 1000000: stat = canSetBusParams(_can_handle, canBITRATE_1M, 0, 0, 0, 0, 0); break;
-            case 500000: stat = canSetBusParams(_can_handle, canBITRATE_500K, 0, 0, 0, 0, 0); break;
-            case 250000: stat = canSetBusParams(_can_handle, canBITRATE_250K, 0, 0, 0, 0, 0); break;
-            case 125000: stat = canSetBusParams(_can_handle, canBITRATE_125K, 0, 0, 0, 0, 0); break;
-            default:      stat = canSetBusParams(_can_handle, canBITRATE_500K, 0, 0, 0, 0, 0); break;
+        // feedback messages only (everything in the DBC not sent by the ADU), exact ids in the acceptance filter
+        std::vector<canbus::filter> filters;
+        for(const auto& message : s1_can1::messages){
+            if(std::string(message.transmitter) != "ADU")
+                filters.push_back({message.id, message.extended ? 0x1FFFFFFFu : 0x7FFu, message.extended});
         }
-
-        if(stat != canOK){
-            char err[512] = {0,};
-            canGetErrorText(stat, err, sizeof(err));
-            logger::error("[{}] Failed to set bitrate : {}", getName(), err);
+        _can_rx = _can->subscribe(getName(), filters);
+        if(!_can_rx){
+            logger::error("[{}] No free subscription on CAN channel {}", getName(), _can_channel);
             return false;
         }
 
-        stat = canBusOn(_can_handle);
-        if(stat != canOK){
-            logger::error("[{}] Failed to go bus ON", getName());
-            return false;
+        // optional raw recording of the channel (received and sent frames, can_trace tool)
+        const std::string trace_path = parameters.value("can_trace_path", std::string());
+        if(!trace_path.empty()){
+            if(_can_trace.start(_can, trace_path, getName() + "/trace"))
+                logger::info("[{}] Recording CAN channel {} into {}", getName(), _can_channel, trace_path);
+            else
+                logger::warn("[{}] Failed to record CAN channel {} into {}", getName(), _can_channel, trace_path);
         }
 
         _can_rcv_worker = std::thread(&mobility_drive_control::_can_rcv_task, this);
+        _control_worker = std::thread(&mobility_drive_control::_control_task, this);
         logger::info("[{}] Initialized successfully.", getName());
 
     } catch(json::exception& e){
@@ -64,85 +115,334 @@ bool mobility_drive_control::onInit(){
 }
 
 void mobility_drive_control::onLoop(){
-    float speed = _target_speed.load();
-    float angle = _target_angle.load();
-    int gear = _current_gear.load();
-
-    // constrain speed
-    if (speed > _max_speed_limit) speed = _max_speed_limit;
-    if (speed < -_max_speed_limit) speed = -_max_speed_limit;
-
-    // constrain angle
-    if (angle > _max_steering_angle) angle = _max_steering_angle;
-    if (angle < -_max_steering_angle) angle = -_max_steering_angle;
-
-    auto msgs = _driver.set_drive_command(speed, angle, gear);
-    for(const auto& m : msgs){
-        if (_can_handle >= 0) {
-            canWrite(_can_handle, m.id, (void*)m.data, m.dlc, 0);
-        }
-    }
+    // drive commands are sent by the control thread at control_rate_hz
 }
 
 void mobility_drive_control::onClose(){
     _worker_stop.store(true);
+    if(_control_worker.joinable()){
+        _control_worker.join();
+    }
     if(_can_rcv_worker.joinable()){
         _can_rcv_worker.join();
     }
-    if(_can_handle >= 0){
-        canBusOff(_can_handle);
-        canClose(_can_handle);
-        _can_handle = -1;
+    _can_trace.stop();
+    if(_can){
+        _can->unsubscribe(_can_rx);
+        _can_rx = nullptr;
+        _can.reset();
     }
-    canUnloadLibrary();
 }
 
 void mobility_drive_control::onData(flame::component::ZData& data){
+    if(data.empty()) return;
+
+    // the command is the last part (the leading parts are topics)
+    zmq::message_t message = data.remove();
+
+    // binary drive command (primary path, no allocation)
+    if(s1_driver::is_drive_command(message.data(), message.size())){
+        s1_driver::drive_command command;
+        s1_driver::command_status status = s1_driver::decode(message.data(), message.size(), command);
+        if(status == s1_driver::command_status::accepted)
+            status = _sequencer.check(command, _system_ns());
+        _count_command(status);
+        _n_lost_commands.store(_sequencer.lost(), std::memory_order_relaxed);
+        if(status != s1_driver::command_status::accepted) return;
+
+        _target_speed.store(command.speed_kmh);
+        _target_angle.store(command.angle_deg);
+        _current_gear.store(command.gear);
+        _command_sequence.store(command.sequence);
+        _command_time_ns.store(_monotonic_ns());
+        _n_binary_commands.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // JSON command (fallback)
     try {
-        json j;
-        while (!data.empty()) {
-            string s = data.popstr();
-            try { j = json::parse(s); } catch(...) {}
-        }
-        
-        if (j.contains("command")) {
-            string cmd = j["command"];
-            if (cmd == "drive") {
-                if (j.contains("angle")) _target_angle.store(j["angle"]);
-                if (j.contains("velocity")) _target_speed.store(j["velocity"]);
-                _current_gear.store(-1);
-            } else if (cmd == "stop") {
-                _target_angle.store(0.0f);
-                _target_speed.store(0.0f);
-                _current_gear.store(-1);
-            } else if (cmd == "forward") {
-                _current_gear.store(1); // D
-            } else if (cmd == "backward") {
-                _current_gear.store(3); // R
-            } else if (cmd == "neutral") {
-                _current_gear.store(2); // N
-                _target_speed.store(0.0f);
-            }
+        const char* text = message.data<char>();
+        json j = json::parse(text, text + message.size());
+        if (!j.contains("command")) return;
+
+        string cmd = j["command"];
+        _command_time_ns.store(_monotonic_ns());
+        _n_json_commands.fetch_add(1, std::memory_order_relaxed);
+        if (cmd == "drive") {
+            if (j.contains("angle")) _target_angle.store(j["angle"]);
+            if (j.contains("velocity")) _target_speed.store(j["velocity"]);
+            _current_gear.store(-1);
+        } else if (cmd == "stop") {
+            _target_angle.store(0.0f);
+            _target_speed.store(0.0f);
+            _current_gear.store(-1);
+        } else if (cmd == "forward") {
+            _current_gear.store(1); // D
+        } else if (cmd == "backward") {
+            _current_gear.store(3); // R
+        } else if (cmd == "neutral") {
+            _current_gear.store(2); // N
+            _target_speed.store(0.0f);
         }
-    } catch (...) {
-        logger::error("[{}] Error parsing onData", getName());
+    } catch (json::exception& e) {
+        _count_command(s1_driver::command_status::malformed);
+        logger::error("[{}] Command Parse Error : {}", getName(), e.what());
+    }
+}
+
+void mobility_drive_control::_count_command(s1_driver::command_status status){
+    switch(status){
+        case s1_driver::command_status::accepted: break;
+        case s1_driver::command_status::malformed: _n_malformed_commands.fetch_add(1, std::memory_order_relaxed); break;
+        case s1_driver::command_status::duplicate:
+        case s1_driver::command_status::reordered: _n_reordered_commands.fetch_add(1, std::memory_order_relaxed); break;
+        case s1_driver::command_status::expired: _n_expired_commands.fetch_add(1, std::memory_order_relaxed); break;
     }
 }
 
 void mobility_drive_control::_can_rcv_task(){
+    auto last_report = std::chrono::steady_clock::now();
+
     while(!_worker_stop.load()){
-        long id;
-        unsigned char data[8];
-        unsigned int dlc;
-        unsigned int flags;
-        unsigned long time;
-
-        if (_can_handle >= 0) {
-            canStatus stat = canRead(_can_handle, &id, data, &dlc, &flags, &time);
-            if(stat == canOK) {
-                _driver.parse(id, data, dlc);
+        // woken once per received batch (the timeout keeps the stop flag responsive)
+        if(_can_rx->wait(100)) {
+            canbus::frame f;
+            while(_can_rx->pop(f)) _handle_frame(f);
+        }
+
+        // status once per second (the status port is only used by this thread)
+        auto now = std::chrono::steady_clock::now();
+        if(now - last_report >= std::chrono::seconds(1)) {
+            last_report = now;
+            _publish_status();
+        }
+    }
+}
+
+void mobility_drive_control::_set_realtime(){
+    if(_control_priority > 0) {
+        sched_param param{};
+        param.sched_priority = _control_priority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if(rc != 0) logger::warn("[{}] SCHED_FIFO {} not applied : {}", getName(), _control_priority, strerror(rc));
+    }
+    if(_control_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(_control_cpu, &cpus);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if(rc != 0) logger::warn("[{}] CPU {} affinity not applied : {}", getName(), _control_cpu, strerror(rc));
+    }
+}
+
+void mobility_drive_control::_control_task(){
+    _set_realtime();
+
+    const int64_t period_ns = 1000000000LL / _control_rate_hz;
+    float last_speed = NAN, last_angle = NAN;
+    int last_gear = -2;
+    int gear = -1;  // engaged gear (-1 : auto, from the sign of the shaped speed)
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t deadline_ns = _to_ns(now) + period_ns;
+    int64_t last_cycle_ns = _to_ns(now);
+
+    while(!_worker_stop.load()){
+        // sleep to the absolute deadline (no drift from the work time)
+        timespec deadline = _to_timespec(deadline_ns);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t late_ns = _to_ns(now) - deadline_ns;
+        if(late_ns > _max_jitter_ns.load(std::memory_order_relaxed)) _max_jitter_ns.store(late_ns, std::memory_order_relaxed);
+        _sum_jitter_ns.fetch_add(late_ns, std::memory_order_relaxed);
+        _n_jitter.fetch_add(1, std::memory_order_relaxed);
+
+        // a missed deadline is skipped rather than caught up with a burst of commands
+        deadline_ns += period_ns;
+        if(late_ns >= period_ns) {
+            const int64_t missed = late_ns / period_ns;
+            _n_cycle_overruns.fetch_add(missed, std::memory_order_relaxed);
+            deadline_ns += missed * period_ns;
+        }
+
+        float speed = _target_speed.load();
+        float angle = _target_angle.load();
+        const int requested_gear = _current_gear.load();
+
+        // signed target : an explicit gear gives the direction, the command the magnitude
+        if (requested_gear == 1) speed = std::abs(speed);          // D
+        else if (requested_gear == 3) speed = -std::abs(speed);    // R
+        else if (requested_gear == 2) speed = 0.0f;                // N
+
+        // constrain speed
+        if (speed > _max_speed_limit) speed = _max_speed_limit;
+        if (speed < -_max_speed_limit) speed = -_max_speed_limit;
+
+        // constrain angle
+        if (angle > _max_steering_angle) angle = _max_steering_angle;
+        if (angle < -_max_steering_angle) angle = -_max_steering_angle;
+
+        // watchdog : a missing or old command decays to a controlled stop
+        const int64_t now_ns = _to_ns(now);
+        const int64_t command_ns = _command_time_ns.load();
+        const bool stale = command_ns == 0 || now_ns - command_ns > _command_timeout_ns;
+        if(stale && !_command_stale.exchange(true) && command_ns != 0) {
+            _n_command_timeouts.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if(!stale) {
+            _command_stale.store(false);
+        }
+
+        // a gear change against the current motion (or a reversal in auto) waits for standstill :
+        // the shaper brings the speed to zero in the engaged gear, then the new gear is engaged.
+        // a stale command keeps the engaged gear until the vehicle has stopped.
+        const double shaped_kmh = _shaper.get_speed_kmh();
+        const bool standstill = std::abs(shaped_kmh) <= gear_change_speed_kmh;
+        if(requested_gear != gear && (!stale || standstill)) {
+            const bool compatible = standstill || requested_gear == -1
+                                    || (requested_gear == 1 && shaped_kmh > 0.0)
+                                    || (requested_gear == 3 && shaped_kmh < 0.0);
+            if(compatible) gear = requested_gear;
+            else speed = 0.0f;
+        }
+        if(!standstill && (double)speed * shaped_kmh < 0.0) speed = 0.0f;
+
+        // acceleration, jerk and steering rate limits (measured cycle time, bounded after a stall)
+        const double dt = (double)std::min(now_ns - last_cycle_ns, 3 * period_ns) * 1e-9;
+        last_cycle_ns = now_ns;
+        _shaper.update(speed, angle, dt, stale);
+        speed = (float)_shaper.get_speed_kmh();
+        angle = (float)_shaper.get_angle_deg();
+        _shaped_speed.store(speed, std::memory_order_relaxed);
+        _shaped_angle.store(angle, std::memory_order_relaxed);
+        _engaged_gear.store(gear, std::memory_order_relaxed);
+
+        // an explicit gear sends the magnitude along its own direction only (no sign flip at the zero crossing)
+        if (gear == 1) speed = std::max(speed, 0.0f);
+        else if (gear == 3) speed = std::max(-speed, 0.0f);
+        else if (gear == 2) speed = 0.0f;
+
+        // frames are only re-encoded when the command changes
+        if(speed != last_speed || angle != last_angle || gear != last_gear) {
+            _driver.set_drive_command(_frames, speed, angle, gear);
+            for(size_t i = 0; i < _frames.size(); i++){
+                _tx_frames[i].id = _frames[i].id;
+                _tx_frames[i].dlc = _frames[i].dlc;
+                _tx_frames[i].flags = _frames[i].is_extended ? canbus::FRAME_EXTENDED : 0;
+                std::memcpy(_tx_frames[i].data, _frames[i].data, sizeof(_tx_frames[i].data));
             }
+            last_speed = speed;
+            last_angle = angle;
+            last_gear = gear;
+        }
+
+        // the whole cycle in one batch, ahead of any lower priority frame of the channel
+        const size_t queued = _can->send(_tx_frames.data(), _tx_frames.size(), canbus::priority::control);
+        if(queued < _tx_frames.size())
+            _n_tx_errors.fetch_add(_tx_frames.size() - queued, std::memory_order_relaxed);
+        _n_cycles.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void mobility_drive_control::_handle_frame(const canbus::frame& f){
+    _driver.parse(f.id, f.data, f.dlc, f.timestamp_ns);
+    if(f.id == s1_can1::VCU_Vehicle_Status_2::id) _publish_vehicle_state(f.timestamp_ns);
+}
+
+void mobility_drive_control::_publish_status(){
+    const canbus::channel_stats can = _can->get_stats();
+
+    json status;
+    status["can"] = {
+        {"frames", can.rx_frames},
+        {"wakeups", can.rx_wakeups},
+        {"max_batch", can.rx_max_batch},
+        {"overruns", can.rx_overruns},
+        {"error_frames", can.rx_error_frames},
+        {"unrouted", can.rx_unrouted},
+        {"received", _can_rx->get_received()},
+        {"dropped", _can_rx->get_dropped()},
+        {"tx_frames", can.tx_frames},
+        {"tx_errors", can.tx_errors},
+        {"tx_error_counter", can.tx_error_counter},
+        {"rx_error_counter", can.rx_error_counter},
+        {"overrun_counter", can.overrun_counter},
+        {"error_passive", can.error_passive},
+        {"bus_off", can.bus_off},
+        {"subscribers", can.subscribers},
+        {"trace_records", _can_trace.get_records()},
+        {"trace_dropped", _can_trace.get_dropped()}
+    };
+
+    const uint64_t n_jitter = _n_jitter.exchange(0);
+    const int64_t sum_jitter_ns = _sum_jitter_ns.exchange(0);
+    status["control"] = {
+        {"rate_hz", _control_rate_hz},
+        {"cycles", _n_cycles.load()},
+        {"overruns", _n_cycle_overruns.load()},
+        {"tx_dropped", _n_tx_errors.load()},
+        {"jitter_max_us", (double)_max_jitter_ns.exchange(0) * 1e-3},
+        {"jitter_mean_us", n_jitter ? (double)sum_jitter_ns / (double)n_jitter * 1e-3 : 0.0},
+        {"command_stale", _command_stale.load()},
+        {"command_timeouts", _n_command_timeouts.load()},
+        {"gear", _engaged_gear.load()},
+        {"speed_kmh", _shaped_speed.load()},
+        {"angle_deg", _shaped_angle.load()}
+    };
+    status["command"] = {
+        {"binary", _n_binary_commands.load()},
+        {"json", _n_json_commands.load()},
+        {"sequence", _command_sequence.load()},
+        {"lost", _n_lost_commands.load()},
+        {"malformed", _n_malformed_commands.load()},
+        {"reordered", _n_reordered_commands.load()},
+        {"expired", _n_expired_commands.load()}
+    };
+
+    // freshness of the feedback messages (one consistent snapshot)
+    const s1_driver::vehicle_state vehicle = _driver.get_state();
+    const uint64_t now_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto age_ms = [](int64_t age_ns) { return age_ns == INT64_MAX ? -1.0 : (double)age_ns * 1e-6; };
+    status["vehicle"] = {
+        {"version", vehicle.version},
+        {"status_1_age_ms", age_ms(vehicle.age_ns<s1_can1::VCU_Vehicle_Status_1>(now_ns))},
+        {"status_2_age_ms", age_ms(vehicle.age_ns<s1_can1::VCU_Vehicle_Status_2>(now_ns))},
+        {"eps_age_ms", age_ms(vehicle.age_ns<s1_can1::EPS_Status>(now_ns))},
+        {"fresh", vehicle.is_fresh<s1_can1::VCU_Vehicle_Status_1>(now_ns) && vehicle.is_fresh<s1_can1::VCU_Vehicle_Status_2>(now_ns)},
+        {"emergency_button", vehicle.get_emergency_button()}
+    };
+
+    try {
+        if (getPort("status")->handle() != nullptr) {
+            zmq::multipart_t msg_multipart;
+            msg_multipart.addstr(fmt::format("{}/status", getName()));
+            msg_multipart.addstr(status.dump());
+            msg_multipart.send(*getPort("status"), ZMQ_DONTWAIT);
+        }
+    } catch (const zmq::error_t& e) {
+        logger::error("[{}] Status publish error : {}", getName(), e.what());
+    }
+}
+
+void mobility_drive_control::_publish_vehicle_state(uint64_t timestamp_ns){
+    // wheel speed/steering feedback for the pose estimator (hardware receive time)
+    const s1_driver::vehicle_state vehicle = _driver.get_state();
+    json state;
+    state["speed_kmh"] = vehicle.get_vehicle_speed();
+    state["wheel_angle_deg"] = vehicle.get_wheel_end_angle();
+    state["gear"] = vehicle.get_vehicle_gear();
+    state["timestamp_ns"] = timestamp_ns;
+
+    try {
+        if (getPort("status")->handle() != nullptr) {
+            zmq::multipart_t msg_multipart;
+            msg_multipart.addstr(fmt::format("{}/vehicle_state", getName()));
+            msg_multipart.addstr(state.dump());
+            msg_multipart.send(*getPort("status"), ZMQ_DONTWAIT);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    } catch (const zmq::error_t& e) {
+        logger::error("[{}] Vehicle state publish error : {}", getName(), e.what());
     }
 }
@@ -6,7 +6,10 @@
 #include <thread>
 #include <vector>
 #include "s1_driver.hpp"
-#include <canlib.h>
+#include "setpoint_shaper.hpp"
+#include "drive_command.hpp"
+#include "../can.bus.broker/can_bus_broker.hpp"
+#include "../can.bus.broker/can_trace.hpp"
 
 class mobility_drive_control : public flame::component::Object {
 public:
@@ -20,14 +23,56 @@ public:
 
 private:
     void _can_rcv_task();
+    void _control_task();
+    void _set_realtime(); // SCHED_FIFO and CPU affinity of the calling thread (control thread)
+    void _handle_frame(const canbus::frame& f);
+    void _publish_vehicle_state(uint64_t timestamp_ns);
+    void _publish_status();
+    void _count_command(s1_driver::command_status status);
 
 private:
     s1_driver::S1Driver _driver;
     int _can_channel = 0;
-    canHandle _can_handle = -1;
+    std::shared_ptr<canbus::channel> _can;
+    canbus::subscription* _can_rx = nullptr;
+    canbus::trace_recorder _can_trace;   // raw channel recording (profile can_trace_path), for replay and s1_decode_bench
     std::thread _can_rcv_worker;
+    std::thread _control_worker;
     std::atomic<bool> _worker_stop{false};
 
+    // control thread (absolute deadlines on CLOCK_MONOTONIC)
+    int _control_rate_hz = 50;
+    int _control_priority = 0;  // SCHED_FIFO priority (1-99), 0 : default scheduler
+    int _control_cpu = -1;      // CPU to pin the control thread, -1 : no pinning
+    s1_driver::drive_frames _frames{};
+    std::array<canbus::frame, s1_driver::n_drive_frames> _tx_frames{};
+    std::atomic<uint64_t> _n_cycles{0};
+    std::atomic<uint64_t> _n_cycle_overruns{0};   // missed deadlines (cycles skipped)
+    std::atomic<uint64_t> _n_tx_errors{0};        // control frames not queued (transmit queue full)
+    std::atomic<int64_t> _max_jitter_ns{0};       // wakeup lateness since the last report
+    std::atomic<int64_t> _sum_jitter_ns{0};
+    std::atomic<uint64_t> _n_jitter{0};
+
+    // setpoint shaping and command watchdog (shaper is owned by the control thread)
+    s1_driver::setpoint_shaper _shaper;
+    int64_t _command_timeout_ns = 300000000;
+    std::atomic<int64_t> _command_time_ns{0};     // CLOCK_MONOTONIC time of the last command, 0 : none yet
+    std::atomic<bool> _command_stale{true};
+    std::atomic<uint64_t> _n_command_timeouts{0};
+    std::atomic<float> _shaped_speed{0.0f};
+    std::atomic<float> _shaped_angle{0.0f};
+    std::atomic<int> _engaged_gear{-1};           // gear sent to the vehicle (changed at standstill only)
+
+    // command ingress (binary drive_command, JSON fallback), the sequencer is owned by onData
+    s1_driver::command_sequencer _sequencer;
+    std::atomic<uint32_t> _command_sequence{0};  // last accepted binary command
+    std::atomic<uint64_t> _n_binary_commands{0};
+    std::atomic<uint64_t> _n_json_commands{0};
+    std::atomic<uint64_t> _n_lost_commands{0};      // sequence gaps
+    std::atomic<uint64_t> _n_malformed_commands{0};
+    std::atomic<uint64_t> _n_reordered_commands{0}; // late or duplicated (dropped)
+    std::atomic<uint64_t> _n_expired_commands{0};   // deadline passed (dropped)
+
     std::atomic<float> _target_speed{0.0f};
     std::atomic<float> _target_angle{0.0f};
     std::atomic<int> _current_gear{-1}; // -1: Auto, 1: D, 2: N, 3: R
@@ -2,9 +2,11 @@
 #define FLAME_MOBILITY_DRIVE_CONTROL_S1_DRIVER_HPP_INCLUDED
 
 #include <cstdint>
-#include <vector>
+#include <array>
 #include <string>
 #include <cmath>
+#include "dbc/s1_can1.hpp" // generated from APROS/doc/S1_CAN1_v5.dbc (dbc/dbc2cpp.py)
+#include "seqlock.hpp"
 
 namespace s1_driver {
 
@@ -15,82 +17,93 @@ struct can_message {
     bool is_extended;
 };
 
+// 주행 명령 한 주기 (flag, brake, steering, body, accelerate)
+static constexpr size_t n_drive_frames = 5;
+using drive_frames = std::array<can_message, n_drive_frames>;
+
+// 디코딩된 차량 상태 스냅샷 (CAN 수신 스레드가 쓰고, 다른 스레드는 복사본을 읽음)
+struct vehicle_state {
+    s1_can1::bus bus;
+    uint64_t timestamp_ns[s1_can1::n_messages] = {0, }; // receive time of each message (system clock), 0 : never received
+    uint64_t update_ns = 0;                             // receive time of the last frame
+    uint64_t version = 0;                               // number of decoded frames
+
+    // index of a message in s1_can1::messages
+    template <typename M>
+    static constexpr size_t index() { return (size_t)(s1_can1::find(M::id) - s1_can1::messages); }
+
+    template <typename M>
+    uint64_t timestamp() const { return timestamp_ns[index<M>()]; }
+
+    // age of the last received M, INT64_MAX if it was never received
+    template <typename M>
+    int64_t age_ns(uint64_t now_ns) const {
+        const uint64_t t = timestamp<M>();
+        return t ? (int64_t)(now_ns - t) : INT64_MAX;
+    }
+
+    // received within max_cycles periods (event messages : received at least once)
+    template <typename M>
+    bool is_fresh(uint64_t now_ns, unsigned max_cycles = 3) const {
+        if (M::cycle_ms == 0) return timestamp<M>() != 0;
+        return age_ns<M>(now_ns) <= (int64_t)max_cycles * M::cycle_ms * 1000000;
+    }
+
+    // 상태 읽기 (get_ prefix)
+    int get_vehicle_gear() const { return (int)bus.VCU_Vehicle_Status_1_.Vehicle_Gear; }
+    int get_drive_state_mode() const { return (int)bus.VCU_Vehicle_Status_1_.Drive_Mode_State; }
+    float get_vehicle_speed_request() const { return (float)bus.VCU_Vehicle_Status_1_.VCU_Speed_Req; }
+    
+    int get_direction_angle() const { return (int)bus.VCU_EPS_Control_Request_.VCU_EPS_StrAngle_Req; }
+    bool get_eps_control() const { return bus.VCU_EPS_Control_Request_.VCU_EPS_CtrlEnable != 0.0; }
+    
+    float get_vehicle_speed() const { return (float)bus.VCU_Vehicle_Status_2_.Vehicle_Speed; }
+    float get_wheel_end_angle() const { return (float)bus.VCU_Vehicle_Status_2_.Vehicle_Steering_Angle; }
+    float get_break_pressure() const { return (float)bus.VCU_Vehicle_Status_2_.Vehicle_Brake_Pressure; }
+    
+    bool get_brake_light() const { return bus.VCU_Vehicle_Diagnosis_.Light_states_Brake != 0.0; }
+    bool get_head_light() const { return bus.VCU_Vehicle_Diagnosis_.HeadLight_State != 0.0; }
+    bool get_emergency_button() const { return bus.VCU_Vehicle_Diagnosis_.Emergency_Button_State != 0.0; }
+    bool get_back_touch_switch() const { return bus.VCU_Vehicle_Diagnosis_.R_Touch_Switch_State != 0.0; }
+    bool get_front_touch_switch() const { return bus.VCU_Vehicle_Diagnosis_.F_Touch_Switch_State != 0.0; }
+    
+    int get_eps_current_angle() const { return (int)bus.EPS_Status_.EPS_StrAngle_Act; }
+    int get_eps_ecu_temperature() const { return (int)bus.EPS_Status_.EPS_Temperature; }
+    
+    float get_bus_voltage() const { return (float)bus.MCU_Drive_Motor_Feedback_Msg_.Motor_Udc; }
+    float get_bus_current() const { return (float)bus.MCU_Drive_Motor_Feedback_Msg_.Motor_Idc; }
+    
+    int get_drive_mode() const { return (int)bus.VCU_MCU_Request_.MCU_DriveMode; }
+    bool get_mcu_brake_request() const { return bus.VCU_MCU_Request_.MCU_Clamping_Brake_Req != 0.0; }
+    int get_mcu_speed_request() const { return (int)bus.VCU_MCU_Request_.MCU_Speed_Req; }
+    float get_mcu_torque_request() const { return (float)bus.VCU_MCU_Request_.MCU_Torque_Req; }
+    
+    int get_bms_battery_soh() const { return (int)bus.BMS_A0h_.BMS_HVDisplaySOH; }
+    float get_bms_battery_soc() const { return (float)bus.BMS_A0h_.BMS_HVBatSOC; }
+    float get_bms_battery_voltage() const { return (float)bus.BMS_A0h_.BMS_HVBatVol; }
+};
+
 class S1Driver {
 public:
     S1Driver() = default;
     ~S1Driver() = default;
 
-    // CAN 메시지 파싱
-    void parse(uint32_t can_id, const uint8_t* data, size_t dlc) {
-        if (dlc == 0) return;
-
-        switch (can_id) {
-            case 0x303:
-                if (dlc >= 4) {
-                    vehicle_gear_ = data[0] & 0x03;
-                    drive_state_mode_ = data[1] & 0x03;
-                    vehicle_speed_request_ = (data[2] | (data[3] << 8)) * 0.1f - 80.0f;
-                }
-                break;
-            case 0x314:
-                if (dlc >= 3) {
-                    direction_angle_ = (data[1] | (data[2] << 8));
-                    eps_control_ = (data[0] & 0x01) ? true : false;
-                }
-                break;
-            case 0x304:
-                if (dlc >= 6) {
-                    vehicle_speed_ = (data[0] | (data[1] << 8)) * 0.1f - 80.0f;
-                    break_pressure_ = (data[2] | (data[3] << 8)) * 0.01f;
-                    wheel_end_angle_ = (data[4] | (data[5] << 8)) * 0.1f - 35.0f;
-                }
-                break;
-            case 0x301:
-                if (dlc >= 6) {
-                    emergency_button_ = (data[0] & 0x01) ? true : false;
-                    head_light_ = (data[1] & 0x80) ? true : false;
-                    back_touch_switch_ = (data[1] & 0x20) ? true : false;
-                    front_touch_switch_ = (data[1] & 0x10) ? true : false;
-                    brake_light_ = (data[5] & 0x01) ? true : false;
-                }
-                break;
-            case 0x18F:
-                if (dlc >= 7) {
-                    int16_t angle_raw = data[1] | (data[2] << 8);
-                    eps_current_angle_ = angle_raw;
-                    eps_ecu_temperature_ = static_cast<int8_t>(data[6]);
-                }
-                break;
-            case 0x060:
-                if (dlc >= 4) {
-                    bus_voltage_ = (data[0] | (data[1] << 8)) * 0.1f;
-                    bus_current_ = (data[2] | (data[3] << 8)) * 0.1f - 1000.0f;
-                }
-                break;
-            case 0x160:
-                if (dlc >= 6) {
-                    drive_mode_ = (data[0] & 0x06) >> 1;
-                    mcu_brake_request_ = (data[0] & 0x08) ? true : false;
-                    mcu_torque_request_ = (data[1] | (data[2] << 8)) * 0.1f - 1000.0f;
-                    mcu_speed_request_ = (data[3] | (data[4] << 8) | (data[5] << 16)) - 7000;
-                }
-                break;
-            case 0x0A0:
-                if (dlc >= 8) {
-                    bms_battery_voltage_ = (data[2] | (data[3] << 8)) * 0.1f;
-                    bms_battery_soc_ = data[4] * 0.4f;
-                    bms_battery_soh_ = data[7];
-                }
-                break;
-            default:
-                break;
-        }
+    // CAN 메시지 파싱 (DBC 생성 코드, 모든 시그널 디코딩, CAN 수신 스레드 전용)
+    // returns the decoded message description, nullptr if the id is not in the DBC or the frame is too short
+    const dbc::message_info* parse(uint32_t can_id, const uint8_t* data, size_t dlc, uint64_t timestamp_ns) {
+        const dbc::message_info* info = state_.bus.decode(can_id, data, dlc);
+        if (!info) return nullptr;
+        state_.timestamp_ns[info - s1_can1::messages] = timestamp_ns;
+        state_.update_ns = timestamp_ns;
+        state_.version++;
+        snapshot_.store(state_);
+        return info;
     }
 
     // 제어 명령 수행 (set_ prefix)
-    std::vector<can_message> set_drive_command(float speed, float angular, int override_gear = -1) {
-        std::vector<can_message> msgs;
-        
+    // frames are encoded in place (no allocation, called from the control thread)
+    void set_drive_command(drive_frames& frames, float speed, float angular, int override_gear = -1) const {
+
         // 각도 제한 (-30 ~ 30)
         if (angular < -30.0f) angular = -30.0f;
         if (angular > 30.0f) angular = 30.0f;
@@ -117,90 +130,55 @@ public:
             indicator = 0xF1; // 좌회전
         }
 
-        // VCU_Speed_Req
-        int speed_val_for_504 = static_cast<int>(speed / 0.1f);
-        uint8_t linear_v1 = speed_val_for_504 & 0xFF;
-        uint8_t linear_v2 = (speed_val_for_504 >> 8) & 0xFF;
-
-        // 조향 각도 제어 (angular_val = (angular + 30) / 0.1)
-        int angular_val_for_502 = static_cast<int>((angular + 30.0f) / 0.1f);
-        uint8_t angular_v1 = angular_val_for_502 & 0xFF;
-        uint8_t angular_v2 = (angular_val_for_502 >> 8) & 0xFF;
+        // AD 제어 메시지 (valid 1, message counter 15)
+        s1_can1::AD_Control_Flag flag;
+        flag.AD_Control_Request_Flag = flag.AD_Control_Request_Flag_Value;
+        flag.AD_Flag_MsgCntr = 15;
+
+        s1_can1::AD_Control_Brake brake;
+        brake.AD_DBS_Valid = brake.AD_DBS_Valid_Valid;
+        brake.AD_DBS_MsgCntr = 15;
+
+        s1_can1::AD_Control_Steering steering;
+        steering.AD_Steering_Valid = steering.AD_Steering_Valid_Valid;
+        steering.AD_Steering_MsgCntr = 15;
+        steering.AD_Steering_Angle_Cmd = angular;
+
+        s1_can1::AD_Control_Body body;
+        body.AD_Left_Turn_Light = (indicator == 0xF1) ? 1 : 0;
+        body.AD_Right_Turn_Light = (indicator == 0xF2) ? 1 : 0;
+        body.AD_Body_MsgCntr = indicator ? 15 : 0;
+
+        s1_can1::AD_Control_Accelerate accelerate;
+        accelerate.AD_Accelerate_Valid = accelerate.AD_Accelerate_Valid_Valid;
+        accelerate.AD_Accelerate_MsgCntr = 15;
+        accelerate.AD_Accelerate_Work_Mode = accelerate.AD_Accelerate_Work_Mode_Speed_Control;
+        accelerate.AD_Accelerate_Gear = gear;
+        accelerate.AD_Acc_De = -5.0; // raw 0 (not used in speed control)
+        accelerate.AD_Speed_Control = speed;
+
+        frames[0] = make_message(flag);
+        frames[1] = make_message(brake);
+        frames[2] = make_message(steering);
+        frames[3] = make_message(body);
+        frames[4] = make_message(accelerate);
+    }
 
-        msgs.push_back({0x501, {0xF1, 0, 0, 0, 0, 0, 0, 0}, 8, false});
-        msgs.push_back({0x503, {0xF1, 0, 0, 0, 0, 0, 0, 0}, 8, false});
-        msgs.push_back({0x502, {0xF1, 0, 0, 0, angular_v1, angular_v2, 0, 0}, 8, false});
-        msgs.push_back({0x506, {indicator, 0, 0, 0, 0, 0, 0, 0}, 8, false});
-        msgs.push_back({0x504, {0xF1, 0x00, 0x01, gear, 0, 0, linear_v1, linear_v2}, 8, false});
+    // 일관된 상태 복사본 (lock-free, 어느 스레드에서나 호출 가능)
+    vehicle_state get_state() const { return snapshot_.load(); }
+    uint64_t get_state_version() const { return snapshot_.version(); }
 
-        return msgs;
+private:
+    template <typename T>
+    static can_message make_message(const T& message) {
+        can_message m {T::id, {0, }, T::dlc, T::extended};
+        message.encode(m.data);
+        return m;
     }
 
-    // 상태 읽기 (get_ prefix)
-    int get_vehicle_gear() const { return vehicle_gear_; }
-    int get_drive_state_mode() const { return drive_state_mode_; }
-    float get_vehicle_speed_request() const { return vehicle_speed_request_; }
-    
-    int get_direction_angle() const { return direction_angle_; }
-    bool get_eps_control() const { return eps_control_; }
-    
-    float get_vehicle_speed() const { return vehicle_speed_; }
-    float get_wheel_end_angle() const { return wheel_end_angle_; }
-    float get_break_pressure() const { return break_pressure_; }
-    
-    bool get_brake_light() const { return brake_light_; }
-    bool get_head_light() const { return head_light_; }
-    bool get_emergency_button() const { return emergency_button_; }
-    bool get_back_touch_switch() const { return back_touch_switch_; }
-    bool get_front_touch_switch() const { return front_touch_switch_; }
-    
-    int get_eps_current_angle() const { return eps_current_angle_; }
-    int get_eps_ecu_temperature() const { return eps_ecu_temperature_; }
-    
-    float get_bus_voltage() const { return bus_voltage_; }
-    float get_bus_current() const { return bus_current_; }
-    
-    int get_drive_mode() const { return drive_mode_; }
-    bool get_mcu_brake_request() const { return mcu_brake_request_; }
-    int get_mcu_speed_request() const { return mcu_speed_request_; }
-    float get_mcu_torque_request() const { return mcu_torque_request_; }
-    
-    int get_bms_battery_soh() const { return bms_battery_soh_; }
-    float get_bms_battery_soc() const { return bms_battery_soc_; }
-    float get_bms_battery_voltage() const { return bms_battery_voltage_; }
-
 private:
-    int vehicle_gear_ = 0;
-    int drive_state_mode_ = 0;
-    float vehicle_speed_request_ = 0.0f;
-    
-    int direction_angle_ = 0;
-    bool eps_control_ = false;
-    
-    float vehicle_speed_ = 0.0f;
-    float wheel_end_angle_ = 0.0f;
-    float break_pressure_ = 0.0f;
-    
-    bool brake_light_ = false;
-    bool head_light_ = false;
-    bool emergency_button_ = false;
-    bool back_touch_switch_ = false;
-    bool front_touch_switch_ = false;
-    
-    int eps_current_angle_ = 0;
-    int eps_ecu_temperature_ = 0;
-    
-    float bus_voltage_ = 0.0f;
-    float bus_current_ = 0.0f;
-    
-    int drive_mode_ = 0;
-    bool mcu_brake_request_ = false;
-    int mcu_speed_request_ = 0;
-    float mcu_torque_request_ = 0.0f;
-    
-    int bms_battery_soh_ = 0;
-    float bms_battery_soc_ = 0.0f;
-    float bms_battery_voltage_ = 0.0f;
+    vehicle_state state_;               // writer copy (CAN receive thread)
+    seqlock<vehicle_state> snapshot_;   // published copy
 };
 
 } // namespace s1_driver
@@ -0,0 +1,74 @@
+#ifndef FLAME_MOBILITY_DRIVE_CONTROL_SEQLOCK_HPP_INCLUDED
+#define FLAME_MOBILITY_DRIVE_CONTROL_SEQLOCK_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer / multiple reader sequence lock for a trivially copyable value.
+// The writer never blocks : it makes the sequence odd, copies the value, makes it even again.
+// A reader copies the value and retries if the sequence was odd or changed during the copy.
+// The value is kept as relaxed atomic words, so a reader racing with the writer only sees
+// a torn copy that it discards (no undefined behavior).
+
+namespace s1_driver {
+
+template <typename T>
+class seqlock {
+    static_assert(std::is_trivially_copyable_v<T>, "seqlock value must be trivially copyable");
+
+public:
+    seqlock() { store(T{}); }
+
+    // writer side (one thread only)
+    void store(const T& value) {
+        uint64_t words[n_words] = {0, };
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < n_words; i++)
+            words_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // reader side (any thread), false if a write was in progress
+    bool try_load(T& value) const {
+        const uint64_t seq = seq_.load(std::memory_order_acquire);
+        if (seq & 1) return false;
+
+        uint64_t words[n_words];
+        for (size_t i = 0; i < n_words; i++)
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != seq) return false;
+
+        std::memcpy(&value, words, sizeof(T));
+        return true;
+    }
+
+    T load() const {
+        T value;
+        while (!try_load(value)) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+        return value;
+    }
+
+    // number of completed writes
+    uint64_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t n_words = (sizeof(T) + 7) / 8;
+
+    alignas(64) std::atomic<uint64_t> seq_{0};
+    alignas(64) std::atomic<uint64_t> words_[n_words];
+};
+
+} // namespace s1_driver
+
+#endif // FLAME_MOBILITY_DRIVE_CONTROL_SEQLOCK_HPP_INCLUDED
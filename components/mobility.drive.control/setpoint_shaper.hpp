@@ -0,0 +1,98 @@
+#ifndef FLAME_MOBILITY_DRIVE_CONTROL_SETPOINT_SHAPER_HPP_INCLUDED
+#define FLAME_MOBILITY_DRIVE_CONTROL_SETPOINT_SHAPER_HPP_INCLUDED
+
+#include <cmath>
+#include <algorithm>
+
+namespace s1_driver {
+
+// 속도/조향 명령 성형 (제어 스레드 주기마다 호출, 고정 연산량, 할당 없음)
+// speed follows the target with bounded acceleration and jerk, the wheel angle with a bounded rate.
+// The wheel angle is limited by the turning geometry (wheelbase, minimum turning radius)
+// and by the lateral acceleration at the current speed.
+struct shaper_limits {
+    double max_accel = 1.0;             // m/s^2
+    double max_decel = 1.5;             // m/s^2
+    double max_jerk = 2.0;              // m/s^3
+    double timeout_decel = 2.0;         // m/s^2, stop when the command is stale
+    double max_steer_rate = 30.0;       // deg/s
+    double max_steer_angle = 24.7;      // deg
+    double max_lateral_accel = 1.5;     // m/s^2
+    double wheelbase = 1.15;            // m
+    double min_turning_radius = 2.5;    // m
+};
+
+class setpoint_shaper {
+public:
+    setpoint_shaper() { set_limits(shaper_limits{}); }
+    explicit setpoint_shaper(const shaper_limits& limits) { set_limits(limits); }
+
+    void set_limits(const shaper_limits& limits) {
+        limits_ = limits;
+        // tightest turn the chassis allows
+        const double geometric = std::atan(limits.wheelbase / limits.min_turning_radius) * 180.0 / M_PI;
+        steer_limit_ = std::min(limits.max_steer_angle, geometric);
+    }
+
+    // speed in km/h (signed), angle in deg, dt in s. stale : the command is too old, decay to a stop
+    void update(double target_speed_kmh, double target_angle_deg, double dt, bool stale) {
+        if (dt <= 0.0) return;
+        const double target = stale ? 0.0 : target_speed_kmh / 3.6;
+        const double decel = stale ? std::max(limits_.max_decel, limits_.timeout_decel) : limits_.max_decel;
+
+        // acceleration that still lets the ramp down to zero acceleration at the target
+        // (the error left once the current acceleration is ramped out at max_jerk)
+        const double error = target - speed_ - accel_ * std::fabs(accel_) / (2.0 * limits_.max_jerk);
+        double desired = std::copysign(std::sqrt(2.0 * limits_.max_jerk * std::fabs(error)), error);
+        // accelerating away from standstill uses max_accel, slowing down towards it uses decel
+        const double lo = speed_ > 0.0 ? -decel : -limits_.max_accel;
+        const double hi = speed_ < 0.0 ? decel : limits_.max_accel;
+        desired = std::clamp(desired, lo, hi);
+
+        const double step = limits_.max_jerk * dt;
+        const double previous = accel_;
+        accel_ += std::clamp(desired - accel_, -step, step);
+
+        const double next = speed_ + accel_ * dt;
+        if ((next - target) * (speed_ - target) <= 0.0 && std::fabs(previous) <= step) {
+            // reached the target within this step with an acceleration that can be dropped
+            speed_ = target;
+            accel_ = 0.0;
+        }
+        else
+            speed_ = next;
+
+        // wheel angle : geometric and lateral acceleration limits, then the rate limit
+        double limit = steer_limit_;
+        const double v2 = speed_ * speed_;
+        if (v2 > 1e-6)
+            limit = std::min(limit, std::atan(limits_.max_lateral_accel * limits_.wheelbase / v2) * 180.0 / M_PI);
+        const double angle_target = stale ? angle_ : std::clamp(target_angle_deg, -limit, limit);
+        const double rate = limits_.max_steer_rate * dt;
+        angle_ += std::clamp(angle_target - angle_, -rate, rate);
+        angle_ = std::clamp(angle_, -limit, limit);
+    }
+
+    void reset(double speed_kmh = 0.0, double angle_deg = 0.0) {
+        speed_ = speed_kmh / 3.6;
+        accel_ = 0.0;
+        angle_ = angle_deg;
+    }
+
+    double get_speed_kmh() const { return speed_ * 3.6; }
+    double get_accel() const { return accel_; }
+    double get_angle_deg() const { return angle_; }
+    double get_steer_limit_deg() const { return steer_limit_; }
+    const shaper_limits& get_limits() const { return limits_; }
+
+private:
+    shaper_limits limits_;
+    double steer_limit_ = 24.7;
+    double speed_ = 0.0;    // m/s
+    double accel_ = 0.0;    // m/s^2
+    double angle_ = 0.0;    // deg
+};
+
+} // namespace s1_driver
+
+#endif // FLAME_MOBILITY_DRIVE_CONTROL_SETPOINT_SHAPER_HPP_INCLUDED
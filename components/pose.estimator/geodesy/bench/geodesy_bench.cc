@@ -0,0 +1,108 @@
+/**
+ * @file geodesy_bench.cc
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief ENU projection microbenchmark (cached origin series path vs. per-call trigonometry baseline)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage : geodesy_bench [route file] [points]
+ */
+
+#include "../route_table.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* baseline : origin and point trigonometry redone for every conversion */
+static void _baseline(double lat0, double lon0, double lat, double lon, double& east, double& north){
+    auto ecef = [](double lat, double lon, double& x, double& y, double& z){
+        const double s = sin(lat*geodesy::deg2rad), c = cos(lat*geodesy::deg2rad);
+        const double n = geodesy::wgs84_a/sqrt(1.0 - geodesy::wgs84_e2*s*s);
+        x = n*c*cos(lon*geodesy::deg2rad);
+        y = n*c*sin(lon*geodesy::deg2rad);
+        z = n*(1.0-geodesy::wgs84_e2)*s;
+    };
+    double x0, y0, z0, x, y, z;
+    ecef(lat0, lon0, x0, y0, z0);
+    ecef(lat, lon, x, y, z);
+    const double sl = sin(lat0*geodesy::deg2rad), cl = cos(lat0*geodesy::deg2rad);
+    const double so = sin(lon0*geodesy::deg2rad), co = cos(lon0*geodesy::deg2rad);
+    east = -so*(x-x0) + co*(y-y0);
+    north = -sl*co*(x-x0) - sl*so*(y-y0) + cl*(z-z0);
+}
+
+static double _elapsed_ns(chrono::steady_clock::time_point start){
+    return (double)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now()-start).count();
+}
+
+int main(int argc, char** argv){
+    const char* path = (argc>1) ? argv[1] : nullptr;
+    size_t points = (argc>2) ? strtoul(argv[2], nullptr, 10) : 10000;
+
+    /* route text : the given file repeated up to the number of points, or a synthetic loop */
+    string text = "index,latitude,longitude,corridor_boundary\n";
+    geodesy::route_table source;
+    if(path && (!source.load(path) || source.size()==0)){
+        fprintf(stderr, "cannot load %s\n", path);
+        return 1;
+    }
+    char line[128];
+    for(size_t i=0;i<points;i++){
+        double lat = 37.1472224 + 0.001*sin((double)i*1e-3);
+        double lon = 127.4143319 + 0.001*cos((double)i*1e-3);
+        if(source.size()>0){
+            lat = source.latitude()[i%source.size()];
+            lon = source.longitude()[i%source.size()];
+        }
+        snprintf(line, sizeof(line), "%zu,%.8f,%.8f,3.0\n", i, lat, lon);
+        text += line;
+    }
+
+    /* load (parse + batch projection) */
+    geodesy::route_table route;
+    auto start = chrono::steady_clock::now();
+    route.parse(text);
+    double parse_ns = _elapsed_ns(start);
+    geodesy::enu_projection projection(route.latitude()[0], route.longitude()[0]);
+    start = chrono::steady_clock::now();
+    route.project(projection);
+    double project_ns = _elapsed_ns(start);
+
+    /* single point fast path and baseline */
+    const size_t repeat = 100;
+    double sink = 0.0;
+    start = chrono::steady_clock::now();
+    for(size_t r=0;r<repeat;r++)
+        for(size_t i=0;i<route.size();i++){
+            double e, n;
+            projection.forward(route.latitude()[i], route.longitude()[i], e, n);
+            sink += e + n;
+        }
+    double single_ns = _elapsed_ns(start)/(double)(repeat*route.size());
+
+    double max_error = 0.0;
+    start = chrono::steady_clock::now();
+    for(size_t r=0;r<repeat;r++)
+        for(size_t i=0;i<route.size();i++){
+            double e, n;
+            _baseline(projection.get_latitude(), projection.get_longitude(), route.latitude()[i], route.longitude()[i], e, n);
+            sink += e + n;
+            if(r==0)
+                max_error = max(max_error, max(fabs(e-route.east()[i]), fabs(n-route.north()[i])));
+        }
+    double baseline_ns = _elapsed_ns(start)/(double)(repeat*route.size());
+
+    printf("points           : %zu\n", route.size());
+    printf("parse            : %.3f ms\n", parse_ns*1e-6);
+    printf("batch projection : %.3f ms (%.2f ns/point)\n", project_ns*1e-6, project_ns/(double)route.size());
+    printf("single point     : %.2f ns\n", single_ns);
+    printf("baseline         : %.2f ns (x%.1f)\n", baseline_ns, baseline_ns/single_ns);
+    printf("max difference   : %.3e m\n", max_error);
+    return (sink==0.123) ? 1 : 0;
+}
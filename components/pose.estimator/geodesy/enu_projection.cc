@@ -0,0 +1,115 @@
+
+#include "enu_projection.hpp"
+#include <type_traits>
+
+namespace geodesy {
+
+    void enu_projection::set_origin(double latitude, double longitude, double altitude){
+        _lat0 = latitude;
+        _lon0 = longitude;
+        _h0 = altitude;
+        _sin_lat0 = sin(latitude*deg2rad);
+        _cos_lat0 = cos(latitude*deg2rad);
+
+        const double n0 = wgs84_a/sqrt(1.0 - wgs84_e2*_sin_lat0*_sin_lat0);
+        _p0 = (n0 + altitude)*_cos_lat0;
+        _z0 = (n0*(1.0-wgs84_e2) + altitude)*_sin_lat0;
+        _valid = true;
+    }
+
+    void enu_projection::forward(const double* __restrict latitude, const double* __restrict longitude, const double* __restrict altitude,
+                                 size_t count, double* __restrict east, double* __restrict north, double* __restrict up) const {
+
+        /* branch-free series path over the whole batch (vectorized, the origin is copied to locals so the stores cannot alias it) */
+        const double lat0 = _lat0, lon0 = _lon0, h0 = _h0;
+        const double sin_lat0 = _sin_lat0, cos_lat0 = _cos_lat0, p0 = _p0, z0 = _z0;
+        auto series = [&](auto has_altitude, auto has_up){
+            for(size_t i=0;i<count;i++){
+                double dlon = longitude[i] - lon0;
+                dlon += 360.0*((double)(dlon<-180.0) - (double)(dlon>180.0));
+                double h = h0;
+                if constexpr(has_altitude)
+                    h = altitude[i];
+
+                double sd, cd, sl, cl;
+                _sincos_offset((latitude[i]-lat0)*deg2rad, sd, cd);
+                _sincos_offset(dlon*deg2rad, sl, cl);
+                const double sin_lat = sin_lat0*cd + cos_lat0*sd;
+                const double cos_lat = cos_lat0*cd - sin_lat0*sd;
+
+                const double n = wgs84_a/sqrt(1.0 - wgs84_e2*sin_lat*sin_lat);
+                const double r = (n + h)*cos_lat;
+                const double dz = (n*(1.0-wgs84_e2) + h)*sin_lat - z0;
+                const double dp = r*cl - p0;
+
+                east[i] = r*sl;
+                north[i] = -sin_lat0*dp + cos_lat0*dz;
+                if constexpr(has_up)
+                    up[i] = cos_lat0*dp + sin_lat0*dz;
+            }
+        };
+        if(altitude && up)
+            series(true_type(), true_type());
+        else if(altitude)
+            series(true_type(), false_type());
+        else if(up)
+            series(false_type(), true_type());
+        else
+            series(false_type(), false_type());
+
+        /* points far from the origin (rare) are redone with the trigonometric functions */
+        for(size_t i=0;i<count;i++){
+            if(fabs(latitude[i]-_lat0)<=max_offset_deg && fabs(longitude[i]-_lon0)<=max_offset_deg)
+                continue;
+            double e, n, u;
+            _forward_exact(latitude[i], longitude[i], altitude ? altitude[i] : _h0, e, n, u);
+            east[i] = e;
+            north[i] = n;
+            if(up)
+                up[i] = u;
+        }
+    }
+
+    void enu_projection::_forward_exact(double latitude, double longitude, double altitude, double& east, double& north, double& up) const {
+        const double lat = latitude*deg2rad;
+        const double dlon = (longitude-_lon0)*deg2rad;
+        const double sin_lat = sin(lat), cos_lat = cos(lat);
+
+        const double n = wgs84_a/sqrt(1.0 - wgs84_e2*sin_lat*sin_lat);
+        const double r = (n + altitude)*cos_lat;
+        const double dz = (n*(1.0-wgs84_e2) + altitude)*sin_lat - _z0;
+        const double dp = r*cos(dlon) - _p0;
+
+        east = r*sin(dlon);
+        north = -_sin_lat0*dp + _cos_lat0*dz;
+        up = _cos_lat0*dp + _sin_lat0*dz;
+    }
+
+    void enu_projection::inverse(double east, double north, double up, double& latitude, double& longitude, double& altitude) const {
+
+        /* ECEF in the frame rotated to the origin meridian */
+        const double x = _p0 - _sin_lat0*north + _cos_lat0*up;
+        const double y = east;
+        const double z = _z0 + _cos_lat0*north + _sin_lat0*up;
+
+        const double p = hypot(x, y);
+        longitude = _lon0 + atan2(y, x)*rad2deg;
+        if(longitude>180.0)
+            longitude -= 360.0;
+        else if(longitude<-180.0)
+            longitude += 360.0;
+
+        /* geodetic latitude and height (fixed point iteration, converges to 1e-12 rad in a few steps near the surface) */
+        double lat = atan2(z, p*(1.0-wgs84_e2));
+        double h = 0.0;
+        for(int i=0;i<5;i++){
+            const double s = sin(lat);
+            const double n = wgs84_a/sqrt(1.0 - wgs84_e2*s*s);
+            h = p/cos(lat) - n;
+            lat = atan2(z, p*(1.0 - wgs84_e2*n/(n+h)));
+        }
+        latitude = lat*rad2deg;
+        altitude = h;
+    }
+
+} /* namespace */
@@ -0,0 +1,115 @@
+/**
+ * @file enu_projection.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief WGS84 geodetic to local ENU projection with a precomputed origin (single point fast path and batch conversion)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_POSE_ESTIMATOR_ENU_PROJECTION_HPP_INCLUDED
+#define FLAME_POSE_ESTIMATOR_ENU_PROJECTION_HPP_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+
+using namespace std;
+
+namespace geodesy {
+
+    /* WGS84 */
+    static constexpr double wgs84_a = 6378137.0;
+    static constexpr double wgs84_f = 1.0/298.257223563;
+    static constexpr double wgs84_e2 = wgs84_f*(2.0-wgs84_f);
+    static constexpr double deg2rad = M_PI/180.0;
+    static constexpr double rad2deg = 180.0/M_PI;
+
+    /**
+     * @brief exact (ECEF based) projection to the local east-north-up frame of a fixed origin.
+     * the origin trigonometry is computed once. a point is expressed as an offset (dlat, dlon) from the origin,
+     * its sine and cosine come from the angle addition formulas with short series of the offset, and the ECEF
+     * rotation collapses to a few products : no trigonometric call within max_offset_deg of the origin
+     * (about 500 km, exact to double precision), std::sin/cos beyond it.
+     */
+    class enu_projection {
+        public:
+            static constexpr double max_offset_deg = 5.0;
+
+            enu_projection() = default;
+            enu_projection(double latitude, double longitude, double altitude = 0.0) { set_origin(latitude, longitude, altitude); }
+
+            void set_origin(double latitude, double longitude, double altitude = 0.0);
+            bool is_valid() const { return _valid; }
+            double get_latitude() const { return _lat0; }
+            double get_longitude() const { return _lon0; }
+            double get_altitude() const { return _h0; }
+
+            /* single point (degrees, meters above the ellipsoid) */
+            inline void forward(double latitude, double longitude, double altitude, double& east, double& north, double& up) const;
+            inline void forward(double latitude, double longitude, double& east, double& north) const;
+
+            /* batch (structure of arrays, altitude and up may be null : 0 m and not written) */
+            void forward(const double* latitude, const double* longitude, const double* altitude, size_t count,
+                         double* east, double* north, double* up) const;
+
+            /* local to geodetic (iterative, for planning and display, not on the hot path) */
+            void inverse(double east, double north, double up, double& latitude, double& longitude, double& altitude) const;
+
+        private:
+            static inline void _sincos_offset(double d, double& s, double& c);
+            inline void _forward(double latitude, double longitude, double altitude, double& east, double& north, double& up) const;
+            void _forward_exact(double latitude, double longitude, double altitude, double& east, double& north, double& up) const;
+
+        private:
+            bool _valid {false};
+            double _lat0 {0.0}, _lon0 {0.0}, _h0 {0.0};     /* degrees, meters */
+            double _sin_lat0 {0.0}, _cos_lat0 {1.0};
+            double _p0 {0.0};                               /* (N0+h0) cos(lat0) : distance from the polar axis */
+            double _z0 {0.0};                               /* ECEF z of the origin */
+
+    }; /* class */
+
+    /* sine and cosine of a small angle (|d| <= max_offset_deg, truncation below 1e-16) */
+    inline void enu_projection::_sincos_offset(double d, double& s, double& c){
+        const double d2 = d*d;
+        s = d*(1.0 - d2*(1.0/6.0 - d2*(1.0/120.0 - d2*(1.0/5040.0 - d2*(1.0/362880.0 - d2*(1.0/39916800.0))))));
+        c = 1.0 - d2*(0.5 - d2*(1.0/24.0 - d2*(1.0/720.0 - d2*(1.0/40320.0 - d2*(1.0/3628800.0 - d2*(1.0/479001600.0))))));
+    }
+
+    inline void enu_projection::_forward(double latitude, double longitude, double altitude, double& east, double& north, double& up) const {
+        double dlon = longitude - _lon0;
+        dlon += 360.0*((double)(dlon<-180.0) - (double)(dlon>180.0));
+
+        double sd, cd, sl, cl;
+        _sincos_offset((latitude-_lat0)*deg2rad, sd, cd);
+        _sincos_offset(dlon*deg2rad, sl, cl);
+        const double sin_lat = _sin_lat0*cd + _cos_lat0*sd;
+        const double cos_lat = _cos_lat0*cd - _sin_lat0*sd;
+
+        const double n = wgs84_a/sqrt(1.0 - wgs84_e2*sin_lat*sin_lat);
+        const double r = (n + altitude)*cos_lat;            /* distance from the polar axis */
+        const double dz = (n*(1.0-wgs84_e2) + altitude)*sin_lat - _z0;
+        const double dp = r*cl - _p0;                       /* along the origin meridian plane */
+
+        east = r*sl;
+        north = -_sin_lat0*dp + _cos_lat0*dz;
+        up = _cos_lat0*dp + _sin_lat0*dz;
+    }
+
+    inline void enu_projection::forward(double latitude, double longitude, double altitude, double& east, double& north, double& up) const {
+        if(fabs(latitude-_lat0)<=max_offset_deg && fabs(longitude-_lon0)<=max_offset_deg)
+            _forward(latitude, longitude, altitude, east, north, up);
+        else
+            _forward_exact(latitude, longitude, altitude, east, north, up);
+    }
+
+    inline void enu_projection::forward(double latitude, double longitude, double& east, double& north) const {
+        double up;
+        forward(latitude, longitude, _h0, east, north, up);
+    }
+
+} /* namespace */
+
+#endif
@@ -0,0 +1,110 @@
+
+#include "route_table.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+
+namespace geodesy {
+
+    static string_view _trim(string_view s){
+        while(!s.empty() && (s.front()==' ' || s.front()=='\t'))
+            s.remove_prefix(1);
+        while(!s.empty() && (s.back()==' ' || s.back()=='\t' || s.back()=='\r'))
+            s.remove_suffix(1);
+        return s;
+    }
+
+    bool route_table::load(const string& path){
+        ifstream file(path, ios::binary);
+        if(!file.is_open())
+            return false;
+        string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        return parse(text);
+    }
+
+    bool route_table::parse(string_view text){
+        _columns.clear();
+        _values.clear();
+        _latitude.clear();
+        _longitude.clear();
+        _east.clear();
+        _north.clear();
+        _n_skipped = 0;
+
+        /* header */
+        size_t end = text.find('\n');
+        string_view header = _trim(text.substr(0, end));
+        text.remove_prefix(end==string_view::npos ? text.size() : end+1);
+        while(!header.empty()){
+            size_t comma = header.find(',');
+            _columns.emplace_back(_trim(header.substr(0, comma)));
+            if(comma==string_view::npos)
+                break;
+            header.remove_prefix(comma+1);
+        }
+        const int lat_column = column("latitude");
+        const int lon_column = column("longitude");
+        if(lat_column<0 || lon_column<0)
+            return false;
+
+        /* rows (a line with a missing or non numeric field is skipped) */
+        const size_t n_columns = _columns.size();
+        const size_t estimate = (size_t)count(text.begin(), text.end(), '\n') + 1;
+        _values.reserve(estimate*n_columns);
+        _latitude.reserve(estimate);
+        _longitude.reserve(estimate);
+
+        while(!text.empty()){
+            end = text.find('\n');
+            string_view line = _trim(text.substr(0, end));
+            text.remove_prefix(end==string_view::npos ? text.size() : end+1);
+            if(line.empty())
+                continue;
+
+            size_t base = _values.size();
+            size_t n = 0;
+            const char* p = line.data();
+            const char* last = line.data()+line.size();
+            while(n<n_columns){
+                while(p<last && *p==' ')
+                    p++;
+                double v = 0.0;
+                auto [ptr, ec] = from_chars(p, last, v);
+                if(ec!=errc())
+                    break;
+                _values.push_back(v);
+                n++;
+                p = ptr;
+                while(p<last && *p==' ')
+                    p++;
+                if(p<last && *p==',')
+                    p++;
+                else
+                    break;
+            }
+            if(n!=n_columns){
+                _values.resize(base);
+                _n_skipped++;
+                continue;
+            }
+            _latitude.push_back(_values[base+lat_column]);
+            _longitude.push_back(_values[base+lon_column]);
+        }
+        return true;
+    }
+
+    void route_table::project(const enu_projection& projection){
+        _east.resize(_latitude.size());
+        _north.resize(_latitude.size());
+        projection.forward(_latitude.data(), _longitude.data(), nullptr, _latitude.size(), _east.data(), _north.data(), nullptr);
+    }
+
+    int route_table::column(string_view name) const {
+        for(size_t i=0;i<_columns.size();i++)
+            if(_columns[i]==name)
+                return (int)i;
+        return -1;
+    }
+
+} /* namespace */
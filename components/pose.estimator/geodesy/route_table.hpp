@@ -0,0 +1,64 @@
+/**
+ * @file route_table.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Route and POI file (.route, .poi CSV) loader with batch projection to the local ENU frame
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_POSE_ESTIMATOR_ROUTE_TABLE_HPP_INCLUDED
+#define FLAME_POSE_ESTIMATOR_ROUTE_TABLE_HPP_INCLUDED
+
+#include "enu_projection.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace geodesy {
+
+    /**
+     * @brief numeric CSV table with a header line (index,latitude,longitude,...).
+     * the file is read at once and parsed in place (from_chars), every column is kept (row-major) and
+     * latitude/longitude are also kept as arrays for the batch projection.
+     */
+    class route_table {
+        public:
+            route_table() = default;
+
+            /* load a file (false if it cannot be read or has no latitude/longitude columns) */
+            bool load(const string& path);
+            bool parse(string_view text);
+
+            /* project every point (fills east() and north()) */
+            void project(const enu_projection& projection);
+
+            size_t size() const { return _latitude.size(); }
+            const vector<string>& columns() const { return _columns; }
+            int column(string_view name) const;     /* -1 if missing */
+            double value(size_t row, size_t column) const { return _values[row*_columns.size()+column]; }
+
+            const vector<double>& latitude() const { return _latitude; }
+            const vector<double>& longitude() const { return _longitude; }
+            const vector<double>& east() const { return _east; }
+            const vector<double>& north() const { return _north; }
+            size_t get_skipped_lines() const { return _n_skipped; }
+
+        private:
+            vector<string> _columns;
+            vector<double> _values;
+            vector<double> _latitude;
+            vector<double> _longitude;
+            vector<double> _east;
+            vector<double> _north;
+            size_t _n_skipped {0};
+
+    }; /* class */
+
+} /* namespace */
+
+#endif
@@ -0,0 +1,349 @@
+
+#include "pose.estimator.hpp"
+#include <flame/log.hpp>
+#include <flame/config_def.hpp>
+#include "../synerex.rtk.receiver/nmea/fast/epoch.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+using namespace flame;
+using namespace std;
+
+/* create component instance */
+static pose_estimator* _instance = nullptr;
+flame::component::object* create(){ if(!_instance) _instance = new pose_estimator(); return _instance; }
+void release(){ if(_instance){ delete _instance; _instance = nullptr; }}
+
+static constexpr double _deg2rad = M_PI/180.0;
+
+static uint64_t _now_ns(){
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t _steady_ns(){
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool _ends_with(const string& topic, const char* suffix){
+    size_t n = strlen(suffix);
+    return topic.size()>=n && topic.compare(topic.size()-n, n, suffix)==0;
+}
+
+bool pose_estimator::onInit(){
+
+    try{
+
+        /* get parameters from profile */
+        json parameters = get_profile()->parameters();
+
+        pose_ekf::config conf;
+        conf.wheelbase = parameters.value("wheelbase_m", conf.wheelbase);
+        conf.accel_noise = parameters.value("accel_noise", conf.accel_noise);
+        conf.yaw_rate_noise = parameters.value("yaw_rate_noise", conf.yaw_rate_noise);
+        conf.steer_bias_noise = parameters.value("steer_bias_noise", conf.steer_bias_noise);
+        conf.initial_heading_sigma = parameters.value("initial_heading_sigma_deg", conf.initial_heading_sigma/_deg2rad)*_deg2rad;
+        conf.max_predict_dt = parameters.value("max_predict_dt_s", conf.max_predict_dt);
+        conf.max_measurement_lag = parameters.value("max_measurement_lag_s", conf.max_measurement_lag);
+        _ekf = make_unique<pose_ekf>(conf);
+
+        _steer_sign = parameters.value("steer_sign", _steer_sign);
+        _pitch_axis = parameters.value("pitch_axis", _pitch_axis);
+        _pitch_sign = parameters.value("pitch_sign", _pitch_sign);
+        _speed_sigma = parameters.value("speed_sigma", _speed_sigma);
+        _heading_sigma = parameters.value("heading_sigma_deg", _heading_sigma/_deg2rad)*_deg2rad;
+        _track_heading_sigma = parameters.value("track_heading_sigma_deg", _track_heading_sigma/_deg2rad)*_deg2rad;
+        _track_heading_min_speed = parameters.value("track_heading_min_speed", _track_heading_min_speed);
+        _gnss_timeout_s = parameters.value("gnss_timeout_s", _gnss_timeout_s);
+        _max_position_rejects = parameters.value("max_position_rejects", _max_position_rejects);
+
+        /* position sigma by GGA fix quality (0 : not used) */
+        json sigma = parameters.value("position_sigma", json::object());
+        _position_sigma.fill(0.0);
+        _position_sigma[1] = sigma.value("single", 2.5);
+        _position_sigma[2] = sigma.value("dgps", 0.7);
+        _position_sigma[3] = _position_sigma[1];
+        _position_sigma[4] = sigma.value("rtk_fixed", 0.02);
+        _position_sigma[5] = sigma.value("rtk_float", 0.3);
+
+        /* local frame origin (the first fix if not given) */
+        json origin = parameters.value("origin", json::object());
+        if(origin.contains("latitude") && origin.contains("longitude")){
+            _projection.set_origin(origin["latitude"].get<double>(), origin["longitude"].get<double>(), origin.value("altitude", 0.0));
+            logger::info("[{}] Local frame origin : {:.8f}, {:.8f}", get_name(), origin["latitude"].get<double>(), origin["longitude"].get<double>());
+        }
+
+        _last_status_ns = _now_ns();
+
+    }
+    catch(json::exception& e){
+        logger::error("Profile Error : {}", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+void pose_estimator::onLoop(){
+
+    uint64_t now_ns = _now_ns();
+    _publish_pose(now_ns);
+
+    if(now_ns-_last_status_ns>=1000000000ULL){
+        _last_status_ns = now_ns;
+        _publish_status();
+    }
+}
+
+
+void pose_estimator::onClose(){
+
+    lock_guard<mutex> lock(_mutex);
+    logger::info("[{}] Pose estimator is now stopped ({} updates, {} poses, {} resets)", get_name(),
+                _n_updates.load(), _n_published.load(), _n_resets.load());
+    _ekf.reset();
+
+}
+
+void pose_estimator::onData(flame::component::ZData& data){
+
+    try{
+        if(data.empty())
+            return;
+
+        /* inputs are told apart by the topic suffix (<component>/<port>) */
+        string topic = data.popstr();
+        if(data.empty())
+            return;
+
+        if(_ends_with(topic, "/gnss_fix")){
+            zmq::message_t message = data.pop();
+            _on_gnss_fix(message.data(), message.size());
+        }
+        else if(_ends_with(topic, "/vehicle_state")){
+            _on_vehicle_state(json::parse(data.popstr()));
+        }
+        else if(_ends_with(topic, "/inclination")){
+            _on_inclination(json::parse(data.popstr()));
+        }
+    }
+    catch(const json::exception& e){
+        logger::error("[{}] Data Parse Error : {}", get_name(), e.what());
+    }
+}
+
+void pose_estimator::_on_gnss_fix(const void* data, size_t size){
+
+    if(size<sizeof(nmea::fast::gnss_fix))
+        return;
+    nmea::fast::gnss_fix fix;
+    memcpy(&fix, data, sizeof(fix));
+    if(fix.magic!=nmea::fast::gnss_fix().magic || fix.version!=nmea::fast::gnss_fix().version)
+        return;
+    if(!(fix.flags & nmea::fast::FIX_POSITION) || !(fix.flags & nmea::fast::FIX_QUALITY))
+        return;
+
+    double sigma = (fix.fix<_position_sigma.size()) ? _position_sigma[fix.fix] : 0.0;
+    if(sigma<=0.0)
+        return;
+    if((fix.flags & nmea::fast::FIX_DOP) && fix.hdop>1.0f)
+        sigma *= (double)fix.hdop;
+
+    /* the fix belongs to the time its first sentence was received (the closest to the measurement epoch) */
+    uint64_t time_ns = (fix.rx_first_ns>0) ? fix.rx_first_ns : _now_ns();
+
+    /* heading (true degrees, clockwise) to the local frame (counter-clockwise from north) */
+    bool has_heading = false;
+    bool track_heading = false;
+    double heading = 0.0;
+    double heading_sigma = 0.0;
+    if(fix.flags & nmea::fast::FIX_HEADING){
+        if(fix.source==nmea::fast::heading_source::TRACK){
+            /* the direction of travel is checked against the wheel speed below */
+            if((fix.flags & nmea::fast::FIX_VELOCITY) && fix.speed>=_track_heading_min_speed){
+                has_heading = true;
+                track_heading = true;
+                heading_sigma = _track_heading_sigma;
+            }
+        }
+        else if(fix.source!=nmea::fast::heading_source::NONE){
+            has_heading = true;
+            heading_sigma = _heading_sigma;
+        }
+        heading = -(double)fix.heading*_deg2rad;
+    }
+
+    lock_guard<mutex> lock(_mutex);
+    if(!_ekf)
+        return;
+
+    /* course over ground is the heading only when driving forward, reversed when backing up,
+       unused while the wheels do not tell the direction (no vehicle state or about stopped) */
+    if(track_heading){
+        const double min_speed = 0.5*_track_heading_min_speed;
+        if(_wheel_speed<=-min_speed)
+            heading = wrap_angle(heading+M_PI);
+        else if(_wheel_speed<min_speed)
+            has_heading = false;
+    }
+
+    const double altitude = (double)(fix.altitude+fix.geoid_separation);   /* above the ellipsoid */
+    if(!_projection.is_valid()){
+        _projection.set_origin(fix.latitude, fix.longitude, altitude);
+        logger::info("[{}] Local frame origin (first fix) : {:.8f}, {:.8f}", get_name(), fix.latitude, fix.longitude);
+    }
+
+    /* local frame : x north, y west */
+    double east = 0.0, north = 0.0, up = 0.0;
+    _projection.forward(fix.latitude, fix.longitude, altitude, east, north, up);
+    const double x = north, y = -east;
+
+    uint64_t start_ns = _steady_ns();
+    if(!_ekf->is_initialized() || _n_position_rejected>=_max_position_rejects){
+        /* (re)initialize on the fix, the heading converges with the next measurements if it is not given */
+        if(_ekf->is_initialized()){
+            _n_resets.fetch_add(1, memory_order_relaxed);
+            logger::warn("[{}] {} consecutive fixes rejected, re-initialized on the fix", get_name(), _n_position_rejected);
+        }
+        _ekf->reset(time_ns, x, y, has_heading ? heading : 0.0, sigma);
+        _n_position_rejected = 0;
+    }
+    else if(_ekf->update_position(time_ns, x, y, sigma))
+        _n_position_rejected = 0;
+    else
+        _n_position_rejected++;
+
+    if(has_heading)
+        _ekf->update_heading(time_ns, heading, heading_sigma);
+    _count_update(start_ns);
+
+    _last_fix_ns = time_ns;
+    _last_fix_quality = fix.fix;
+}
+
+void pose_estimator::_on_vehicle_state(const json& state){
+
+    uint64_t time_ns = state.value("timestamp_ns", (uint64_t)0);
+    if(time_ns==0)
+        time_ns = _now_ns();
+    double speed = state.value("speed_kmh", 0.0)/3.6;
+    if(state.value("gear", 0)==3 && speed>0.0)     /* R with an unsigned speed */
+        speed = -speed;
+    double steering = _steer_sign*state.value("wheel_angle_deg", 0.0)*_deg2rad;
+
+    lock_guard<mutex> lock(_mutex);
+    _wheel_speed = speed;
+    if(!_ekf || !_ekf->is_initialized())
+        return;
+
+    uint64_t start_ns = _steady_ns();
+    _ekf->predict(time_ns);         /* with the previous steering */
+    _ekf->set_steering(steering);
+    _ekf->update_speed(time_ns, speed, _speed_sigma);
+    _count_update(start_ns);
+}
+
+void pose_estimator::_on_inclination(const json& tilt){
+
+    double slope = tilt.value((_pitch_axis=="z") ? "slope_z" : "slope_y", 0.0);
+
+    lock_guard<mutex> lock(_mutex);
+    _pitch = _pitch_sign*slope*_deg2rad;
+    if(_ekf)
+        _ekf->set_pitch(_pitch);
+}
+
+void pose_estimator::_publish_pose(uint64_t now_ns){
+
+    local_pose pose;
+    pose.time_ns = now_ns;
+    {
+        lock_guard<mutex> lock(_mutex);
+        if(!_ekf || !_ekf->is_initialized())
+            return;
+
+        /* extrapolate a copy, the filter itself only moves with the measurements */
+        pose_ekf ekf = *_ekf;
+        ekf.predict(now_ns);
+
+        const pose_ekf::vector_n& state = ekf.state();
+        pose.flags = 0x01;
+        pose.x = state[pose_ekf::X];
+        pose.y = state[pose_ekf::Y];
+        pose.heading = state[pose_ekf::HEADING];
+        pose.speed = state[pose_ekf::SPEED];
+        pose.steer_bias = state[pose_ekf::STEER_BIAS];
+        pose.pitch = _pitch;
+        pose.cov_xx = ekf.cov(pose_ekf::X, pose_ekf::X);
+        pose.cov_xy = ekf.cov(pose_ekf::X, pose_ekf::Y);
+        pose.cov_yy = ekf.cov(pose_ekf::Y, pose_ekf::Y);
+        pose.cov_xh = ekf.cov(pose_ekf::X, pose_ekf::HEADING);
+        pose.cov_yh = ekf.cov(pose_ekf::Y, pose_ekf::HEADING);
+        pose.cov_hh = ekf.cov(pose_ekf::HEADING, pose_ekf::HEADING);
+        pose.cov_vv = ekf.cov(pose_ekf::SPEED, pose_ekf::SPEED);
+
+        pose.gnss_age_s = (_last_fix_ns>0 && now_ns>_last_fix_ns) ? (double)(now_ns-_last_fix_ns)*1e-9 : -1.0;
+        if(pose.gnss_age_s>=0.0 && pose.gnss_age_s<_gnss_timeout_s){
+            pose.flags |= 0x02;
+            if(_last_fix_quality==4)
+                pose.flags |= 0x04;
+        }
+    }
+
+    try{
+        if(get_port("pose")->handle()!=nullptr){
+            zmq::multipart_t msg_multipart_pose;
+            msg_multipart_pose.addstr(fmt::format("{}/pose", get_name()));
+            msg_multipart_pose.addmem(&pose, sizeof(pose));
+            msg_multipart_pose.send(*get_port("pose"), ZMQ_DONTWAIT);
+            _n_published.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Pose publish error : {}", get_name(), e.what());
+    }
+}
+
+void pose_estimator::_publish_status(){
+
+    uint64_t n_updates = _n_updates.exchange(0);
+    uint64_t update_sum = _update_sum_ns.exchange(0);
+    uint64_t update_max = _update_max_ns.exchange(0);
+
+    json status;
+    status["poses"] = _n_published.load();
+    status["resets"] = _n_resets.load();
+    status["update_time_us"] = {
+        {"count", n_updates},
+        {"mean", n_updates>0 ? (double)update_sum/(double)n_updates*1e-3 : 0.0},
+        {"max", (double)update_max*1e-3}
+    };
+    {
+        lock_guard<mutex> lock(_mutex);
+        status["initialized"] = _ekf ? _ekf->is_initialized() : false;
+        status["rejected"] = _ekf ? _ekf->get_rejected_count() : 0;
+        status["late"] = _ekf ? _ekf->get_late_count() : 0;
+        status["fix_quality"] = _last_fix_quality;
+    }
+
+    try{
+        if(get_port("status")->handle()!=nullptr){
+            zmq::multipart_t msg_multipart_status;
+            msg_multipart_status.addstr(fmt::format("{}/status", get_name()));
+            msg_multipart_status.addstr(status.dump());
+            msg_multipart_status.send(*get_port("status"), ZMQ_DONTWAIT);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Status publish error : {}", get_name(), e.what());
+    }
+}
+
+void pose_estimator::_count_update(uint64_t start_ns){
+
+    uint64_t elapsed = _steady_ns()-start_ns;
+    _n_updates.fetch_add(1, memory_order_relaxed);
+    _update_sum_ns.fetch_add(elapsed, memory_order_relaxed);
+    uint64_t max = _update_max_ns.load(memory_order_relaxed);
+    while(elapsed>max && !_update_max_ns.compare_exchange_weak(max, elapsed, memory_order_relaxed));
+}
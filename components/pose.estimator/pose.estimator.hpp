@@ -0,0 +1,106 @@
+/**
+ * @file pose.estimator.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Pose estimator component (EKF fusion of RTK fixes, S1 wheel speed/steering and inclination)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_POSE_ESTIMATOR_HPP_INCLUDED
+#define FLAME_POSE_ESTIMATOR_HPP_INCLUDED
+
+#include <flame/component/object.hpp>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include "pose_ekf.hpp"
+#include "geodesy/enu_projection.hpp"
+
+using namespace std;
+
+/* local pose message (little-endian, published every cycle) */
+struct local_pose {
+    uint32_t magic {0x30534f50};    /* "POS0" */
+    uint16_t version {1};
+    uint16_t flags {0};             /* bit 0 : initialized, bit 1 : gnss valid (recent fix), bit 2 : rtk fixed */
+    uint64_t time_ns {0};           /* system clock */
+    double x {0.0};                 /* m, north of the origin */
+    double y {0.0};                 /* m, west of the origin */
+    double heading {0.0};           /* rad, counter-clockwise from north */
+    double speed {0.0};             /* m/s */
+    double steer_bias {0.0};        /* rad */
+    double pitch {0.0};             /* rad */
+    double cov_xx {0.0};
+    double cov_xy {0.0};
+    double cov_yy {0.0};
+    double cov_xh {0.0};
+    double cov_yh {0.0};
+    double cov_hh {0.0};
+    double cov_vv {0.0};
+    double gnss_age_s {0.0};        /* since the last fix (-1 : never) */
+};
+static_assert(sizeof(local_pose)==128, "local pose must be 128 bytes");
+
+class pose_estimator : public flame::component::object {
+    public:
+        pose_estimator() = default;
+        virtual ~pose_estimator() = default;
+
+        /* default interface functions */
+        bool onInit() override;
+        void onLoop() override;
+        void onClose() override;
+        void onData(flame::component::ZData& data) override;
+
+    private:
+        void _on_gnss_fix(const void* data, size_t size);
+        void _on_vehicle_state(const json& state);
+        void _on_inclination(const json& tilt);
+        void _publish_pose(uint64_t now_ns);
+        void _publish_status();
+        void _count_update(uint64_t start_ns);
+
+    private:
+        /* filter (onData and onLoop) */
+        mutex _mutex;
+        unique_ptr<pose_ekf> _ekf;
+        double _pitch {0.0};
+        uint64_t _last_fix_ns {0};
+        uint8_t _last_fix_quality {0};
+        int _n_position_rejected {0};         /* consecutive */
+        double _wheel_speed {0.0};              /* m/s, signed (negative when reversing), last vehicle_state */
+
+        /* local frame origin */
+        geodesy::enu_projection _projection;
+
+        /* parameters */
+        double _steer_sign {1.0};
+        double _pitch_sign {1.0};
+        string _pitch_axis {"y"};
+        double _speed_sigma {0.05};
+        double _heading_sigma {0.0087};         /* rad, dual antenna heading */
+        double _track_heading_sigma {0.087};    /* rad, course over ground */
+        double _track_heading_min_speed {1.0};  /* m/s */
+        double _gnss_timeout_s {1.0};
+        int _max_position_rejects {5};         /* consecutive rejected fixes before re-initializing on the fix */
+        array<double, 9> _position_sigma {};    /* m, by GGA fix quality */
+
+        /* statistics */
+        atomic<uint64_t> _n_updates {0};
+        atomic<uint64_t> _update_sum_ns {0};
+        atomic<uint64_t> _update_max_ns {0};
+        atomic<uint64_t> _n_published {0};
+        atomic<uint64_t> _n_resets {0};
+        uint64_t _last_status_ns {0};
+
+}; /* class */
+
+EXPORT_COMPONENT_API
+
+
+#endif
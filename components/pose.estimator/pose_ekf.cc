@@ -0,0 +1,227 @@
+
+#include "pose_ekf.hpp"
+#include <cmath>
+#include <algorithm>
+
+double wrap_angle(double angle){
+    angle = fmod(angle + M_PI, 2.0*M_PI);
+    if(angle<0.0)
+        angle += 2.0*M_PI;
+    return angle - M_PI;
+}
+
+pose_ekf::pose_ekf(const config& conf)
+:_config(conf){
+
+}
+
+void pose_ekf::reset(uint64_t time_ns, double x, double y, double heading, double position_sigma){
+    _x = {x, y, wrap_angle(heading), 0.0, 0.0};
+    _P.fill(0.0);
+    _P[X*N+X] = position_sigma*position_sigma;
+    _P[Y*N+Y] = position_sigma*position_sigma;
+    _P[HEADING*N+HEADING] = _config.initial_heading_sigma*_config.initial_heading_sigma;
+    _P[SPEED*N+SPEED] = 1.0;
+    _P[STEER_BIAS*N+STEER_BIAS] = 0.05*0.05;
+    _time_ns = time_ns;
+}
+
+void pose_ekf::predict(uint64_t time_ns){
+    if(_time_ns==0 || time_ns<=_time_ns)
+        return;
+    double dt = (double)(time_ns-_time_ns)*1e-9;
+    while(dt>0.0){
+        double step = min(dt, _config.max_predict_dt);
+        _propagate(step);
+        dt -= step;
+    }
+    _time_ns = time_ns;
+}
+
+void pose_ekf::_propagate(double dt){
+    const double heading = _x[HEADING];
+    const double v = _x[SPEED];
+    const double delta = _steering - _x[STEER_BIAS];
+    const double c = cos(_pitch); /* horizontal component of the travelled distance */
+    const double L = _config.wheelbase;
+    const double tan_d = tan(delta);
+    const double ch = cos(heading), sh = sin(heading);
+
+    /* state (x north, y west, heading counter-clockwise) */
+    _x[X] += v*c*ch*dt;
+    _x[Y] += v*c*sh*dt;
+    _x[HEADING] = wrap_angle(heading + v*tan_d/L*dt);
+
+    /* jacobian (identity + off-diagonal terms) */
+    matrix_n F {};
+    for(size_t i=0;i<N;i++)
+        F[i*N+i] = 1.0;
+    F[X*N+HEADING] = -v*c*sh*dt;
+    F[X*N+SPEED] = c*ch*dt;
+    F[Y*N+HEADING] = v*c*ch*dt;
+    F[Y*N+SPEED] = c*sh*dt;
+    F[HEADING*N+SPEED] = tan_d/L*dt;
+    F[HEADING*N+STEER_BIAS] = -v/(L*cos(delta)*cos(delta))*dt;
+
+    /* P = F P F^T + Q */
+    matrix_n FP {};
+    for(size_t r=0;r<N;r++)
+        for(size_t k=0;k<N;k++){
+            double f = F[r*N+k];
+            if(f==0.0)
+                continue;
+            for(size_t col=0;col<N;col++)
+                FP[r*N+col] += f*_P[k*N+col];
+        }
+    for(size_t r=0;r<N;r++)
+        for(size_t col=0;col<N;col++){
+            double sum = 0.0;
+            for(size_t k=0;k<N;k++)
+                sum += FP[r*N+k]*F[col*N+k];
+            _P[r*N+col] = sum;
+        }
+
+    /* continuous white noise : the covariance growth per second does not depend on the predict rate */
+    _P[HEADING*N+HEADING] += _config.yaw_rate_noise*_config.yaw_rate_noise*dt;
+    _P[SPEED*N+SPEED] += _config.accel_noise*_config.accel_noise*dt;
+    _P[STEER_BIAS*N+STEER_BIAS] += _config.steer_bias_noise*_config.steer_bias_noise*dt;
+    _symmetrize();
+}
+
+double pose_ekf::_lag(uint64_t time_ns) const {
+    return (time_ns<_time_ns) ? (double)(_time_ns-time_ns)*1e-9 : 0.0;
+}
+
+double pose_ekf::_yaw_rate() const {
+    return _x[SPEED]*tan(_steering - _x[STEER_BIAS])/_config.wheelbase;
+}
+
+bool pose_ekf::update_position(uint64_t time_ns, double x, double y, double sigma){
+    predict(time_ns);
+    double variance = sigma*sigma;
+
+    /* a fix received after newer vehicle states : add the distance travelled since (along the mean heading of the arc),
+       the speed uncertainty over the lag is added to the measurement noise */
+    const double lag = _lag(time_ns);
+    if(lag>_config.max_measurement_lag){
+        _n_late++;
+        return false;
+    }
+    if(lag>0.0){
+        const double distance = _x[SPEED]*cos(_pitch)*lag;
+        const double heading = _x[HEADING] - 0.5*_yaw_rate()*lag;
+        x += distance*cos(heading);
+        y += distance*sin(heading);
+        variance += _P[SPEED*N+SPEED]*lag*lag;
+    }
+
+    const double H[2*N] = {1, 0, 0, 0, 0,
+                           0, 1, 0, 0, 0};
+    const double residual[2] = {x - _x[X], y - _x[Y]};
+    const double R[4] = {variance, 0.0, 0.0, variance};
+    return _update(H, residual, R, 2, 18.4); /* chi2(2) 99.99% */
+}
+
+bool pose_ekf::update_heading(uint64_t time_ns, double heading, double sigma){
+    predict(time_ns);
+
+    /* same for the heading : turned since the measurement */
+    const double lag = _lag(time_ns);
+    if(lag>_config.max_measurement_lag){
+        _n_late++;
+        return false;
+    }
+    heading += _yaw_rate()*lag;
+
+    const double H[N] = {0, 0, 1, 0, 0};
+    const double residual[1] = {wrap_angle(heading - _x[HEADING])};
+    const double R[1] = {sigma*sigma};
+    return _update(H, residual, R, 1, 15.1); /* chi2(1) 99.99% */
+}
+
+bool pose_ekf::update_speed(uint64_t time_ns, double speed, double sigma){
+    predict(time_ns);
+    const double H[N] = {0, 0, 0, 1, 0};
+    const double residual[1] = {speed - _x[SPEED]};
+    const double R[1] = {sigma*sigma};
+    return _update(H, residual, R, 1, 15.1);
+}
+
+bool pose_ekf::_update(const double* H, const double* residual, const double* R, size_t m, double gate){
+    /* PHt = P H^T (N x m), S = H P H^T + R (m x m), m <= 2 */
+    double PHt[N*2] = {};
+    for(size_t r=0;r<N;r++)
+        for(size_t j=0;j<m;j++){
+            double sum = 0.0;
+            for(size_t k=0;k<N;k++)
+                sum += _P[r*N+k]*H[j*N+k];
+            PHt[r*2+j] = sum;
+        }
+    double S[4] = {};
+    for(size_t i=0;i<m;i++)
+        for(size_t j=0;j<m;j++){
+            double sum = R[i*m+j];
+            for(size_t k=0;k<N;k++)
+                sum += H[i*N+k]*PHt[k*2+j];
+            S[i*2+j] = sum;
+        }
+
+    /* S^-1 */
+    double Si[4] = {};
+    if(m==1){
+        if(S[0]<=0.0)
+            return false;
+        Si[0] = 1.0/S[0];
+    }
+    else{
+        double det = S[0]*S[3] - S[1]*S[2];
+        if(det<=0.0)
+            return false;
+        Si[0] = S[3]/det; Si[1] = -S[1]/det;
+        Si[2] = -S[2]/det; Si[3] = S[0]/det;
+    }
+
+    /* innovation gate (mahalanobis distance) */
+    double d2 = 0.0;
+    for(size_t i=0;i<m;i++)
+        for(size_t j=0;j<m;j++)
+            d2 += residual[i]*Si[i*2+j]*residual[j];
+    if(d2>gate){
+        _n_rejected++;
+        return false;
+    }
+
+    /* K = PHt S^-1, x += K r, P -= K H P */
+    double K[N*2] = {};
+    for(size_t r=0;r<N;r++)
+        for(size_t j=0;j<m;j++){
+            double sum = 0.0;
+            for(size_t k=0;k<m;k++)
+                sum += PHt[r*2+k]*Si[k*2+j];
+            K[r*2+j] = sum;
+        }
+    for(size_t r=0;r<N;r++)
+        for(size_t j=0;j<m;j++)
+            _x[r] += K[r*2+j]*residual[j];
+    _x[HEADING] = wrap_angle(_x[HEADING]);
+
+    /* H P = PHt^T (P symmetric) */
+    for(size_t r=0;r<N;r++)
+        for(size_t col=0;col<N;col++){
+            double sum = 0.0;
+            for(size_t j=0;j<m;j++)
+                sum += K[r*2+j]*PHt[col*2+j];
+            _P[r*N+col] -= sum;
+        }
+    _symmetrize();
+    return true;
+}
+
+void pose_ekf::_symmetrize(){
+    for(size_t r=0;r<N;r++)
+        for(size_t col=r+1;col<N;col++){
+            double v = 0.5*(_P[r*N+col] + _P[col*N+r]);
+            _P[r*N+col] = v;
+            _P[col*N+r] = v;
+        }
+}
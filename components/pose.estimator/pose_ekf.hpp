@@ -0,0 +1,95 @@
+/**
+ * @file pose_ekf.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Extended Kalman filter for the planar pose of an Ackermann vehicle (GNSS + wheel speed/steering + tilt)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_POSE_ESTIMATOR_POSE_EKF_HPP_INCLUDED
+#define FLAME_POSE_ESTIMATOR_POSE_EKF_HPP_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+/**
+ * @brief pose EKF.
+ * state : x, y (m, local frame : x north, y west), heading (rad, counter-clockwise from north), speed (m/s), steering bias (rad)
+ * the kinematic bicycle model is driven by the measured steering angle and projected on the horizontal plane with the pitch,
+ * wheel speed, GNSS position and GNSS heading are measurement updates.
+ * fixed size matrices only (no allocation), not thread-safe (the caller serializes the calls).
+ */
+class pose_ekf {
+    public:
+        static constexpr size_t N = 5;
+        enum index : size_t { X = 0, Y = 1, HEADING = 2, SPEED = 3, STEER_BIAS = 4 };
+
+        using vector_n = array<double, N>;
+        using matrix_n = array<double, N*N>;
+
+        struct config {
+            double wheelbase {1.15};            /* m */
+            double accel_noise {1.0};           /* m/s/sqrt(s) (speed random walk) */
+            double yaw_rate_noise {0.05};       /* rad/sqrt(s) (heading random walk, model error) */
+            double steer_bias_noise {0.002};    /* rad/sqrt(s) */
+            double initial_position_sigma {10.0};
+            double initial_heading_sigma {3.14};
+            double max_predict_dt {0.5};        /* s, longer gaps are predicted in steps */
+            double max_measurement_lag {0.5};   /* s, older position/heading measurements are dropped */
+        };
+
+        pose_ekf(const config& conf);
+
+        /* reset the state (first position) */
+        void reset(uint64_t time_ns, double x, double y, double heading, double position_sigma);
+        bool is_initialized() const { return _time_ns!=0; }
+
+        /* control inputs (held until the next call) */
+        void set_steering(double steering_rad) { _steering = steering_rad; }
+        void set_pitch(double pitch_rad) { _pitch = pitch_rad; }
+
+        /* propagate to time_ns (no-op if time_ns is not newer) */
+        void predict(uint64_t time_ns);
+
+        /* measurement updates at time_ns (predicted first), return false if rejected by the innovation gate.
+           a position or heading older than the filter is carried to the filter time along the current motion */
+        bool update_position(uint64_t time_ns, double x, double y, double sigma);
+        bool update_heading(uint64_t time_ns, double heading, double sigma);
+        bool update_speed(uint64_t time_ns, double speed, double sigma);
+
+        const vector_n& state() const { return _x; }
+        const matrix_n& covariance() const { return _P; }
+        double cov(size_t r, size_t c) const { return _P[r*N+c]; }
+        uint64_t get_time_ns() const { return _time_ns; }
+        uint64_t get_rejected_count() const { return _n_rejected; }
+        uint64_t get_late_count() const { return _n_late; }     /* dropped, older than max_measurement_lag */
+
+    private:
+        void _propagate(double dt);
+        double _lag(uint64_t time_ns) const; /* s, measurement behind the filter (0 if not older) */
+        double _yaw_rate() const;
+        bool _update(const double* H, const double* residual, const double* R, size_t m, double gate);
+        void _symmetrize();
+
+    private:
+        config _config;
+        vector_n _x {};
+        matrix_n _P {};
+        uint64_t _time_ns {0};
+        double _steering {0.0};
+        double _pitch {0.0};
+        uint64_t _n_rejected {0};
+        uint64_t _n_late {0};
+
+}; /* class */
+
+/* wrap an angle to [-pi, pi) */
+double wrap_angle(double angle);
+
+#endif
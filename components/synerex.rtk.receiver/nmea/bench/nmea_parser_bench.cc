@@ -0,0 +1,126 @@
+/**
+ * @file nmea_parser_bench.cc
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief NMEA parser microbenchmark (zero-allocation parser vs. split/stod baseline)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage : nmea_parser_bench [iterations]
+ */
+
+#include "../fast/message.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* sentences without checksum (appended at startup) */
+static const char* _samples[] = {
+    "GNGGA,023634.00,3724.0319873,N,12657.6634567,E,4,24,0.6,52.312,M,18.400,M,1.0,0000",
+    "GNRMC,023634.00,A,3724.0319873,N,12657.6634567,E,0.012,311.5,191026,,,R,V",
+    "GNVTG,311.5,T,,M,0.012,N,0.022,K,R",
+    "GNGSA,A,3,02,05,07,09,13,15,18,20,29,30,,,1.1,0.6,0.9,1",
+    "GPGSV,3,1,10,02,35,071,44,05,61,286,47,07,18,046,41,09,12,144,38,1",
+    "GPGSV,3,2,10,13,48,224,45,15,22,167,40,18,09,318,36,20,51,112,46,1",
+    "GNGLL,3724.0319873,N,12657.6634567,E,023634.00,A,R",
+    "GNZDA,023634.00,19,10,2026,00,00",
+};
+
+static string _with_checksum(const char* body){
+    char suffix[8];
+    snprintf(suffix, sizeof(suffix), "*%02X", nmea::fast::checksum(body));
+    return string("$") + body + suffix;
+}
+
+/* baseline : allocate a vector of strings per sentence and convert with stod */
+static double _baseline(const string& line){
+    vector<string> fields;
+    string field;
+    size_t end = line.find('*');
+    for(size_t i=1;i<end;i++){
+        if(line[i]==','){
+            fields.push_back(field);
+            field.clear();
+        }
+        else
+            field += line[i];
+    }
+    fields.push_back(field);
+
+    double sum = 0.0;
+    for(size_t i=1;i<fields.size();i++){
+        if(!fields[i].empty() && (isdigit(fields[i][0]) || fields[i][0]=='-')){
+            try { sum += stod(fields[i]); } catch(...) {}
+        }
+    }
+    return sum;
+}
+
+/* handler touching the decoded values (keeps the optimizer honest) */
+struct sink {
+    double value = 0.0;
+    void operator()(const nmea::fast::gga& m){ if(m.latitude.exists()) value += m.latitude.get() + m.longitude.get(); }
+    void operator()(const nmea::fast::rmc& m){ if(m.speed.exists()) value += m.speed.get(); }
+    void operator()(const nmea::fast::vtg& m){ if(m.speed_kph.exists()) value += m.speed_kph.get(); }
+    void operator()(const nmea::fast::gsa& m){ value += m.n_satellites; }
+    void operator()(const nmea::fast::gsv& m){ value += m.n_satellites; }
+    void operator()(const nmea::fast::gll& m){ if(m.utc.exists()) value += m.utc.get(); }
+    void operator()(const nmea::fast::zda& m){ if(m.year.exists()) value += m.year.get(); }
+};
+
+int main(int argc, char** argv){
+    size_t iterations = (argc>1) ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+    vector<string> lines;
+    for(const char* s:_samples)
+        lines.push_back(_with_checksum(s));
+    const size_t n_sentences = iterations*lines.size();
+
+    /* zero-allocation parser */
+    sink handler;
+    size_t rejected = 0;
+    nmea::fast::sentence_view sentence;
+    auto t0 = chrono::steady_clock::now();
+    for(size_t it=0;it<iterations;it++){
+        for(const string& line:lines){
+            if(nmea::fast::parse(line, sentence)!=nmea::fast::parse_result::OK){
+                rejected++;
+                continue;
+            }
+            nmea::fast::dispatch(sentence, handler);
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    double fast_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_sentences;
+
+    /* checksum only */
+    uint8_t x = 0;
+    t0 = chrono::steady_clock::now();
+    for(size_t it=0;it<iterations;it++)
+        for(const string& line:lines)
+            x ^= nmea::fast::checksum(string_view(line).substr(1, line.size()-4));
+    t1 = chrono::steady_clock::now();
+    double checksum_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_sentences;
+
+    /* baseline */
+    double baseline_value = 0.0;
+    t0 = chrono::steady_clock::now();
+    for(size_t it=0;it<iterations;it++)
+        for(const string& line:lines)
+            baseline_value += _baseline(line);
+    t1 = chrono::steady_clock::now();
+    double baseline_ns = chrono::duration<double, nano>(t1-t0).count()/(double)n_sentences;
+
+    printf("sentences          : %zu (rejected %zu)\n", n_sentences, rejected);
+    printf("checksum           : %8.1f ns/sentence\n", checksum_ns);
+    printf("parse + dispatch   : %8.1f ns/sentence (%.2f M sentences/s)\n", fast_ns, 1e3/fast_ns);
+    printf("split + stod       : %8.1f ns/sentence (%.2f M sentences/s)\n", baseline_ns, 1e3/baseline_ns);
+    printf("speedup            : %8.1f x\n", baseline_ns/fast_ns);
+    printf("(checks %g %g %u)\n", handler.value, baseline_value, x);
+    return rejected==0 ? 0 : 1;
+}
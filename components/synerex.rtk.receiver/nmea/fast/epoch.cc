@@ -0,0 +1,450 @@
+
+#include "epoch.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace nmea::fast {
+
+// GNSS system ID (NMEA 4.1) of a talker, 0 if unknown
+static uint8_t system_of(talker_id talker)
+{
+    switch(talker)
+    {
+        case talker_id::GP: return 1;
+        case talker_id::GL: return 2;
+        case talker_id::GA: return 3;
+        case talker_id::GB: return 4;
+        case talker_id::GQ: return 5;
+        case talker_id::GI: return 6;
+        default: return 0;
+    }
+}
+
+// SATELLITE TABLE
+std::size_t satellite_table::remove(std::array<gnss_satellite, capacity>& entries, std::size_t size, talker_id talker, uint8_t signal_id)
+{
+    std::size_t n = 0;
+    for(std::size_t i=0;i<size;i++)
+    {
+        if(entries[i].talker==talker && entries[i].signal_id==signal_id)
+            continue;
+        entries[n++] = entries[i];
+    }
+    return n;
+}
+
+bool satellite_table::add(const gsv& message)
+{
+    if(!message.message_count.exists() || !message.message_number.exists())
+        return false;
+    uint8_t signal_id = message.signal_id.exists() ? message.signal_id.get() : 0;
+    uint8_t number = message.message_number.get();
+    uint8_t count = message.message_count.get();
+
+    // find the cycle (or take a free one, the first one if none is free)
+    cycle* c = nullptr;
+    for(cycle& entry : m_cycles)
+    {
+        if(entry.count!=0 && entry.talker==message.talker && entry.signal_id==signal_id)
+        {
+            c = &entry;
+            break;
+        }
+        if(!c && entry.count==0)
+            c = &entry;
+    }
+    if(!c)
+        c = &m_cycles[0];
+    if(c->count==0 || c->talker!=message.talker || c->signal_id!=signal_id)
+        *c = cycle{message.talker, signal_id, 0, count};
+
+    // a cycle starts with the first sentence, anything else out of order drops it
+    if(number==1)
+    {
+        m_pending_size = remove(m_pending, m_pending_size, message.talker, signal_id);
+        c->next = 1;
+        c->count = count;
+    }
+    if(number!=c->next || count!=c->count)
+    {
+        m_pending_size = remove(m_pending, m_pending_size, message.talker, signal_id);
+        c->next = 0;
+        return false;
+    }
+
+    for(std::size_t i=0;i<message.n_satellites && m_pending_size<capacity;i++)
+    {
+        const gsv::satellite& s = message.satellites[i];
+        if(!s.prn.exists())
+            continue;
+        gnss_satellite& entry = m_pending[m_pending_size++];
+        entry.talker = message.talker;
+        entry.signal_id = signal_id;
+        entry.prn = s.prn.get();
+        entry.elevation = s.elevation.exists() ? s.elevation.get() : 0;
+        entry.azimuth = s.azimuth.exists() ? s.azimuth.get() : 0;
+        entry.snr = s.snr.exists() ? s.snr.get() : 0;
+        entry.used = 0;
+    }
+    c->next++;
+    if(number<count)
+        return false;
+
+    // complete : replace the satellites of the cycle
+    m_size = remove(m_table, m_size, message.talker, signal_id);
+    std::size_t n = 0;
+    for(std::size_t i=0;i<m_pending_size;i++)
+    {
+        const gnss_satellite& entry = m_pending[i];
+        if(entry.talker==message.talker && entry.signal_id==signal_id)
+        {
+            if(m_size<capacity)
+                m_table[m_size++] = entry;
+        }
+        else
+            m_pending[n++] = entry;
+    }
+    m_pending_size = n;
+    c->next = 0;
+    return true;
+}
+
+void satellite_table::clear()
+{
+    m_size = 0;
+    m_pending_size = 0;
+    m_cycles.fill(cycle{});
+}
+
+// EPOCH ASSEMBLER
+bool epoch_assembler::feed(const sentence_view& sentence, uint64_t rx_time_ns)
+{
+    m_closed = false;
+    m_last_part = true;
+    if(!dispatch(sentence, *this))
+        return false;
+
+    if(m_n_sentences++==0)
+        m_current.rx_first_ns = rx_time_ns;
+    m_current.rx_last_ns = rx_time_ns;
+
+    // mark the kind in the current epoch, the learnt last sentence completes it right away.
+    // a multi-part kind (GSV) is placed and terminates on its last part, so all of its parts belong to the fix
+    int k = find_kind(sentence);
+    if(k>=0 && m_last_part)
+    {
+        if(m_kinds[k].order==0)
+            m_kinds[k].order = (uint8_t)(m_n_sentences<255 ? m_n_sentences : 255);
+        if(k==m_terminator && !m_published && (m_current.flags & FIX_UTC))
+        {
+            complete(true);
+            m_published = true;
+        }
+    }
+    return m_closed;
+}
+
+int epoch_assembler::find_kind(const sentence_view& sentence)
+{
+    uint32_t key = type_key(sentence.type);
+    talker_id talker = to_talker(sentence.talker);
+    for(std::size_t i=0;i<m_n_kinds;i++)
+        if(m_kinds[i].key==key && m_kinds[i].talker==talker)
+            return (int)i;
+    if(m_n_kinds==m_kinds.size())
+        return -1;
+    m_kinds[m_n_kinds] = kind{key, talker, 0, 0};
+    return (int)m_n_kinds++;
+}
+
+std::size_t epoch_assembler::serialize(uint8_t* buffer, std::size_t size) const
+{
+    std::size_t n_satellites = m_satellites.size();
+    std::size_t bytes = sizeof(gnss_fix) + n_satellites*sizeof(gnss_satellite);
+    if(size<bytes)
+        return 0;
+
+    gnss_fix header = m_completed;
+    header.n_satellites = (uint16_t)n_satellites;
+    if(n_satellites>0)
+        header.flags |= FIX_SATELLITES;
+    std::memcpy(buffer, &header, sizeof(header));
+
+    uint8_t* p = buffer + sizeof(header);
+    for(std::size_t i=0;i<n_satellites;i++)
+    {
+        gnss_satellite entry = m_satellites[i];
+        entry.used = is_used(entry) ? 1 : 0;
+        std::memcpy(p, &entry, sizeof(entry));
+        p += sizeof(entry);
+    }
+    return bytes;
+}
+
+void epoch_assembler::begin(double utc)
+{
+    if((m_current.flags & FIX_UTC) && std::fabs(m_current.utc-utc)>1e-3)
+        finish();
+    m_current.utc = utc;
+    m_current.flags |= FIX_UTC;
+}
+
+void epoch_assembler::finish()
+{
+    if(!m_published)
+        complete(false);
+
+    // the last sentence among the kinds present in the recent 3 epochs ends an epoch
+    m_terminator = -1;
+    uint8_t last = 0;
+    for(std::size_t i=0;i<m_n_kinds;i++)
+    {
+        kind& k = m_kinds[i];
+        k.history = (uint8_t)((k.history << 1) | (k.order>0 ? 1 : 0));
+        if((k.history & 0x07)==0x07 && k.order>last)
+        {
+            last = k.order;
+            m_terminator = (int)i;
+        }
+        k.order = 0;
+    }
+
+    m_current = gnss_fix();
+    m_n_used = 0;
+    m_n_sentences = 0;
+    m_published = false;
+}
+
+void epoch_assembler::complete(bool terminated)
+{
+    m_current.epoch = ++m_epoch;
+    m_completed = m_current;
+    if(terminated)
+        m_completed.flags |= FIX_TERMINATED;
+    m_completed_used = m_used;
+    m_completed_n_used = m_n_used;
+    m_closed = true;
+}
+
+void epoch_assembler::set_heading(heading_source source, float heading)
+{
+    // course over ground only if no attitude sentence gave the heading
+    if(source==heading_source::TRACK && m_current.source>heading_source::TRACK)
+        return;
+    m_current.heading = heading;
+    m_current.source = source;
+    m_current.flags |= FIX_HEADING;
+}
+
+bool epoch_assembler::is_used(const gnss_satellite& satellite) const
+{
+    uint8_t system = system_of(satellite.talker);
+    for(std::size_t i=0;i<m_completed_n_used;i++)
+    {
+        const used_list& list = m_completed_used[i];
+        if(list.system!=0 && list.system!=system)
+            continue;
+        for(std::size_t k=0;k<list.n;k++)
+            if(list.ids[k]==satellite.prn)
+                return true;
+    }
+    return false;
+}
+
+void epoch_assembler::operator()(const gga& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+    if(m.latitude.exists() && m.longitude.exists())
+    {
+        m_current.latitude = m.latitude.get();
+        m_current.longitude = m.longitude.get();
+        m_current.flags |= FIX_POSITION;
+    }
+    if(m.altitude.exists())
+    {
+        m_current.altitude = m.altitude.get();
+        m_current.geoid_separation = m.geoid_separation.exists() ? m.geoid_separation.get() : 0.0f;
+        m_current.flags |= FIX_ALTITUDE;
+    }
+    if(m.fix.exists())
+    {
+        m_current.fix = m.fix.get();
+        m_current.satellites_used = m.satellite_count.exists() ? m.satellite_count.get() : 0;
+        m_current.flags |= FIX_QUALITY;
+    }
+    if(m.hdop.exists())
+    {
+        m_current.hdop = m.hdop.get();
+        m_current.flags |= FIX_DOP;
+    }
+    if(m.dgps_age.exists())
+        m_current.dgps_age = m.dgps_age.get();
+}
+
+void epoch_assembler::operator()(const rmc& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+    if(!(m_current.flags & FIX_POSITION) && m.latitude.exists() && m.longitude.exists())
+    {
+        m_current.latitude = m.latitude.get();
+        m_current.longitude = m.longitude.get();
+        m_current.flags |= FIX_POSITION;
+    }
+    if(m.speed.exists())
+    {
+        m_current.speed = m.speed.get()*0.514444f;
+        m_current.track = m.track_angle.exists() ? m.track_angle.get() : 0.0f;
+        m_current.flags |= FIX_VELOCITY;
+        if(m.track_angle.exists())
+            set_heading(heading_source::TRACK, m.track_angle.get());
+    }
+    if(m.date.exists())
+    {
+        m_current.day = m.date.get().day;
+        m_current.month = m.date.get().month;
+        m_current.year = (uint16_t)(2000 + m.date.get().year);
+        m_current.flags |= FIX_DATE;
+    }
+}
+
+void epoch_assembler::operator()(const vtg& m)
+{
+    if(m.speed_kph.exists())
+        m_current.speed = m.speed_kph.get()/3.6f;
+    else if(m.speed_knots.exists())
+        m_current.speed = m.speed_knots.get()*0.514444f;
+    else
+        return;
+    m_current.track = m.track_angle_true.exists() ? m.track_angle_true.get() : 0.0f;
+    m_current.flags |= FIX_VELOCITY;
+    if(m.track_angle_true.exists())
+        set_heading(heading_source::TRACK, m.track_angle_true.get());
+}
+
+void epoch_assembler::operator()(const gsa& m)
+{
+    if(m.pdop.exists()) m_current.pdop = m.pdop.get();
+    if(m.vdop.exists()) m_current.vdop = m.vdop.get();
+    if(m.hdop.exists())
+    {
+        m_current.hdop = m.hdop.get();
+        m_current.flags |= FIX_DOP;
+    }
+    if(m_n_used<m_used.size())
+    {
+        used_list& list = m_used[m_n_used++];
+        list.system = m.system.exists() ? m.system.get() : system_of(m.talker);
+        list.n = m.n_satellites;
+        list.ids = m.satellites;
+    }
+}
+
+void epoch_assembler::operator()(const gsv& m)
+{
+    if(m.message_number.exists() && m.message_count.exists())
+        m_last_part = m.message_number.get()>=m.message_count.get();
+    m_satellites.add(m);
+}
+
+void epoch_assembler::operator()(const gll& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+    if(!(m_current.flags & FIX_POSITION) && m.latitude.exists() && m.longitude.exists())
+    {
+        m_current.latitude = m.latitude.get();
+        m_current.longitude = m.longitude.get();
+        m_current.flags |= FIX_POSITION;
+    }
+}
+
+void epoch_assembler::operator()(const zda& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+    if(m.day.exists() && m.month.exists() && m.year.exists())
+    {
+        m_current.day = m.day.get();
+        m_current.month = m.month.get();
+        m_current.year = m.year.get();
+        m_current.flags |= FIX_DATE;
+    }
+}
+
+void epoch_assembler::operator()(const hdt& m)
+{
+    if(m.heading.exists())
+        set_heading(heading_source::HDT, m.heading.get());
+}
+
+void epoch_assembler::operator()(const ths& m)
+{
+    if(m.heading.exists() && !(m.mode.exists() && m.mode.get()==nmea::mode::INVALID))
+        set_heading(heading_source::THS, m.heading.get());
+}
+
+void epoch_assembler::operator()(const pashr& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+    if(m.heading.exists())
+    {
+        set_heading(heading_source::PASHR, m.heading.get());
+        m_current.heading_quality = m.gps_quality.exists() ? m.gps_quality.get() : 0;
+    }
+    if(m.pitch.exists() && m.roll.exists())
+    {
+        m_current.pitch = m.pitch.get();
+        m_current.roll = m.roll.get();
+        m_current.flags |= FIX_ATTITUDE;
+    }
+}
+
+void epoch_assembler::operator()(const ksxt& m)
+{
+    if(m.utc.exists())
+        begin(m.utc.get());
+
+    // heading quality 0 : no heading solution
+    if(m.heading.exists() && !(m.heading_quality.exists() && m.heading_quality.get()==0))
+    {
+        set_heading(heading_source::KSXT, m.heading.get());
+        m_current.heading_quality = m.heading_quality.exists() ? m.heading_quality.get() : 0;
+        if(m.pitch.exists() && m.roll.exists())
+        {
+            m_current.pitch = m.pitch.get();
+            m_current.roll = m.roll.get();
+            m_current.flags |= FIX_ATTITUDE;
+        }
+    }
+
+    // position and velocity only if no GGA/RMC gave them
+    if(!(m_current.flags & FIX_POSITION) && m.latitude.exists() && m.longitude.exists() && m.position_quality.exists() && m.position_quality.get()>0)
+    {
+        m_current.latitude = m.latitude.get();
+        m_current.longitude = m.longitude.get();
+        m_current.flags |= FIX_POSITION;
+        if(m.height.exists())
+        {
+            m_current.altitude = m.height.get();
+            m_current.flags |= FIX_ALTITUDE;
+        }
+    }
+    if(!(m_current.flags & FIX_VELOCITY) && m.speed_kph.exists())
+    {
+        m_current.speed = m.speed_kph.get()/3.6f;
+        m_current.track = m.track_angle.exists() ? m.track_angle.get() : 0.0f;
+        m_current.flags |= FIX_VELOCITY;
+    }
+    if(!(m_current.flags & FIX_DATE) && m.date.exists())
+    {
+        m_current.day = m.date.get().day;
+        m_current.month = m.date.get().month;
+        m_current.year = (uint16_t)(2000 + m.date.get().year);
+        m_current.flags |= FIX_DATE;
+    }
+}
+
+}
@@ -0,0 +1,211 @@
+/// \file nmea/fast/epoch.hpp
+/// \brief Defines the GSV cycle assembly and the per-epoch consolidation into one binary fix and heading message.
+#ifndef NMEA___FAST_EPOCH_H
+#define NMEA___FAST_EPOCH_H
+
+#include "message.hpp"
+
+namespace nmea::fast {
+
+// WIRE FORMAT
+/// \brief Validity flags of the fix message.
+enum fix_flags : uint32_t
+{
+    FIX_UTC         = 1u << 0,      ///< utc
+    FIX_DATE        = 1u << 1,      ///< day, month, year
+    FIX_POSITION    = 1u << 2,      ///< latitude, longitude
+    FIX_ALTITUDE    = 1u << 3,      ///< altitude, geoid_separation
+    FIX_QUALITY     = 1u << 4,      ///< fix, satellites_used
+    FIX_DOP         = 1u << 5,      ///< hdop (pdop, vdop if a GSA was received)
+    FIX_VELOCITY    = 1u << 6,      ///< speed, track
+    FIX_HEADING     = 1u << 7,      ///< heading, heading_source
+    FIX_ATTITUDE    = 1u << 8,      ///< pitch, roll
+    FIX_SATELLITES  = 1u << 9,      ///< satellite table appended
+    FIX_TERMINATED  = 1u << 10      ///< completed by the learned last sentence of the epoch (otherwise by the next UTC)
+};
+
+/// \brief Source of the heading.
+enum class heading_source : uint8_t
+{
+    NONE = 0,
+    TRACK,          ///< Course over ground (RMC/VTG), used only without an attitude sentence.
+    HDT,
+    THS,
+    PASHR,
+    KSXT
+};
+
+/// \brief Consolidated fix and heading of one epoch (little-endian, followed by n_satellites gnss_satellite entries).
+struct gnss_fix
+{
+    uint32_t magic {0x30584647};    ///< "GFX0"
+    uint16_t version {2};
+    uint16_t n_satellites {0};      ///< Satellite entries following the header.
+    uint32_t flags {0};             ///< fix_flags
+    uint32_t epoch {0};             ///< Epoch counter.
+    uint64_t rx_first_ns {0};       ///< Host receive time of the first sentence of the epoch (ns, system clock).
+    uint64_t rx_last_ns {0};        ///< Host receive time of the last sentence of the epoch.
+    double utc {0.0};               ///< Seconds of day.
+    double latitude {0.0};          ///< Degrees.
+    double longitude {0.0};         ///< Degrees.
+    float altitude {0.0f};          ///< Meters above mean sea level.
+    float geoid_separation {0.0f};  ///< Meters.
+    float hdop {0.0f};
+    float pdop {0.0f};
+    float vdop {0.0f};
+    float speed {0.0f};             ///< m/s over ground.
+    float track {0.0f};             ///< Course over ground, true degrees.
+    float heading {0.0f};           ///< True degrees.
+    float pitch {0.0f};             ///< Degrees.
+    float roll {0.0f};              ///< Degrees.
+    float dgps_age {0.0f};          ///< Seconds since the last correction.
+    uint8_t fix {0};                ///< GGA fix quality (0 none, 1 GPS, 2 DGPS, 4 RTK fixed, 5 RTK float, ...).
+    uint8_t satellites_used {0};
+    heading_source source {heading_source::NONE};
+    uint8_t heading_quality {0};    ///< KSXT heading quality or PASHR GPS quality (0 if not reported).
+    uint8_t day {0};
+    uint8_t month {0};
+    uint16_t year {0};
+    uint8_t reserved[4] {};
+};
+static_assert(sizeof(gnss_fix)==112, "gnss_fix must be 112 bytes");
+
+/// \brief A satellite in view (entry of the satellite table).
+struct gnss_satellite
+{
+    talker_id talker {talker_id::UNKNOWN};  ///< Constellation of the GSV cycle.
+    uint8_t signal_id {0};                  ///< Signal ID (NMEA 4.1, 0 if not reported).
+    uint8_t prn {0};
+    uint8_t elevation {0};                  ///< Degrees.
+    uint16_t azimuth {0};                   ///< Degrees from true north.
+    uint8_t snr {0};                        ///< dB-Hz (0 if not tracked).
+    uint8_t used {0};                       ///< 1 if listed in the GSA of the epoch.
+};
+static_assert(sizeof(gnss_satellite)==8, "gnss_satellite must be 8 bytes");
+
+// GSV CYCLE ASSEMBLY
+/// \brief Assembles multi-sentence GSV cycles into one satellite table.
+/// \details A cycle (one talker and signal) replaces the previous satellites of the same cycle only when all its
+/// sentences arrived in order; an incomplete or out of order cycle is dropped. No allocation.
+class satellite_table
+{
+public:
+    /// \brief Maximum number of satellites in the table.
+    static constexpr std::size_t capacity = 128;
+
+    /// \brief Adds a GSV sentence.
+    /// \returns TRUE if the sentence completed a cycle.
+    bool add(const gsv& message);
+
+    /// \brief Clears the table and the pending cycles.
+    void clear();
+
+    std::size_t size() const { return m_size; }
+    const gnss_satellite& operator[](std::size_t index) const { return m_table[index]; }
+
+private:
+    /// \brief A GSV cycle in progress.
+    struct cycle
+    {
+        talker_id talker {talker_id::UNKNOWN};
+        uint8_t signal_id {0};
+        uint8_t next {0};       ///< Next expected message number (0 if not in progress).
+        uint8_t count {0};
+    };
+
+    static std::size_t remove(std::array<gnss_satellite, capacity>& entries, std::size_t size, talker_id talker, uint8_t signal_id);
+
+    std::array<gnss_satellite, capacity> m_table {};
+    std::size_t m_size {0};
+    std::array<gnss_satellite, capacity> m_pending {};
+    std::size_t m_pending_size {0};
+    std::array<cycle, 16> m_cycles {};
+};
+
+// EPOCH ASSEMBLY
+/// \brief Consolidates the sentences of an epoch (same UTC) into one gnss_fix.
+/// \details Sentences with UTC (GGA, RMC, GLL, ZDA, PASHR, KSXT) open a new epoch when their time differs from the
+/// current one. Sentences without UTC (GSA, GSV, VTG, HDT, THS) belong to the current epoch.
+/// The assembler learns which sentence ends an epoch (the last one among the sentences present in each of the
+/// recent epochs), and completes the epoch as soon as it arrives, without waiting for the next UTC. Until learnt,
+/// or if it is missing, the epoch completes with the next UTC. Late sentences of a completed epoch are ignored.
+/// No allocation.
+class epoch_assembler
+{
+public:
+    /// \brief Feeds a sliced sentence.
+    /// \param rx_time_ns Host receive time of the sentence.
+    /// \returns TRUE if the sentence completed an epoch (see completed()).
+    bool feed(const sentence_view& sentence, uint64_t rx_time_ns = 0);
+
+    /// \brief Gets the last completed epoch.
+    const gnss_fix& completed() const { return m_completed; }
+
+    /// \brief Gets the satellite table.
+    const satellite_table& satellites() const { return m_satellites; }
+
+    /// \brief Gets the buffer size needed by serialize().
+    static constexpr std::size_t max_message_size() { return sizeof(gnss_fix) + satellite_table::capacity*sizeof(gnss_satellite); }
+
+    /// \brief Writes the last completed epoch with the satellite table.
+    /// \returns The number of bytes written, 0 if the buffer is too small.
+    std::size_t serialize(uint8_t* buffer, std::size_t size) const;
+
+    // Handlers (called by dispatch)
+    void operator()(const gga& message);
+    void operator()(const rmc& message);
+    void operator()(const vtg& message);
+    void operator()(const gsa& message);
+    void operator()(const gsv& message);
+    void operator()(const gll& message);
+    void operator()(const zda& message);
+    void operator()(const hdt& message);
+    void operator()(const ths& message);
+    void operator()(const pashr& message);
+    void operator()(const ksxt& message);
+
+private:
+    /// \brief Used satellite IDs of a GSA (per GNSS system).
+    struct used_list
+    {
+        uint8_t system {0};     ///< GNSS system ID (0 if unknown, matches every talker).
+        uint8_t n {0};
+        std::array<uint8_t, 12> ids {};
+    };
+
+    /// \brief A sentence kind (type and talker) seen in the stream.
+    struct kind
+    {
+        uint32_t key {0};
+        talker_id talker {talker_id::UNKNOWN};
+        uint8_t history {0};    ///< Presence in the recent epochs (bit 0 : last epoch).
+        uint8_t order {0};      ///< Arrival order of its last part in the current epoch (0 if absent).
+    };
+
+    void begin(double utc);
+    void finish();
+    void complete(bool terminated);
+    int find_kind(const sentence_view& sentence);
+    void set_heading(heading_source source, float heading);
+    bool is_used(const gnss_satellite& satellite) const;
+
+    gnss_fix m_current;
+    gnss_fix m_completed;
+    uint32_t m_epoch {0};
+    bool m_closed {false};
+    bool m_published {false};   ///< Current epoch already completed by its last sentence.
+    bool m_last_part {true};    ///< Sentence being fed is the last part of its kind (GSV : message number = count).
+    std::size_t m_n_sentences {0}; ///< Sentences in the current epoch.
+    std::array<kind, 24> m_kinds {};
+    std::size_t m_n_kinds {0};
+    int m_terminator {-1};      ///< Kind that ends an epoch (-1 if not learnt).
+    std::array<used_list, 8> m_used {};
+    std::size_t m_n_used {0};
+    std::array<used_list, 8> m_completed_used {};
+    std::size_t m_completed_n_used {0};
+    satellite_table m_satellites;
+};
+
+}
+
+#endif
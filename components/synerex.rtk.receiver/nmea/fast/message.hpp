@@ -0,0 +1,250 @@
+/// \file nmea/fast/message.hpp
+/// \brief Defines the fixed size NMEA messages decoded by the zero-allocation parser, and the compile-time dispatch.
+#ifndef NMEA___FAST_MESSAGE_H
+#define NMEA___FAST_MESSAGE_H
+
+#include "parser.hpp"
+#include "../field.hpp"
+#include "../object/date.hpp"
+#include "../object/mode.hpp"
+#include "../object/status.hpp"
+
+namespace nmea::fast {
+
+/// \brief Enumerates the talkers.
+enum class talker_id : uint8_t
+{
+    UNKNOWN = 0,
+    GP,             ///< GPS
+    GL,             ///< GLONASS
+    GA,             ///< Galileo
+    GB,             ///< BeiDou (GB/BD)
+    GQ,             ///< QZSS
+    GI,             ///< NavIC
+    GN,             ///< Multi-constellation
+    PROPRIETARY,    ///< 'P' sentences
+    NONE            ///< No talker in the address (e.g. KSXT)
+};
+
+/// \brief Converts the talker of a sentence.
+constexpr talker_id to_talker(std::string_view talker)
+{
+    if(talker.empty()) return talker_id::NONE;
+    if(talker=="P") return talker_id::PROPRIETARY;
+    if(talker=="GP") return talker_id::GP;
+    if(talker=="GL") return talker_id::GL;
+    if(talker=="GA") return talker_id::GA;
+    if(talker=="GB" || talker=="BD") return talker_id::GB;
+    if(talker=="GQ") return talker_id::GQ;
+    if(talker=="GI") return talker_id::GI;
+    if(talker=="GN") return talker_id::GN;
+    return talker_id::UNKNOWN;
+}
+
+/// \brief A GGA sentence (fix data).
+struct gga
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> utc;                ///< UTC time of day, in seconds.
+    nmea::field<double> latitude;           ///< Degrees (N = +, S = -).
+    nmea::field<double> longitude;          ///< Degrees (E = +, W = -).
+    nmea::field<uint8_t> fix;               ///< Fix quality (0 none, 1 GPS, 2 DGPS, 4 RTK fixed, 5 RTK float, 6 estimated, ...).
+    nmea::field<uint8_t> satellite_count;   ///< Satellites used in the fix.
+    nmea::field<float> hdop;                ///< Horizontal dilution of precision.
+    nmea::field<float> altitude;            ///< Meters above mean sea level.
+    nmea::field<float> geoid_separation;    ///< Meters.
+    nmea::field<float> dgps_age;            ///< Seconds since the last differential correction.
+    nmea::field<uint16_t> dgps_station;     ///< Differential reference station ID.
+};
+
+/// \brief An RMC sentence (recommended minimum data).
+struct rmc
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> utc;
+    nmea::field<nmea::status> status;
+    nmea::field<double> latitude;
+    nmea::field<double> longitude;
+    nmea::field<float> speed;               ///< Knots.
+    nmea::field<float> track_angle;         ///< True degrees.
+    nmea::field<nmea::date> date;
+    nmea::field<float> magnetic_variation;  ///< Degrees (E = +, W = -).
+    nmea::field<nmea::mode> mode;
+};
+
+/// \brief A VTG sentence (track and ground speed).
+struct vtg
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<float> track_angle_true;
+    nmea::field<float> track_angle_magnetic;
+    nmea::field<float> speed_knots;
+    nmea::field<float> speed_kph;
+    nmea::field<nmea::mode> mode;
+};
+
+/// \brief A GSA sentence (DOP and active satellites).
+struct gsa
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<char> mode;                 ///< 'M' manual, 'A' automatic.
+    nmea::field<uint8_t> fix;               ///< 1 none, 2 2D, 3 3D.
+    std::array<uint8_t, 12> satellites {};  ///< Satellite IDs used in the fix.
+    uint8_t n_satellites {0};
+    nmea::field<float> pdop;
+    nmea::field<float> hdop;
+    nmea::field<float> vdop;
+    nmea::field<uint8_t> system;            ///< GNSS system ID (NMEA 4.1).
+};
+
+/// \brief A GSV sentence (satellites in view, one part of a GSV cycle).
+struct gsv
+{
+    /// \brief A satellite in view.
+    struct satellite
+    {
+        nmea::field<uint8_t> prn;
+        nmea::field<uint8_t> elevation;     ///< Degrees.
+        nmea::field<uint16_t> azimuth;      ///< Degrees from true north.
+        nmea::field<uint8_t> snr;           ///< dB-Hz.
+    };
+
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<uint8_t> message_count;
+    nmea::field<uint8_t> message_number;
+    nmea::field<uint8_t> satellite_count;
+    std::array<satellite, 4> satellites {};
+    uint8_t n_satellites {0};
+    nmea::field<uint8_t> signal_id;         ///< Signal ID (NMEA 4.1).
+};
+
+/// \brief A GLL sentence (geographic position).
+struct gll
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> latitude;
+    nmea::field<double> longitude;
+    nmea::field<double> utc;
+    nmea::field<nmea::status> status;
+    nmea::field<nmea::mode> mode;
+};
+
+/// \brief A ZDA sentence (time and date).
+struct zda
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> utc;
+    nmea::field<uint8_t> day;
+    nmea::field<uint8_t> month;
+    nmea::field<uint16_t> year;
+    nmea::field<int8_t> gmt_offset_hours;
+    nmea::field<uint8_t> gmt_offset_minutes;
+};
+
+/// \brief An HDT sentence (true heading).
+struct hdt
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<float> heading;             ///< True degrees.
+};
+
+/// \brief A THS sentence (true heading and status).
+struct ths
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<float> heading;             ///< True degrees.
+    nmea::field<nmea::mode> mode;           ///< 'V' (not valid) is INVALID.
+};
+
+/// \brief A PASHR sentence (attitude, Ashtech/Hemisphere).
+struct pashr
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> utc;
+    nmea::field<float> heading;             ///< True degrees.
+    nmea::field<float> roll;                ///< Degrees.
+    nmea::field<float> pitch;               ///< Degrees.
+    nmea::field<float> heave;               ///< Meters.
+    nmea::field<float> roll_accuracy;       ///< Degrees (1 sigma).
+    nmea::field<float> pitch_accuracy;      ///< Degrees (1 sigma).
+    nmea::field<float> heading_accuracy;    ///< Degrees (1 sigma).
+    nmea::field<uint8_t> gps_quality;       ///< 0 no fix, 1 GPS, 2 RTK.
+    nmea::field<uint8_t> ins_status;        ///< 0 no INS, 1 INS aligned.
+};
+
+/// \brief A KSXT sentence (position, attitude and velocity, Unicore/ComNav).
+struct ksxt
+{
+    talker_id talker {talker_id::UNKNOWN};
+    nmea::field<double> utc;
+    nmea::field<nmea::date> date;
+    nmea::field<double> longitude;          ///< Degrees.
+    nmea::field<double> latitude;           ///< Degrees.
+    nmea::field<float> height;              ///< Meters (ellipsoid).
+    nmea::field<float> heading;             ///< True degrees.
+    nmea::field<float> pitch;               ///< Degrees.
+    nmea::field<float> track_angle;         ///< True degrees.
+    nmea::field<float> speed_kph;
+    nmea::field<float> roll;                ///< Degrees.
+    nmea::field<uint8_t> position_quality;  ///< 0 none, 1 single, 2 pseudorange differential, 3 RTK float, 4 RTK fixed.
+    nmea::field<uint8_t> heading_quality;   ///< Same values as the position quality.
+    nmea::field<uint8_t> heading_satellites;
+    nmea::field<uint8_t> position_satellites;
+};
+
+// DECODING
+/// \brief Decodes a sliced sentence into a message, returns FALSE if the sentence is not of the message type.
+bool decode(const sentence_view& sentence, gga& message);
+bool decode(const sentence_view& sentence, rmc& message);
+bool decode(const sentence_view& sentence, vtg& message);
+bool decode(const sentence_view& sentence, gsa& message);
+bool decode(const sentence_view& sentence, gsv& message);
+bool decode(const sentence_view& sentence, gll& message);
+bool decode(const sentence_view& sentence, zda& message);
+bool decode(const sentence_view& sentence, hdt& message);
+bool decode(const sentence_view& sentence, ths& message);
+bool decode(const sentence_view& sentence, pashr& message);
+bool decode(const sentence_view& sentence, ksxt& message);
+
+/// \brief Decodes the message and calls the handler, only if the handler accepts the message type (resolved at compile time).
+template <class Message, class Handler>
+inline bool invoke(const sentence_view& sentence, Handler& handler)
+{
+    if constexpr (std::is_invocable_v<Handler&, const Message&>)
+    {
+        Message message;
+        if(!decode(sentence, message))
+            return false;
+        handler(static_cast<const Message&>(message));
+        return true;
+    }
+    else
+        return false;
+}
+
+/// \brief Decodes a sliced sentence by its type and calls the matching handler overload.
+/// \returns TRUE if the sentence was handled.
+/// \note Message types without a handler overload are skipped without decoding.
+template <class Handler>
+inline bool dispatch(const sentence_view& sentence, Handler&& handler)
+{
+    switch(type_key(sentence.type))
+    {
+        case type_key("GGA"): return invoke<gga>(sentence, handler);
+        case type_key("RMC"): return invoke<rmc>(sentence, handler);
+        case type_key("VTG"): return invoke<vtg>(sentence, handler);
+        case type_key("GSA"): return invoke<gsa>(sentence, handler);
+        case type_key("GSV"): return invoke<gsv>(sentence, handler);
+        case type_key("GLL"): return invoke<gll>(sentence, handler);
+        case type_key("ZDA"): return invoke<zda>(sentence, handler);
+        case type_key("HDT"): return invoke<hdt>(sentence, handler);
+        case type_key("THS"): return invoke<ths>(sentence, handler);
+        case type_key("ASHR"): return invoke<pashr>(sentence, handler);
+        case type_key("KSXT"): return invoke<ksxt>(sentence, handler);
+        default: return false;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,387 @@
+
+#include "parser.hpp"
+#include "message.hpp"
+#include <cstring>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__aarch64__)
+    #include <arm_neon.h>
+#endif
+
+namespace nmea::fast {
+
+uint8_t checksum(std::string_view body)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(body.data());
+    std::size_t n = body.size();
+    std::size_t i = 0;
+    uint8_t sum = 0;
+
+#if defined(__SSE2__)
+    if(n>=16)
+    {
+        __m128i acc = _mm_setzero_si128();
+        for(;i+16<=n;i+=16)
+            acc = _mm_xor_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i)));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+        sum = (uint8_t)_mm_cvtsi128_si32(acc);
+    }
+#elif defined(__aarch64__)
+    if(n>=16)
+    {
+        uint8x16_t acc = vdupq_n_u8(0);
+        for(;i+16<=n;i+=16)
+            acc = veorq_u8(acc, vld1q_u8(p+i));
+        uint8x8_t v = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+        uint64_t x = vget_lane_u64(vreinterpret_u64_u8(v), 0);
+        x ^= x >> 32; x ^= x >> 16; x ^= x >> 8;
+        sum = (uint8_t)x;
+    }
+#endif
+    for(;i<n;i++)
+        sum ^= p[i];
+    return sum;
+}
+
+static inline int hex_value(char c)
+{
+    if(c>='0' && c<='9') return c-'0';
+    if(c>='A' && c<='F') return c-'A'+10;
+    if(c>='a' && c<='f') return c-'a'+10;
+    return -1;
+}
+
+parse_result parse(std::string_view line, sentence_view& sentence, bool require_checksum)
+{
+    sentence.n_fields = 0;
+    if(line.size()<6 || (line[0]!='$' && line[0]!='!'))
+        return parse_result::FRAMING;
+
+    // checksum "*hh" at the end
+    std::string_view body;
+    if(line.size()>=4 && line[line.size()-3]=='*')
+    {
+        body = line.substr(1, line.size()-4);
+        int hi = hex_value(line[line.size()-2]);
+        int lo = hex_value(line[line.size()-1]);
+        if(hi<0 || lo<0)
+            return parse_result::FRAMING;
+        if(checksum(body)!=(uint8_t)(hi<<4 | lo))
+            return parse_result::CHECKSUM;
+    }
+    else if(require_checksum)
+        return parse_result::FRAMING;
+    else
+        body = line.substr(1);
+
+    // address field
+    std::size_t comma = body.find(',');
+    std::string_view address = body.substr(0, comma);
+    if(address.empty())
+        return parse_result::FRAMING;
+    if(address[0]=='P')
+    {
+        sentence.talker = address.substr(0, 1);
+        sentence.type = address.substr(1);
+    }
+    else if(address.size()==5)
+    {
+        sentence.talker = address.substr(0, 2);
+        sentence.type = address.substr(2);
+    }
+    else
+    {
+        sentence.talker = std::string_view();
+        sentence.type = address;
+    }
+
+    // data fields (memchr per field)
+    if(comma==std::string_view::npos)
+        return parse_result::OK;
+    const char* p = body.data()+comma+1;
+    const char* end = body.data()+body.size();
+    while(sentence.n_fields<max_fields)
+    {
+        const char* next = static_cast<const char*>(std::memchr(p, ',', (std::size_t)(end-p)));
+        if(!next)
+        {
+            sentence.fields[sentence.n_fields++] = std::string_view(p, (std::size_t)(end-p));
+            break;
+        }
+        sentence.fields[sentence.n_fields++] = std::string_view(p, (std::size_t)(next-p));
+        p = next+1;
+    }
+    return parse_result::OK;
+}
+
+bool to_degrees(std::string_view field, std::string_view hemisphere, double& degrees)
+{
+    double value = 0.0;
+    if(!to_number(field, value))
+        return false;
+
+    // (d)ddmm.mmmm
+    double deg = (double)(int64_t)(value/100.0);
+    degrees = deg + (value - deg*100.0)/60.0;
+    if(!hemisphere.empty() && (hemisphere[0]=='S' || hemisphere[0]=='W'))
+        degrees = -degrees;
+    return true;
+}
+
+bool to_utc(std::string_view field, double& seconds)
+{
+    if(field.size()<6)
+        return false;
+    int hh = 0, mm = 0;
+    double ss = 0.0;
+    if(!to_number(field.substr(0, 2), hh) || !to_number(field.substr(2, 2), mm) || !to_number(field.substr(4), ss))
+        return false;
+    seconds = hh*3600.0 + mm*60.0 + ss;
+    return true;
+}
+
+// field helpers (set only if the field converts)
+template <class T>
+static inline void set_number(nmea::field<T>& field, std::string_view text)
+{
+    T value;
+    if(to_number(text, value))
+        field.set(value);
+}
+
+static inline void set_degrees(nmea::field<double>& field, std::string_view text, std::string_view hemisphere)
+{
+    double value;
+    if(to_degrees(text, hemisphere, value))
+        field.set(value);
+}
+
+static inline void set_utc(nmea::field<double>& field, std::string_view text)
+{
+    double value;
+    if(to_utc(text, value))
+        field.set(value);
+}
+
+static inline void set_status(nmea::field<nmea::status>& field, std::string_view text)
+{
+    if(text=="A") field.set(nmea::status::ACTIVE);
+    else if(text=="V") field.set(nmea::status::VOID);
+}
+
+static inline void set_mode(nmea::field<nmea::mode>& field, std::string_view text)
+{
+    if(text.empty())
+        return;
+    switch(text[0])
+    {
+        case 'A': field.set(nmea::mode::AUTONOMOUS); break;
+        case 'D': case 'R': case 'F': field.set(nmea::mode::DIFFERENTIAL); break; // RTK fixed/float are differential
+        case 'E': field.set(nmea::mode::ESTIMATED); break;
+        case 'M': field.set(nmea::mode::MANUAL); break;
+        case 'S': field.set(nmea::mode::SIMULATED); break;
+        case 'N': case 'V': field.set(nmea::mode::INVALID); break;
+        default: break;
+    }
+}
+
+bool decode(const sentence_view& s, gga& m)
+{
+    if(type_key(s.type)!=type_key("GGA"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_utc(m.utc, s.field(0));
+    set_degrees(m.latitude, s.field(1), s.field(2));
+    set_degrees(m.longitude, s.field(3), s.field(4));
+    set_number(m.fix, s.field(5));
+    set_number(m.satellite_count, s.field(6));
+    set_number(m.hdop, s.field(7));
+    set_number(m.altitude, s.field(8));
+    set_number(m.geoid_separation, s.field(10));
+    set_number(m.dgps_age, s.field(12));
+    set_number(m.dgps_station, s.field(13));
+    return true;
+}
+
+bool decode(const sentence_view& s, rmc& m)
+{
+    if(type_key(s.type)!=type_key("RMC"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_utc(m.utc, s.field(0));
+    set_status(m.status, s.field(1));
+    set_degrees(m.latitude, s.field(2), s.field(3));
+    set_degrees(m.longitude, s.field(4), s.field(5));
+    set_number(m.speed, s.field(6));
+    set_number(m.track_angle, s.field(7));
+    std::string_view d = s.field(8);
+    nmea::date date;
+    if(d.size()==6 && to_number(d.substr(0, 2), date.day) && to_number(d.substr(2, 2), date.month) && to_number(d.substr(4, 2), date.year))
+        m.date.set(date);
+    float variation;
+    if(to_number(s.field(9), variation))
+        m.magnetic_variation.set((!s.field(10).empty() && s.field(10)[0]=='W') ? -variation : variation);
+    set_mode(m.mode, s.field(11));
+    return true;
+}
+
+bool decode(const sentence_view& s, vtg& m)
+{
+    if(type_key(s.type)!=type_key("VTG"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_number(m.track_angle_true, s.field(0));
+    set_number(m.track_angle_magnetic, s.field(2));
+    set_number(m.speed_knots, s.field(4));
+    set_number(m.speed_kph, s.field(6));
+    set_mode(m.mode, s.field(8));
+    return true;
+}
+
+bool decode(const sentence_view& s, gsa& m)
+{
+    if(type_key(s.type)!=type_key("GSA"))
+        return false;
+    m.talker = to_talker(s.talker);
+    if(!s.field(0).empty())
+        m.mode.set(s.field(0)[0]);
+    set_number(m.fix, s.field(1));
+    m.n_satellites = 0;
+    for(std::size_t i=2;i<14;i++)
+    {
+        uint8_t id;
+        if(to_number(s.field(i), id))
+            m.satellites[m.n_satellites++] = id;
+    }
+    set_number(m.pdop, s.field(14));
+    set_number(m.hdop, s.field(15));
+    set_number(m.vdop, s.field(16));
+    set_number(m.system, s.field(17));
+    return true;
+}
+
+bool decode(const sentence_view& s, gsv& m)
+{
+    if(type_key(s.type)!=type_key("GSV"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_number(m.message_count, s.field(0));
+    set_number(m.message_number, s.field(1));
+    set_number(m.satellite_count, s.field(2));
+
+    // 4 fields per satellite, an optional signal id remains at the end
+    m.n_satellites = 0;
+    std::size_t i = 3;
+    for(;i+4<=s.n_fields && m.n_satellites<m.satellites.size();i+=4)
+    {
+        gsv::satellite& sat = m.satellites[m.n_satellites++];
+        set_number(sat.prn, s.field(i));
+        set_number(sat.elevation, s.field(i+1));
+        set_number(sat.azimuth, s.field(i+2));
+        set_number(sat.snr, s.field(i+3));
+    }
+    if(i<s.n_fields)
+        set_number(m.signal_id, s.field(i));
+    return true;
+}
+
+bool decode(const sentence_view& s, gll& m)
+{
+    if(type_key(s.type)!=type_key("GLL"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_degrees(m.latitude, s.field(0), s.field(1));
+    set_degrees(m.longitude, s.field(2), s.field(3));
+    set_utc(m.utc, s.field(4));
+    set_status(m.status, s.field(5));
+    set_mode(m.mode, s.field(6));
+    return true;
+}
+
+bool decode(const sentence_view& s, zda& m)
+{
+    if(type_key(s.type)!=type_key("ZDA"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_utc(m.utc, s.field(0));
+    set_number(m.day, s.field(1));
+    set_number(m.month, s.field(2));
+    set_number(m.year, s.field(3));
+    set_number(m.gmt_offset_hours, s.field(4));
+    set_number(m.gmt_offset_minutes, s.field(5));
+    return true;
+}
+
+bool decode(const sentence_view& s, hdt& m)
+{
+    if(type_key(s.type)!=type_key("HDT"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_number(m.heading, s.field(0));
+    return true;
+}
+
+bool decode(const sentence_view& s, ths& m)
+{
+    if(type_key(s.type)!=type_key("THS"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_number(m.heading, s.field(0));
+    set_mode(m.mode, s.field(1));
+    return true;
+}
+
+bool decode(const sentence_view& s, pashr& m)
+{
+    if(s.talker!="P" || type_key(s.type)!=type_key("ASHR"))
+        return false;
+    m.talker = to_talker(s.talker);
+    set_utc(m.utc, s.field(0));
+    set_number(m.heading, s.field(1));
+    set_number(m.roll, s.field(3));
+    set_number(m.pitch, s.field(4));
+    set_number(m.heave, s.field(5));
+    set_number(m.roll_accuracy, s.field(6));
+    set_number(m.pitch_accuracy, s.field(7));
+    set_number(m.heading_accuracy, s.field(8));
+    set_number(m.gps_quality, s.field(9));
+    set_number(m.ins_status, s.field(10));
+    return true;
+}
+
+bool decode(const sentence_view& s, ksxt& m)
+{
+    if(type_key(s.type)!=type_key("KSXT"))
+        return false;
+    m.talker = to_talker(s.talker);
+
+    // yyyymmddhhmmss.ss
+    std::string_view t = s.field(0);
+    nmea::date date;
+    uint16_t year;
+    if(t.size()>=14 && to_number(t.substr(0, 4), year) && to_number(t.substr(4, 2), date.month) && to_number(t.substr(6, 2), date.day))
+    {
+        date.year = (uint8_t)(year%100);
+        m.date.set(date);
+        set_utc(m.utc, t.substr(8));
+    }
+    set_number(m.longitude, s.field(1));
+    set_number(m.latitude, s.field(2));
+    set_number(m.height, s.field(3));
+    set_number(m.heading, s.field(4));
+    set_number(m.pitch, s.field(5));
+    set_number(m.track_angle, s.field(6));
+    set_number(m.speed_kph, s.field(7));
+    set_number(m.roll, s.field(8));
+    set_number(m.position_quality, s.field(9));
+    set_number(m.heading_quality, s.field(10));
+    set_number(m.heading_satellites, s.field(11));
+    set_number(m.position_satellites, s.field(12));
+    return true;
+}
+
+}
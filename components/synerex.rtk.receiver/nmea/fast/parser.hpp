@@ -0,0 +1,145 @@
+/// \file nmea/fast/parser.hpp
+/// \brief Defines the zero-allocation NMEA sentence parser (in place string_view slicing).
+#ifndef NMEA___FAST_PARSER_H
+#define NMEA___FAST_PARSER_H
+
+#include <string_view>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <type_traits>
+
+/// \brief Contains the zero-allocation NMEA parser.
+namespace nmea::fast {
+
+/// \brief Maximum number of data fields kept per sentence (the rest are ignored).
+constexpr std::size_t max_fields = 64;
+
+/// \brief An NMEA 0183 sentence sliced in place (views into the received line).
+/// \note The views are valid as long as the line buffer is not released.
+struct sentence_view
+{
+    /// \brief The talker ("GP", "GN", ...), "P" for proprietary sentences, empty if the address has no talker (e.g. KSXT).
+    std::string_view talker;
+    /// \brief The sentence type ("GGA", "ASHR", "KSXT", ...).
+    std::string_view type;
+    /// \brief The data fields (without the address field).
+    std::array<std::string_view, max_fields> fields;
+    /// \brief The number of data fields.
+    std::size_t n_fields {0};
+
+    /// \brief Gets a data field, or an empty view if the field does not exist.
+    std::string_view field(std::size_t index) const { return index<n_fields ? fields[index] : std::string_view(); }
+};
+
+/// \brief Parse result.
+enum class parse_result
+{
+    OK = 0,             ///< Valid sentence.
+    FRAMING,            ///< Not starting with '$'/'!' or checksum delimiter missing.
+    CHECKSUM            ///< Checksum mismatch.
+};
+
+/// \brief Calculates the XOR checksum of the bytes between '$' and '*' (vectorised).
+uint8_t checksum(std::string_view body);
+
+/// \brief Validates and slices an NMEA line (without CR/LF) in place.
+/// \param line The received line, e.g. "$GNGGA,...*hh".
+/// \param sentence The sliced sentence.
+/// \param require_checksum Rejects sentences without checksum if TRUE.
+parse_result parse(std::string_view line, sentence_view& sentence, bool require_checksum = true);
+
+/// \brief Packs a sentence type (up to 4 characters) into an integer for compile-time dispatch.
+/// \note Longer types share the key of their first 4 characters.
+constexpr uint32_t type_key(std::string_view type)
+{
+    uint32_t key = 0;
+    for(std::size_t i=0;i<type.size() && i<4;i++)
+        key = (key << 8) | (uint8_t)type[i];
+    return key;
+}
+
+// FIELD CONVERSION
+/// \brief Converts a plain decimal field ([+-]digits[.digits], at most 15 significant digits) exactly.
+/// \details The digits are accumulated as an integer and divided once by a power of ten, so the result is correctly rounded.
+/// \returns FALSE if the field does not have the plain form (the caller falls back to std::from_chars).
+inline bool to_decimal(std::string_view field, double& value)
+{
+    constexpr double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    std::size_t i = 0;
+    bool negative = false;
+    if(i<field.size() && (field[i]=='-' || field[i]=='+'))
+        negative = (field[i++]=='-');
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction = -1;
+    for(;i<field.size();i++)
+    {
+        char c = field[i];
+        if(c>='0' && c<='9')
+        {
+            mantissa = mantissa*10 + (uint64_t)(c-'0');
+            digits++;
+            if(fraction>=0)
+                fraction++;
+        }
+        else if(c=='.' && fraction<0)
+            fraction = 0;
+        else
+            return false;
+    }
+    if(digits==0 || digits>15)
+        return false;
+
+    value = (double)mantissa;
+    if(fraction>0)
+        value /= pow10[fraction];
+    if(negative)
+        value = -value;
+    return true;
+}
+
+/// \brief Converts a numeric field, returns FALSE if empty or invalid.
+template <class T>
+inline bool to_number(std::string_view field, T& value)
+{
+    if(field.empty())
+        return false;
+    if constexpr (std::is_integral_v<T>)
+    {
+        const char* first = field.data();
+        if(*first=='+')
+            first++;
+        // fractional part of integer fields (e.g. "05.0") is ignored
+        auto [ptr, ec] = std::from_chars(first, field.data()+field.size(), value);
+        return ec==std::errc() && ptr!=first;
+    }
+    else
+    {
+        double v = 0.0;
+        if(to_decimal(field, v))
+        {
+            value = static_cast<T>(v);
+            return true;
+        }
+        const char* first = field.data();
+        if(*first=='+')
+            first++;
+        auto [ptr, ec] = std::from_chars(first, field.data()+field.size(), v, std::chars_format::fixed);
+        if(ec!=std::errc() || ptr==first)
+            return false;
+        value = static_cast<T>(v);
+        return true;
+    }
+}
+
+/// \brief Converts a (d)ddmm.mmmm field with hemisphere (N/S/E/W) into signed degrees.
+bool to_degrees(std::string_view field, std::string_view hemisphere, double& degrees);
+
+/// \brief Converts a hhmmss.ss field into seconds of day.
+bool to_utc(std::string_view field, double& seconds);
+
+}
+
+#endif
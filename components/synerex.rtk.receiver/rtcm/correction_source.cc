@@ -0,0 +1,361 @@
+
+#include "correction_source.hpp"
+#include "rtcm3.hpp"
+#include <flame/log.hpp>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+
+using namespace flame;
+
+static string _base64(string_view in){
+    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    uint32_t value = 0;
+    int bits = -6;
+    for(unsigned char c:in){
+        value = (value << 8) + c;
+        bits += 8;
+        while(bits>=0){
+            out.push_back(table[(value >> bits) & 0x3F]);
+            bits -= 6;
+        }
+    }
+    if(bits>-6)
+        out.push_back(table[((value << 8) >> (bits+8)) & 0x3F]);
+    while(out.size()%4)
+        out.push_back('=');
+    return out;
+}
+
+correction_source::correction_source(const config& conf, frame_handler handler)
+:_config(conf), _handler(std::move(handler)){
+    _buffer.resize(rtcm3::max_frame_size*2);
+}
+
+correction_source::~correction_source(){
+    stop();
+}
+
+void correction_source::start(){
+    if(_worker.joinable())
+        return;
+    _stop.store(false);
+    _worker = thread(&correction_source::_task, this);
+}
+
+void correction_source::stop(){
+    {
+        lock_guard<mutex> lock(_wait_mutex);
+        _stop.store(true);
+    }
+    _wait_cv.notify_all();
+    if(_worker.joinable())
+        _worker.join();
+}
+
+void correction_source::set_gga(string_view line){
+    lock_guard<mutex> lock(_gga_mutex);
+    _gga.assign(line.data(), line.size());
+}
+
+bool correction_source::_wait(double seconds){
+    unique_lock<mutex> lock(_wait_mutex);
+    return !_wait_cv.wait_for(lock, chrono::duration<double>(seconds), [this]{ return _stop.load(); });
+}
+
+void correction_source::_task(){
+    if(_config.source=="file")
+        _run_file();
+    else
+        _run_tcp();
+    _connected.store(false);
+}
+
+int correction_source::_poll(int fd, short events, double timeout_s){
+    /* in short slices, so stop() is never held by a silent peer */
+    const auto end = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeout_s));
+    while(!_stop.load()){
+        const double left_ms = chrono::duration<double, milli>(end-chrono::steady_clock::now()).count();
+        if(left_ms<=0.0)
+            return 0;
+        pollfd pfd {fd, events, 0};
+        int r = poll(&pfd, 1, (int)min(left_ms+1.0, 200.0));
+        if(r<0 && errno!=EINTR)
+            return -1;
+        if(r>0)
+            return r;
+    }
+    return 0;
+}
+
+int correction_source::_connect(){
+    /* name resolution (getaddrinfo_a), bounded by connect_timeout_s and stop().
+       a lookup that cannot be canceled is left to finish in the resolver thread (its request is not freed) */
+    struct lookup {
+        gaicb request {};
+        addrinfo hints {};
+        string host, service;
+    };
+    lookup* l = new lookup();
+    l->host = _config.host;
+    l->service = to_string(_config.port);
+    l->hints.ai_family = AF_UNSPEC;
+    l->hints.ai_socktype = SOCK_STREAM;
+    l->request.ar_name = l->host.c_str();
+    l->request.ar_service = l->service.c_str();
+    l->request.ar_request = &l->hints;
+    gaicb* list[1] = {&l->request};
+    if(getaddrinfo_a(GAI_NOWAIT, list, 1, nullptr)!=0){
+        delete l;
+        return -1;
+    }
+
+    const auto deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(_config.connect_timeout_s));
+    int status = gai_error(&l->request);
+    while(status==EAI_INPROGRESS && !_stop.load() && chrono::steady_clock::now()<deadline){
+        const timespec slice {0, 200000000};
+        gai_suspend(list, 1, &slice);
+        status = gai_error(&l->request);
+    }
+    if(status==EAI_INPROGRESS){
+        if(gai_cancel(&l->request)==EAI_NOTCANCELED)
+            return -1;  /* still owned by the resolver */
+        status = gai_error(&l->request);
+    }
+    addrinfo* result = (status==0) ? l->request.ar_result : nullptr;
+    if(status!=0 && l->request.ar_result)
+        freeaddrinfo(l->request.ar_result);
+    delete l;
+    if(!result)
+        return -1;
+
+    /* non-blocking connect, bounded the same way */
+    int fd = -1;
+    for(addrinfo* ai=result;ai && !_stop.load();ai=ai->ai_next){
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, ai->ai_protocol);
+        if(fd<0)
+            continue;
+        int error = 0;
+        if(::connect(fd, ai->ai_addr, ai->ai_addrlen)!=0){
+            error = errno;
+            if(error==EINPROGRESS && _poll(fd, POLLOUT, _config.connect_timeout_s)>0){
+                socklen_t length = sizeof(error);
+                if(getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length)!=0)
+                    error = errno;
+            }
+            else if(error==EINPROGRESS)
+                error = ETIMEDOUT;
+        }
+        if(error==0){
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if(fd>=0){
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    }
+    return fd;
+}
+
+bool correction_source::_request(int fd){
+    if(_config.mountpoint.empty())
+        return true; /* raw stream */
+
+    string request = "GET /" + _config.mountpoint + " HTTP/1.0\r\n"
+                     "User-Agent: NTRIP flame/1.0\r\n"
+                     "Accept: */*\r\n";
+    if(!_config.user.empty())
+        request += "Authorization: Basic " + _base64(_config.user + ":" + _config.password) + "\r\n";
+    request += "\r\n";
+    if(::send(fd, request.data(), request.size(), MSG_NOSIGNAL)!=(ssize_t)request.size())
+        return false;
+
+    /* "ICY 200 OK\r\n" (NTRIP v1) or an HTTP 200 response with headers, corrections may follow in the same read */
+    string response;
+    char buffer[512];
+    while(response.size()<4096){
+        if(_poll(fd, POLLIN, _config.connect_timeout_s)<=0)
+            return false;
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if(n<=0)
+            return false;
+        response.append(buffer, (size_t)n);
+
+        size_t end = string::npos;
+        if(response.compare(0, 3, "ICY")==0)
+            end = response.find("\r\n");
+        else
+            end = response.find("\r\n\r\n");
+        if(end==string::npos)
+            continue;
+
+        if(response.find(" 200 ")==string::npos || response.find(" 200 ")>end){
+            logger::error("[correction] Caster rejected the request : {}", response.substr(0, response.find("\r\n")));
+            return false;
+        }
+        end += (response.compare(0, 3, "ICY")==0) ? 2 : 4;
+        if(end<response.size())
+            _parse(reinterpret_cast<const uint8_t*>(response.data())+end, response.size()-end);
+        return true;
+    }
+    return false;
+}
+
+void correction_source::_run_tcp(){
+    vector<uint8_t> buffer(4096);
+    bool first = true;
+
+    while(!_stop.load()){
+        if(!first){
+            _n_reconnects.fetch_add(1);
+            if(!_wait(_config.reconnect_s))
+                break;
+        }
+        first = false;
+
+        int fd = _connect();
+        if(fd<0){
+            logger::warn("[correction] Cannot connect to {}:{}", _config.host, _config.port);
+            continue;
+        }
+        if(!_request(fd)){
+            ::close(fd);
+            continue;
+        }
+        logger::info("[correction] Connected to {}:{}/{}", _config.host, _config.port, _config.mountpoint);
+        _connected.store(true);
+        _buffered = 0;
+
+        auto last_gga = chrono::steady_clock::now() - chrono::hours(1);
+        auto last_data = chrono::steady_clock::now();
+        while(!_stop.load()){
+            /* a caster which stops sending without closing the connection (keepalive takes hours) */
+            if(_config.data_timeout_s>0.0 &&
+               chrono::duration<double>(chrono::steady_clock::now()-last_data).count()>=_config.data_timeout_s){
+                logger::warn("[correction] No data from {}:{} for {:.0f} s, reconnecting", _config.host, _config.port, _config.data_timeout_s);
+                break;
+            }
+
+            /* GGA upload (VRS) */
+            if(_config.gga_interval_s>0.0 && !_config.mountpoint.empty() &&
+               chrono::duration<double>(chrono::steady_clock::now()-last_gga).count()>=_config.gga_interval_s){
+                string gga;
+                {
+                    lock_guard<mutex> lock(_gga_mutex);
+                    gga = _gga;
+                }
+                if(!gga.empty()){
+                    gga += "\r\n";
+                    if(::send(fd, gga.data(), gga.size(), MSG_NOSIGNAL)<0)
+                        break;
+                    last_gga = chrono::steady_clock::now();
+                }
+            }
+
+            pollfd pfd {fd, POLLIN, 0};
+            int r = poll(&pfd, 1, 200);
+            if(r<0 && errno!=EINTR)
+                break;
+            if(r<=0)
+                continue;
+            ssize_t n = ::recv(fd, buffer.data(), buffer.size(), 0);
+            if(n<=0){
+                if(n<0 && errno==EINTR)
+                    continue;
+                logger::warn("[correction] Disconnected from {}:{}", _config.host, _config.port);
+                break;
+            }
+            last_data = chrono::steady_clock::now();
+            _parse(buffer.data(), (size_t)n);
+        }
+        _connected.store(false);
+        ::close(fd);
+    }
+}
+
+void correction_source::_run_file(){
+    /* replay in small chunks at the configured byte rate */
+    const size_t chunk = 256;
+    const double period = (_config.rate_bytes_per_s>0.0) ? (double)chunk/_config.rate_bytes_per_s : 0.0;
+    vector<char> buffer(chunk);
+
+    while(!_stop.load()){
+        ifstream file(_config.path, ios::binary);
+        if(!file.is_open()){
+            logger::error("[correction] Cannot open {}", _config.path);
+            return;
+        }
+        _connected.store(true);
+        _buffered = 0;
+
+        auto next = chrono::steady_clock::now();
+        while(!_stop.load() && file){
+            file.read(buffer.data(), (streamsize)buffer.size());
+            size_t n = (size_t)file.gcount();
+            if(n==0)
+                break;
+            _parse(reinterpret_cast<const uint8_t*>(buffer.data()), n);
+
+            next += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(period));
+            double wait = chrono::duration<double>(next-chrono::steady_clock::now()).count();
+            if(wait>0.0 && !_wait(wait))
+                return;
+        }
+        _connected.store(false);
+        if(!_config.loop)
+            break;
+    }
+}
+
+void correction_source::_parse(const uint8_t* data, size_t size){
+    _n_bytes.fetch_add(size, memory_order_relaxed);
+
+    while(size>0){
+        size_t n = min(size, _buffer.size()-_buffered);
+        memcpy(_buffer.data()+_buffered, data, n);
+        _buffered += n;
+        data += n;
+        size -= n;
+
+        size_t offset = 0;
+        while(offset<_buffered){
+            string_view view(reinterpret_cast<const char*>(_buffer.data()+offset), _buffered-offset);
+            long r = rtcm3::extract(view);
+            if(r==0)
+                break;
+            if(r<0){
+                offset += (size_t)(-r);
+                continue;
+            }
+            string_view frame = view.substr(0, (size_t)r);
+            if(!rtcm3::valid(frame)){
+                _n_crc_errors.fetch_add(1, memory_order_relaxed);
+                offset += 1; /* false preamble or corrupted frame : resync */
+                continue;
+            }
+            _n_frames.fetch_add(1, memory_order_relaxed);
+            if(_handler)
+                _handler(frame);
+            offset += (size_t)r;
+        }
+
+        if(offset>0){
+            memmove(_buffer.data(), _buffer.data()+offset, _buffered-offset);
+            _buffered -= offset;
+        }
+    }
+}
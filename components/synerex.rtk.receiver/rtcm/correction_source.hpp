@@ -0,0 +1,101 @@
+/**
+ * @file correction_source.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief RTCM 3 correction input from a TCP (NTRIP v1 or raw) stream or a file
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_SYNEREX_RTK_RECEIVER_CORRECTION_SOURCE_HPP_INCLUDED
+#define FLAME_SYNEREX_RTK_RECEIVER_CORRECTION_SOURCE_HPP_INCLUDED
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief RTCM 3 correction source.
+ * a worker thread reads the stream (reconnecting on failure) or replays a file at a fixed byte rate,
+ * extracts the frames, checks their CRC and passes every valid frame to the handler (called from the worker thread).
+ */
+class correction_source {
+    public:
+        struct config {
+            string source {"tcp"};              /* "tcp" or "file" */
+            /* tcp : NTRIP v1 request if a mountpoint is given, raw RTCM stream otherwise */
+            string host {"127.0.0.1"};
+            int port {2101};
+            string mountpoint;
+            string user;
+            string password;
+            double gga_interval_s {10.0};       /* GGA upload period to the caster (0 : never, VRS mountpoints need it) */
+            double reconnect_s {3.0};
+            double connect_timeout_s {5.0};     /* name resolution, connection and caster response */
+            double data_timeout_s {30.0};       /* no data for this long : reconnect (0 : never, a few GGA periods for VRS) */
+            /* file : raw RTCM file */
+            string path;
+            double rate_bytes_per_s {2000.0};   /* replay rate */
+            bool loop {true};
+        };
+
+        using frame_handler = function<void(string_view frame)>;
+
+        correction_source(const config& conf, frame_handler handler);
+        ~correction_source();
+
+        void start();
+        void stop();
+
+        /* latest GGA sentence (sent to the caster every gga_interval_s) */
+        void set_gga(string_view line);
+
+        bool is_connected() const { return _connected.load(); }
+        uint64_t get_frame_count() const { return _n_frames.load(); }
+        uint64_t get_crc_error_count() const { return _n_crc_errors.load(); }
+        uint64_t get_byte_count() const { return _n_bytes.load(); }
+        uint64_t get_reconnect_count() const { return _n_reconnects.load(); }
+
+    private:
+        void _task();
+        void _run_tcp();
+        void _run_file();
+        int _connect();
+        int _poll(int fd, short events, double timeout_s); /* >0 ready, 0 timeout or stopped, <0 error */
+        bool _request(int fd);
+        void _parse(const uint8_t* data, size_t size);
+        bool _wait(double seconds); /* sleep unless stopped, return false if stopped */
+
+    private:
+        config _config;
+        frame_handler _handler;
+        thread _worker;
+        atomic<bool> _stop {false};
+        mutex _wait_mutex;
+        condition_variable _wait_cv;
+
+        vector<uint8_t> _buffer; /* unframed bytes (max frame size x 2) */
+        size_t _buffered {0};
+
+        mutex _gga_mutex;
+        string _gga;
+
+        atomic<bool> _connected {false};
+        atomic<uint64_t> _n_frames {0};
+        atomic<uint64_t> _n_crc_errors {0};
+        atomic<uint64_t> _n_bytes {0};
+        atomic<uint64_t> _n_reconnects {0};
+
+}; /* class */
+
+#endif
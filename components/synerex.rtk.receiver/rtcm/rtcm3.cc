@@ -0,0 +1,68 @@
+
+#include "rtcm3.hpp"
+#include <array>
+#include <cstring>
+
+namespace rtcm3 {
+
+    static constexpr std::array<uint32_t, 256> _crc_table = [](){
+        std::array<uint32_t, 256> table {};
+        for(uint32_t i=0;i<256;i++){
+            uint32_t crc = i << 16;
+            for(int k=0;k<8;k++){
+                crc <<= 1;
+                if(crc & 0x1000000)
+                    crc ^= 0x1864CFB;
+            }
+            table[i] = crc & 0xFFFFFF;
+        }
+        return table;
+    }();
+
+    uint32_t crc24q(const uint8_t* data, size_t size){
+        uint32_t crc = 0;
+        for(size_t i=0;i<size;i++)
+            crc = ((crc << 8) & 0xFFFFFF) ^ _crc_table[(crc >> 16) ^ data[i]];
+        return crc;
+    }
+
+    long extract(std::string_view data){
+        if(data.empty())
+            return 0;
+
+        /* resync to the next preamble */
+        if((uint8_t)data[0]!=preamble){
+            const void* p = memchr(data.data(), (char)preamble, data.size());
+            return -(long)(p ? static_cast<const char*>(p)-data.data() : data.size());
+        }
+        if(data.size()<header_size)
+            return 0;
+
+        /* reserved bits must be zero, otherwise this is not a frame start */
+        if(((uint8_t)data[1] & 0xFC)!=0)
+            return -1;
+
+        size_t length = (((size_t)(uint8_t)data[1] & 0x03) << 8) | (uint8_t)data[2];
+        size_t frame_size = header_size + length + crc_size;
+        if(data.size()<frame_size)
+            return 0;
+        return (long)frame_size;
+    }
+
+    bool valid(std::string_view frame){
+        if(frame.size()<header_size+crc_size)
+            return false;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(frame.data());
+        size_t n = frame.size()-crc_size;
+        uint32_t crc = ((uint32_t)p[n] << 16) | ((uint32_t)p[n+1] << 8) | p[n+2];
+        return crc24q(p, n)==crc;
+    }
+
+    uint16_t message_type(std::string_view frame){
+        if(frame.size()<header_size+2+crc_size)
+            return 0;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(frame.data()) + header_size;
+        return (uint16_t)(((uint16_t)p[0] << 4) | (p[1] >> 4));
+    }
+
+} // namespace
@@ -0,0 +1,45 @@
+/**
+ * @file rtcm3.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief RTCM 3 frame extraction and CRC-24Q validation
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_SYNEREX_RTK_RECEIVER_RTCM3_HPP_INCLUDED
+#define FLAME_SYNEREX_RTK_RECEIVER_RTCM3_HPP_INCLUDED
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace rtcm3 {
+
+    /* frame : preamble(0xD3), 6 reserved bits + 10 bits payload length, payload, CRC-24Q (3 bytes) */
+    constexpr uint8_t preamble = 0xD3;
+    constexpr size_t header_size = 3;
+    constexpr size_t crc_size = 3;
+    constexpr size_t max_payload = 1023;
+    constexpr size_t max_frame_size = header_size + max_payload + crc_size;
+
+    /* CRC-24Q (Qualcomm) */
+    uint32_t crc24q(const uint8_t* data, size_t size);
+
+    /**
+     * @brief frame extractor for serial::next_frame style parsing.
+     * @return frame length at the head of data (>0, header only checked), 0 if incomplete, -n to skip n bytes up to the next preamble
+     */
+    long extract(std::string_view data);
+
+    /* check the CRC of a whole frame */
+    bool valid(std::string_view frame);
+
+    /* message number (first 12 bits of the payload), 0 if the payload is empty */
+    uint16_t message_type(std::string_view frame);
+
+} // namespace
+
+#endif
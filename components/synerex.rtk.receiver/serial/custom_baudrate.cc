@@ -0,0 +1,22 @@
+
+/* termios2 and termios.h cannot be included together */
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+namespace flame::device::bus{
+
+    bool set_custom_baudrate(int fd, unsigned int baudrate){
+        struct termios2 options;
+        if(ioctl(fd, TCGETS2, &options)!=0)
+            return false;
+
+        options.c_cflag &= ~CBAUD;
+        options.c_cflag |= BOTHER;
+        options.c_ispeed = baudrate;
+        options.c_ospeed = baudrate;
+        options.c_cflag &= ~(CBAUD << IBSHIFT);
+        options.c_cflag |= (BOTHER << IBSHIFT);
+        return ioctl(fd, TCSETS2, &options)==0;
+    }
+
+} // namespace
@@ -0,0 +1,106 @@
+/**
+ * @file ring_buffer.hpp
+ * @author Byunghun Hwang <bh.hwang@iae.re.kr>
+ * @brief Lock-free single producer/single consumer byte ring buffer (mirrored mapping, contiguous views across wrap)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef FLAME_DEVICE_COMMON_RING_BUFFER_HPP_INCLUDED
+#define FLAME_DEVICE_COMMON_RING_BUFFER_HPP_INCLUDED
+
+#include <atomic>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace flame::device::bus {
+
+    /**
+     * @brief byte ring buffer whose storage is mapped twice back to back,
+     * so readable and writable regions are always contiguous (a line wrapping the end can be viewed in place).
+     * one producer thread (write_ptr/commit) and one consumer thread (peek/consume) without locks.
+     */
+    class ring_buffer {
+        public:
+            ring_buffer(size_t capacity = 64*1024){
+                size_t page = (size_t)sysconf(_SC_PAGESIZE);
+                _capacity = page;
+                while(_capacity<capacity)
+                    _capacity <<= 1;
+
+                int fd = memfd_create("flame_ring_buffer", MFD_CLOEXEC);
+                if(fd<0)
+                    return;
+                if(ftruncate(fd, (off_t)_capacity)==0){
+                    void* base = mmap(nullptr, 2*_capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                    if(base!=MAP_FAILED){
+                        uint8_t* p = static_cast<uint8_t*>(base);
+                        if(mmap(p, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)!=MAP_FAILED &&
+                           mmap(p+_capacity, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)!=MAP_FAILED)
+                            _buffer = p;
+                        else
+                            munmap(base, 2*_capacity);
+                    }
+                }
+                ::close(fd);
+            }
+
+            ~ring_buffer(){
+                if(_buffer)
+                    munmap(_buffer, 2*_capacity);
+            }
+
+            ring_buffer(const ring_buffer&) = delete;
+            ring_buffer& operator=(const ring_buffer&) = delete;
+
+            bool valid() const { return _buffer!=nullptr; }
+            size_t capacity() const { return _capacity; }
+            size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+            bool empty() const { return size()==0; }
+
+            /* producer : contiguous free region */
+            uint8_t* write_ptr(size_t& free_bytes){
+                size_t head = _head.load(std::memory_order_relaxed);
+                free_bytes = _capacity - (head - _tail.load(std::memory_order_acquire));
+                return _buffer + (head & (_capacity-1));
+            }
+
+            /* producer : publish n bytes written at write_ptr() */
+            void commit(size_t n){
+                _head.store(_head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+            }
+
+            /* consumer : all readable bytes as one view (valid until consume) */
+            std::string_view peek() const {
+                size_t tail = _tail.load(std::memory_order_relaxed);
+                size_t n = _head.load(std::memory_order_acquire) - tail;
+                return std::string_view(reinterpret_cast<const char*>(_buffer + (tail & (_capacity-1))), n);
+            }
+
+            /* consumer : release n bytes */
+            void consume(size_t n){
+                _tail.store(_tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+            }
+
+            /* consumer : drop everything readable */
+            void clear(){
+                _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+            }
+
+        private:
+            uint8_t* _buffer {nullptr};
+            size_t _capacity {0};
+            alignas(64) std::atomic<size_t> _head {0}; /* total bytes written */
+            alignas(64) std::atomic<size_t> _tail {0}; /* total bytes consumed */
+
+    }; /* class */
+
+} // namespace
+
+#endif
@@ -1,154 +1,352 @@
-#include "serial.hpp"
-#include <flame/log.hpp>
-
-namespace flame::device::bus{
-
-    serial::serial(){
-        _fd = -1;
-    }
-
-    serial::~serial(){
-        close();
-    }
-
-    bool serial::open(const char* device, const unsigned int baudrate, DataBits databits, ParityBits paritybits, StopBits stopbits) {
-
-        _fd = ::open(device, O_RDWR | O_NOCTTY | O_NDELAY);
-        if(_fd==-1){ // if the device is not open, return -1
-            return false;
-        }
-
-        fcntl(_fd, F_SETFL, FNDELAY); // device open in nonblocking mode
-
-        struct termios options;
-        tcgetattr(_fd, &options); //get current options
-        bzero(&options, sizeof(options)); //clear options
-
-        // baudrate
-        speed_t br;
-        switch(baudrate){
-            case 110 : { br=B110; } break;
-            case 300 : { br=B300; } break;
-            case 600 : { br=B600; } break;
-            case 1200 : { br=B1200; } break;
-            case 2400 : { br=B2400; } break;
-            case 4800 : { br=B4800; } break;
-            case 9600 : { br=B9600; } break;
-            case 19200 : { br=B19200; } break;
-            case 38400 : { br=B38400; } break;
-            case 57600 : { br=B57600; } break;
-            case 115200 : { br=B115200; } break;
-            default:
-                return false;
-        }
-
-        // databits
-        int databits_flag = 0;
-        switch(databits) {
-            case DataBits::DATABITS_5: databits_flag = CS5; break;
-            case DataBits::DATABITS_6: databits_flag = CS6; break;
-            case DataBits::DATABITS_7: databits_flag = CS7; break;
-            case DataBits::DATABITS_8: databits_flag = CS8; break;
-            default:
-                return false;
-        }
-
-        // stopbits
-        int stopbits_flag = 0;
-        switch(stopbits) {
-            case StopBits::STOPBITS_1: stopbits_flag = 0; break;
-            case StopBits::STOPBITS_2: stopbits_flag = CSTOPB; break;
-            default:
-                return false;
-        }
-
-        // paritybits
-        int parity_flag = 0;
-        switch(paritybits) {
-            case ParityBits::NONE: parity_flag = 0; break;
-            case ParityBits::EVEN: parity_flag = PARENB; break;
-            case ParityBits::ODD: parity_flag = (PARENB | PARODD); break;
-            default:
-                return false;
-        }
-
-        // set baudreate
-        cfsetispeed(&options, br);
-        cfsetospeed(&options, br);
-
-        // set options
-        options.c_cflag |= ( CLOCAL | CREAD | databits_flag | parity_flag | stopbits_flag);
-        options.c_iflag |= ( IGNPAR | IGNBRK );
-        options.c_cc[VTIME]=0; //timer unused
-        options.c_cc[VMIN]=0; //at least on character before satisfy reading
-        tcsetattr(_fd, TCSANOW, &options); //activate settings
-        
-        return true;
-    }
-
-    bool serial::is_opened()
-    {
-        return _fd>=0;
-    }
-
-    void serial::close(){
-        ::close(_fd);
-        _fd = -1;
-    }
-
-    int serial::read(char* buffer, unsigned int max_size, const unsigned int timeout_ms=0, unsigned int duration_us=100){
-
-        timer _time;
-        _time.init();
-
-        unsigned int n_read = 0;
-        
-        while(_time.elapsed()<timeout_ms || timeout_ms==0){
-            unsigned char* ptr = (unsigned char*)buffer+n_read;
-            int 
-        }
-
-    // Timer used for timeout
-    timeOut          timer;
-    // Initialise the timer
-    timer.initTimer();
-    unsigned int     NbByteRead=0;
-    // While Timeout is not reached
-    while (timer.elapsedTime_ms()<timeOut_ms || timeOut_ms==0)
-    {
-        // Compute the position of the current byte
-        unsigned char* Ptr=(unsigned char*)buffer+NbByteRead;
-        // Try to read a byte on the device
-        int Ret=read(fd,(void*)Ptr,maxNbBytes-NbByteRead);
-        // Error while reading
-        if (Ret==-1) return -2;
-
-        // One or several byte(s) has been read on the device
-        if (Ret>0)
-        {
-            // Increase the number of read bytes
-            NbByteRead+=Ret;
-            // Success : bytes has been read
-            if (NbByteRead>=maxNbBytes)
-                return NbByteRead;
-        }
-        // Suspend the loop to avoid charging the CPU
-        usleep (sleepDuration_us);
-    }
-    // Timeout reached, return the number of bytes read
-    return NbByteRead;
-    }
-
-    int serial::write(const char* data, const unsigned int len){
-
-    }
-
-    void serial::flush(){
-
-    }
-
-    int serial::available(){
-
-    }
-
-} // namespace 
+#include "serial.hpp"
+#include <flame/log.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <fstream>
+#include <linux/serial.h>
+
+namespace flame::device::bus{
+
+    serial::serial(size_t buffer_size, size_t tx_buffer_size)
+    :_rx(buffer_size), _tx(tx_buffer_size){
+        _fd = -1;
+    }
+
+    serial::~serial(){
+        close();
+    }
+
+    bool serial::open(const char* device, const unsigned int baudrate, DataBits databits, ParityBits paritybits, StopBits stopbits, const SerialOptions& serial_options) {
+
+        if(!_rx.valid() || !_tx.valid())
+            return false;
+
+        /* re-open : release the previous device and its epoll/event descriptors first */
+        close();
+
+        _fd = ::open(device, O_RDWR | O_NOCTTY | O_NDELAY | O_CLOEXEC);
+        if(_fd==-1){ // if the device is not open, return -1
+            return false;
+        }
+
+        fcntl(_fd, F_SETFL, FNDELAY); // device open in nonblocking mode
+
+        struct termios options;
+        tcgetattr(_fd, &options); //get current options
+        bzero(&options, sizeof(options)); //clear options
+
+        // baudrate (not listed rates are set with termios2 after the other options)
+        speed_t br = B38400;
+        bool custom_baudrate = false;
+        switch(baudrate){
+            case 110 : { br=B110; } break;
+            case 300 : { br=B300; } break;
+            case 600 : { br=B600; } break;
+            case 1200 : { br=B1200; } break;
+            case 2400 : { br=B2400; } break;
+            case 4800 : { br=B4800; } break;
+            case 9600 : { br=B9600; } break;
+            case 19200 : { br=B19200; } break;
+            case 38400 : { br=B38400; } break;
+            case 57600 : { br=B57600; } break;
+            case 115200 : { br=B115200; } break;
+            case 230400 : { br=B230400; } break;
+            case 460800 : { br=B460800; } break;
+            case 500000 : { br=B500000; } break;
+            case 576000 : { br=B576000; } break;
+            case 921600 : { br=B921600; } break;
+            case 1000000 : { br=B1000000; } break;
+            case 1152000 : { br=B1152000; } break;
+            case 1500000 : { br=B1500000; } break;
+            case 2000000 : { br=B2000000; } break;
+            case 3000000 : { br=B3000000; } break;
+            case 4000000 : { br=B4000000; } break;
+            default:
+                if(baudrate==0){
+                    close();
+                    return false;
+                }
+                custom_baudrate = true;
+        }
+
+        // databits
+        int databits_flag = 0;
+        switch(databits) {
+            case DataBits::DATABITS_5: databits_flag = CS5; break;
+            case DataBits::DATABITS_6: databits_flag = CS6; break;
+            case DataBits::DATABITS_7: databits_flag = CS7; break;
+            case DataBits::DATABITS_8: databits_flag = CS8; break;
+            default:
+                close();
+                return false;
+        }
+
+        // stopbits
+        int stopbits_flag = 0;
+        switch(stopbits) {
+            case StopBits::STOPBITS_1: stopbits_flag = 0; break;
+            case StopBits::STOPBITS_2: stopbits_flag = CSTOPB; break;
+            default:
+                close();
+                return false;
+        }
+
+        // paritybits
+        int parity_flag = 0;
+        switch(paritybits) {
+            case ParityBits::NONE: parity_flag = 0; break;
+            case ParityBits::EVEN: parity_flag = PARENB; break;
+            case ParityBits::ODD: parity_flag = (PARENB | PARODD); break;
+            default:
+                close();
+                return false;
+        }
+
+        // set baudreate
+        cfsetispeed(&options, br);
+        cfsetospeed(&options, br);
+
+        // set options
+        options.c_cflag |= ( CLOCAL | CREAD | databits_flag | parity_flag | stopbits_flag);
+        options.c_iflag |= ( IGNPAR | IGNBRK );
+        options.c_cc[VTIME]=(cc_t)std::clamp(serial_options.vtime, 0, 255); //inter-character timer (0.1s)
+        options.c_cc[VMIN]=(cc_t)std::clamp(serial_options.vmin, 0, 255); //minimum characters to satisfy reading
+        if(tcsetattr(_fd, TCSANOW, &options)!=0){ //activate settings
+            close();
+            return false;
+        }
+        if(custom_baudrate && !set_custom_baudrate(_fd, baudrate)){
+            close();
+            return false;
+        }
+
+        // low latency : no receive FIFO holdoff in the driver, 1 ms latency timer on usb-serial adapters (FTDI)
+        if(serial_options.low_latency){
+            struct serial_struct ss;
+            if(ioctl(_fd, TIOCGSERIAL, &ss)==0){
+                ss.flags |= ASYNC_LOW_LATENCY;
+                ioctl(_fd, TIOCSSERIAL, &ss);
+            }
+            std::string name(device);
+            name = name.substr(name.find_last_of('/')+1);
+            std::ofstream latency_timer("/sys/bus/usb-serial/devices/" + name + "/latency_timer");
+            if(latency_timer.is_open())
+                latency_timer << 1;
+        }
+        tcflush(_fd, TCIOFLUSH);
+
+        // readiness wait (device + wakeup event)
+        _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(_epoll_fd<0 || _event_fd<0){
+            close();
+            return false;
+        }
+        epoll_event ev {};
+        ev.events = EPOLLIN;
+        ev.data.fd = _fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _fd, &ev);
+        ev.data.fd = _event_fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &ev);
+
+        _rx.clear();
+        _tx.clear();
+        _pending_consume = 0;
+        _writable_watched = false;
+        return true;
+    }
+
+    bool serial::is_opened()
+    {
+        return _fd>=0;
+    }
+
+    void serial::close(){
+        if(_epoll_fd>=0)
+            ::close(_epoll_fd);
+        if(_event_fd>=0)
+            ::close(_event_fd);
+        if(_fd>=0)
+            ::close(_fd);
+        _fd = -1;
+        _epoll_fd = -1;
+        _event_fd = -1;
+    }
+
+    int serial::receive(int timeout_ms){
+        if(_fd<0)
+            return -1;
+
+        /* queued writes first (also wakes up on writability while the queue is not empty) */
+        if(!_tx.empty() && _write_queued()<0)
+            return -1;
+        _watch_writable(!_tx.empty());
+
+        epoll_event events[2];
+        int n = epoll_wait(_epoll_fd, events, 2, timeout_ms);
+        if(n<0)
+            return (errno==EINTR) ? 0 : -1;
+
+        int received = 0;
+        for(int i=0;i<n;i++){
+            if(events[i].data.fd==_event_fd){
+                uint64_t count;
+                if(::read(_event_fd, &count, sizeof(count))<0){} /* reset wakeup */
+                if(!_tx.empty() && _write_queued()<0)
+                    return -1;
+                continue;
+            }
+            if(events[i].events & (EPOLLERR | EPOLLHUP))
+                return -1;
+            if((events[i].events & EPOLLOUT) && _write_queued()<0)
+                return -1;
+            if(!(events[i].events & EPOLLIN))
+                continue;
+
+            /* drain the device into the ring buffer (contiguous free region, one read unless it is filled up) */
+            while(true){
+                size_t free_bytes = 0;
+                uint8_t* ptr = _rx.write_ptr(free_bytes);
+                if(free_bytes==0)
+                    break; /* consumer is behind, the rest stays in the device buffer */
+                ssize_t r = ::read(_fd, ptr, free_bytes);
+                if(r>0){
+                    _rx.commit((size_t)r);
+                    received += (int)r;
+                    if((size_t)r<free_bytes)
+                        break;
+                }
+                else if(r==0)
+                    return -1; /* disconnected */
+                else if(errno==EINTR)
+                    continue;
+                else if(errno==EAGAIN || errno==EWOULDBLOCK)
+                    break;
+                else
+                    return -1;
+            }
+        }
+        return received;
+    }
+
+    void serial::interrupt(){
+        if(_event_fd>=0){
+            uint64_t one = 1;
+            if(::write(_event_fd, &one, sizeof(one))<0){}
+        }
+    }
+
+    int serial::read(char* buffer, unsigned int max_size, const unsigned int timeout_ms){
+        _release();
+        if(_rx.empty() && timeout_ms>0){
+            if(receive((int)timeout_ms)<0)
+                return -2;
+        }
+
+        std::string_view data = _rx.peek();
+        size_t n = std::min((size_t)max_size, data.size());
+        memcpy(buffer, data.data(), n);
+        _rx.consume(n);
+        return (int)n;
+    }
+
+    int serial::write(const char* data, const unsigned int len){
+        if(_fd<0)
+            return -1;
+
+        while(true){
+            ssize_t n = ::write(_fd, data, len);
+            if(n>=0)
+                return (int)n;
+            if(errno==EINTR)
+                continue;
+            return (errno==EAGAIN || errno==EWOULDBLOCK) ? 0 : -1;
+        }
+    }
+
+    bool serial::enqueue(const char* data, const unsigned int len){
+        if(_fd<0)
+            return false;
+
+        size_t free_bytes = 0;
+        uint8_t* ptr = _tx.write_ptr(free_bytes);
+        if(free_bytes<len){
+            _n_tx_dropped.fetch_add(len, std::memory_order_relaxed);
+            return false;
+        }
+        memcpy(ptr, data, len);
+        _tx.commit(len);
+        interrupt(); /* let the receive thread write it */
+        return true;
+    }
+
+    int serial::_write_queued(){
+        std::string_view data = _tx.peek();
+        while(!data.empty()){
+            int n = write(data.data(), (unsigned int)data.size());
+            if(n<0)
+                return -1;
+            if(n==0)
+                break; /* device buffer full : wait for EPOLLOUT */
+            _tx.consume((size_t)n);
+            _n_tx_bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            data = _tx.peek();
+        }
+        return 0;
+    }
+
+    void serial::_watch_writable(bool enable){
+        if(enable==_writable_watched)
+            return;
+        epoll_event ev {};
+        ev.events = EPOLLIN | (enable ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = _fd;
+        epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, _fd, &ev);
+        _writable_watched = enable;
+    }
+
+    void serial::flush(){
+        if(_fd>=0)
+            tcflush(_fd, TCIOFLUSH);
+        _pending_consume = 0;
+        _rx.clear();
+    }
+
+    int serial::available(){
+        int pending = 0;
+        if(_fd>=0)
+            ioctl(_fd, FIONREAD, &pending);
+        return (int)(_rx.size()-_pending_consume) + pending;
+    }
+
+    bool serial::next_line(std::string_view& line){
+        _release();
+
+        std::string_view data = _rx.peek();
+        size_t pos = data.find('\n');
+        if(pos==std::string_view::npos){
+            if(data.size()==_rx.capacity()) /* no line delimiter in the whole buffer : drop */
+                _drop(data.size());
+            return false;
+        }
+
+        size_t len = (pos>0 && data[pos-1]=='\r') ? pos-1 : pos;
+        line = data.substr(0, len);
+        _pending_consume = pos+1;
+        return true;
+    }
+
+    void serial::_release(){
+        if(_pending_consume>0){
+            _rx.consume(_pending_consume);
+            _pending_consume = 0;
+        }
+    }
+
+    void serial::_drop(size_t n){
+        _rx.consume(n);
+        _n_dropped.fetch_add(n, std::memory_order_relaxed);
+    }
+
+} // namespace 
@@ -1,106 +1,194 @@
-/*!
-\file    serial.h
-\brief   Header file of the class serialib. This class is used for communication over a serial device.
-\author  Philippe Lucidarme (University of Angers)
-\version 2.0
-\date    december the 27th of 2019
-This Serial library is used to communicate through serial port.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
-INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
-PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE X CONSORTIUM BE LIABLE FOR ANY CLAIM,
-DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
-FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-
-This is a licence-free software, it can be used by anyone who try to build a better world.
-*/
-
-/**
- * @brief customized for linux use only and c++ with our code convention
- * 
- */
-
-#ifndef FLAME_DEVICE_COMMON_SERIALIB_HPP_INCLUDED
-#define FLAME_DEVICE_COMMON_SERIALIB_HPP_INCLUDED
-
-#if defined (__linux__) || defined(__APPLE__)
-    #include <stdlib.h>
-    #include <sys/types.h>
-    #include <sys/shm.h>
-    #include <termios.h>
-    #include <string.h>
-    #include <iostream>
-    #include <sys/time.h>
-    #include <fcntl.h>
-    #include <unistd.h>
-    #include <sys/ioctl.h>
-#endif
-
-namespace flame::device::bus {
-
-    /**
-     * number of serial data bits
-     */
-    enum class DataBits : int {
-        DATABITS_5, /**< 5 databits */
-        DATABITS_6, /**< 6 databits */
-        DATABITS_7, /**< 7 databits */
-        DATABITS_8,  /**< 8 databits */
-        DATABITS_16,  /**< 16 databits */
-    };
-
-    /**
-     * number of serial stop bits
-     */
-    enum class StopBits : int {
-        STOPBITS_1, /**< 1 stop bit */
-        STOPBITS_1_5, /**< 1.5 stop bits */
-        STOPBITS_2, /**< 2 stop bits */
-    };
-
-    /**
-     * type of serial parity bits
-     */
-    enum class ParityBits : int {
-        NONE, /**< no parity bit */
-        EVEN, /**< even parity bit */
-        ODD, /**< odd parity bit */
-        MARK, /**< mark parity */
-        SPACE /**< space bit */
-    };
-
-    // use only POSIX Time
-    class timer {
-        public:
-            timer();
-            void init();
-            unsigned long elapsed(); //unit : msec
-        private:
-            struct timeval _prev_time;
-    };
-
-    class serial
-    {
-    public:
-        serial();
-        virtual ~serial();
-
-        bool open(const char* device, const unsigned int baudrate, DataBits databits = DataBits::DATABITS_8, 
-                                                                    ParityBits paritybits = ParityBits::NONE, 
-                                                                    StopBits stopbits = StopBits::STOPBITS_1);
-
-        bool is_opened();
-        void close();
-        
-        int write(const char* data, const unsigned int len);
-        int read(char* buffer, unsigned int max_size, const unsigned int timeout_ms=0, unsigned int duration_us=100);
-        void flush();
-        int available();// Return the number of bytes in the received buffer
-
-    protected:
-        int _fd { -1 };
-    }; //class
-
-} // namespace 
-
-#endif // serial
+/*!
+\file    serial.h
+\brief   Header file of the class serialib. This class is used for communication over a serial device.
+\author  Philippe Lucidarme (University of Angers)
+\version 2.0
+\date    december the 27th of 2019
+This Serial library is used to communicate through serial port.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE X CONSORTIUM BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+This is a licence-free software, it can be used by anyone who try to build a better world.
+*/
+
+/**
+ * @brief customized for linux use only and c++ with our code convention
+ * 
+ */
+
+#ifndef FLAME_DEVICE_COMMON_SERIALIB_HPP_INCLUDED
+#define FLAME_DEVICE_COMMON_SERIALIB_HPP_INCLUDED
+
+#if defined (__linux__) || defined(__APPLE__)
+    #include <stdlib.h>
+    #include <sys/types.h>
+    #include <termios.h>
+    #include <string.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include "ring_buffer.hpp"
+
+namespace flame::device::bus {
+
+    /**
+     * number of serial data bits
+     */
+    enum class DataBits : int {
+        DATABITS_5, /**< 5 databits */
+        DATABITS_6, /**< 6 databits */
+        DATABITS_7, /**< 7 databits */
+        DATABITS_8,  /**< 8 databits */
+        DATABITS_16,  /**< 16 databits */
+    };
+
+    /**
+     * number of serial stop bits
+     */
+    enum class StopBits : int {
+        STOPBITS_1, /**< 1 stop bit */
+        STOPBITS_1_5, /**< 1.5 stop bits */
+        STOPBITS_2, /**< 2 stop bits */
+    };
+
+    /**
+     * type of serial parity bits
+     */
+    enum class ParityBits : int {
+        NONE, /**< no parity bit */
+        EVEN, /**< even parity bit */
+        ODD, /**< odd parity bit */
+        MARK, /**< mark parity */
+        SPACE /**< space bit */
+    };
+
+    /**
+     * additional line options
+     */
+    struct SerialOptions {
+        bool low_latency {false};   /**< ASYNC_LOW_LATENCY (and 1 ms latency timer for usb-serial adapters) */
+        int vmin {0};               /**< termios VMIN (effective for blocking reads only) */
+        int vtime {0};              /**< termios VTIME in 0.1 s (effective for blocking reads only) */
+    };
+
+    /**
+     * set an arbitrary baudrate with termios2 (BOTHER), defined apart from termios.h
+     */
+    bool set_custom_baudrate(int fd, unsigned int baudrate);
+
+    /**
+     * @brief non-blocking serial bus.
+     * receive() waits on the device with epoll and moves all pending bytes into a lock-free ring buffer with one read per wakeup,
+     * next_line()/next_frame() extract complete lines/frames in place (string_view into the ring buffer, no copy).
+     * receive() is called by one thread (producer) and the extraction functions by one thread (consumer), which may be the same.
+     */
+    class serial
+    {
+    public:
+        serial(size_t buffer_size = 64*1024, size_t tx_buffer_size = 16*1024);
+        virtual ~serial();
+
+        /* an already opened device is closed first (not while another thread waits in receive()) */
+        bool open(const char* device, const unsigned int baudrate, DataBits databits = DataBits::DATABITS_8, 
+                                                                    ParityBits paritybits = ParityBits::NONE, 
+                                                                    StopBits stopbits = StopBits::STOPBITS_1,
+                                                                    const SerialOptions& serial_options = SerialOptions());
+
+        bool is_opened();
+        void close();
+        
+        int write(const char* data, const unsigned int len); /* non-blocking, return written bytes (0 if the device would block), -1 on error */
+
+        /**
+         * @brief queue data to be written by the thread in receive() when the device is writable (never blocks either side).
+         * the data is queued whole or not at all (single producer thread).
+         * @return false if the queue has no room (dropped)
+         */
+        bool enqueue(const char* data, const unsigned int len);
+        int read(char* buffer, unsigned int max_size, const unsigned int timeout_ms=0); /* copy received bytes, wait up to timeout_ms if nothing is received yet */
+        void flush(); /* discard unread/unwritten data (device & ring buffer) */
+        int available();// Return the number of bytes in the received buffer
+
+        /**
+         * @brief wait until the device is readable (up to timeout_ms, -1 : infinite) and move received bytes into the ring buffer
+         * @return received bytes, 0 on timeout or interrupt, -1 on error (device closed or disconnected)
+         */
+        int receive(int timeout_ms);
+
+        /* wake up a thread waiting in receive() */
+        void interrupt();
+
+        /**
+         * @brief extract the next complete line (without CR/LF).
+         * the view is valid until the next extraction call
+         */
+        bool next_line(std::string_view& line);
+
+        /**
+         * @brief extract the next frame with an extractor : long(std::string_view data)
+         * which returns the frame length at the head of data (>0), 0 if incomplete, or -n to skip n bytes (garbage).
+         * the view is valid until the next extraction call
+         */
+        template<class Extractor>
+        bool next_frame(std::string_view& frame, Extractor&& extract){
+            _release();
+            while(true){
+                std::string_view data = _rx.peek();
+                if(data.empty())
+                    return false;
+                long n = extract(data);
+                if(n>0){
+                    frame = data.substr(0, (size_t)n);
+                    _pending_consume = (size_t)n;
+                    return true;
+                }
+                if(n==0){
+                    if(data.size()==_rx.capacity()) /* no frame fits : drop */
+                        _drop(data.size());
+                    return false;
+                }
+                _rx.consume((size_t)(-n));
+            }
+        }
+
+        /* bytes dropped because the ring buffer was full of unframed data */
+        uint64_t get_dropped_bytes() const { return _n_dropped.load(std::memory_order_relaxed); }
+
+        /* write queue statistics */
+        uint64_t get_tx_bytes() const { return _n_tx_bytes.load(std::memory_order_relaxed); }
+        uint64_t get_tx_dropped() const { return _n_tx_dropped.load(std::memory_order_relaxed); }
+        size_t get_tx_pending() const { return _tx.size(); }
+
+    protected:
+        void _release(); /* consume the previously extracted line/frame */
+        void _drop(size_t n);
+        int _write_queued(); /* write queued data (receive thread), -1 on error */
+        void _watch_writable(bool enable);
+
+    protected:
+        int _fd { -1 };
+        int _epoll_fd { -1 };
+        int _event_fd { -1 };
+        ring_buffer _rx;
+        size_t _pending_consume {0};
+        std::atomic<uint64_t> _n_dropped {0};
+        ring_buffer _tx;
+        bool _writable_watched {false};
+        std::atomic<uint64_t> _n_tx_bytes {0};
+        std::atomic<uint64_t> _n_tx_dropped {0};
+    }; //class
+
+} // namespace 
+
+#endif // serial
@@ -21,12 +21,54 @@ bool synerex_rtk_receiver::onInit(){
         json parameters = get_profile()->parameters();
 
         string port = parameters.value("port", "/dev/ttyS0");
-        unsigned int baudrate = parameters.value("baudrate", 115200);
-        // char err = _serial.openDevice(port.c_str(), baudrate);
-        // if(err!=1)
-        //     return false;
+        unsigned int baudrate = parameters.value("baudrate", 115200); // standard rates up to 4000000, other rates with termios2
+        flame::device::bus::SerialOptions serial_options;
+        serial_options.low_latency = parameters.value("low_latency", false);
+        serial_options.vmin = parameters.value("vmin", 0);
+        serial_options.vtime = parameters.value("vtime", 0);
+        _require_checksum = parameters.value("require_checksum", true);
+        if(!_bus.open(port.c_str(), baudrate, flame::device::bus::DataBits::DATABITS_8, flame::device::bus::ParityBits::NONE,
+                        flame::device::bus::StopBits::STOPBITS_1, serial_options)){
+            logger::error("[{}] Cannot open the serial port {} ({})", get_name(), port, baudrate);
+            return false;
+        }
+        logger::info("[{}] Serial port {} is opened ({})", get_name(), port, baudrate);
 
-        
+        /* RTCM corrections (optional) */
+        json correction = parameters.value("correction", json::object());
+        if(correction.value("enable", false)){
+            correction_source::config conf;
+            conf.source = correction.value("source", conf.source);
+            conf.host = correction.value("host", conf.host);
+            conf.port = correction.value("port", conf.port);
+            conf.mountpoint = correction.value("mountpoint", conf.mountpoint);
+            conf.user = correction.value("user", conf.user);
+            conf.password = correction.value("password", conf.password);
+            conf.gga_interval_s = correction.value("gga_interval_s", conf.gga_interval_s);
+            conf.reconnect_s = correction.value("reconnect_s", conf.reconnect_s);
+            conf.connect_timeout_s = correction.value("connect_timeout_s", conf.connect_timeout_s);
+            conf.data_timeout_s = correction.value("data_timeout_s", conf.data_timeout_s);
+            conf.path = correction.value("path", conf.path);
+            conf.rate_bytes_per_s = correction.value("rate_bytes_per_s", conf.rate_bytes_per_s);
+            conf.loop = correction.value("loop", conf.loop);
+
+            _correction = make_unique<correction_source>(conf, [this](string_view frame){
+                uint64_t expected = 0;
+                uint64_t now_ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+                _correction_first_ns.compare_exchange_strong(expected, now_ns);
+                _bus.enqueue(frame.data(), (unsigned int)frame.size());
+            });
+            _correction->start();
+            logger::info("[{}] RTCM correction input : {}", get_name(), conf.source=="file" ? conf.path : fmt::format("{}:{}/{}", conf.host, conf.port, conf.mountpoint));
+        }
+
+        /* optional raw sentence port (looked up here, not for every sentence) */
+        if(get_profile()->dataport().contains("nmea_stream"))
+            _nmea_port = get_port("nmea_stream");
+
+        _fix_buffer.resize(nmea::fast::epoch_assembler::max_message_size());
+        _fix_topic = fmt::format("{}/gnss_fix", get_name());
+        _receive_worker = thread(&synerex_rtk_receiver::_receive_task, this);
 
     }
     catch(json::exception& e){
@@ -39,11 +81,27 @@ bool synerex_rtk_receiver::onInit(){
 
 void synerex_rtk_receiver::onLoop(){
 
+    /* epochs are published by the receive worker as soon as they complete, this only reports status */
+    _publish_status();
 }
 
 
 void synerex_rtk_receiver::onClose(){
 
+    /* stop the correction input first (it queues into the serial port) */
+    if(_correction)
+        _correction->stop();
+
+    /* stop receive worker (wake up from waiting) */
+    _worker_stop.store(true);
+    _bus.interrupt();
+    if(_receive_worker.joinable()){
+        _receive_worker.join();
+        logger::info("- Serial receiver is now stopped ({} sentences, {} framing errors, {} checksum errors)",
+                    _n_sentences.load(), _n_framing_errors.load(), _n_checksum_errors.load());
+    }
+
+    _correction.reset();
     _bus.close();
 
 }
@@ -52,5 +110,165 @@ void synerex_rtk_receiver::onData(flame::component::ZData& data){
     
 }
 
+void synerex_rtk_receiver::_receive_task(){
+
+    string topic = fmt::format("{}/nmea_stream", get_name());
+
+    try{
+        while(!_worker_stop.load()){
+            /* wait on the device (no polling), then take every complete line */
+            int received = _bus.receive(100);
+            if(received<0){
+                logger::error("[{}] Serial port receive error", get_name());
+                break;
+            }
+
+            /* host receive time of the bytes just read (lines completed by this read) */
+            uint64_t rx_time_ns = (received>0) ? (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count() : 0;
+
+            string_view line;
+            while(_bus.next_line(line)){
+                /* validate in place (no allocation), drop broken sentences */
+                nmea::fast::parse_result result = nmea::fast::parse(line, _sentence, _require_checksum);
+                if(result!=nmea::fast::parse_result::OK){
+                    if(result==nmea::fast::parse_result::CHECKSUM)
+                        _n_checksum_errors.fetch_add(1, memory_order_relaxed);
+                    else if(!line.empty())
+                        _n_framing_errors.fetch_add(1, memory_order_relaxed);
+                    continue;
+                }
+                _n_sentences.fetch_add(1, memory_order_relaxed);
+
+                /* position for the caster (VRS) */
+                if(_correction && _sentence.type=="GGA")
+                    _correction->set_gga(line);
+
+                /* publish right away when the epoch completes */
+                if(_epoch.feed(_sentence, rx_time_ns))
+                    _publish_fix();
+
+                /* raw sentence pass-through (optional port) */
+                if(_nmea_port && _nmea_port->handle()!=nullptr){
+                    zmq::multipart_t msg_multipart_nmea;
+                    msg_multipart_nmea.addstr(topic);
+                    msg_multipart_nmea.addmem(line.data(), line.size());
+                    msg_multipart_nmea.send(*_nmea_port, ZMQ_DONTWAIT);
+                }
+            }
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] {}", get_name(), e.what());
+    }
+}
+
+void synerex_rtk_receiver::_publish_fix(){
 
+    const nmea::fast::gnss_fix& fix = _epoch.completed();
+    _n_epochs.fetch_add(1, memory_order_relaxed);
+    if(fix.flags & nmea::fast::FIX_TERMINATED)
+        _n_terminated.fetch_add(1, memory_order_relaxed);
 
+    if(get_port("gnss_fix")->handle()!=nullptr){
+        size_t size = _epoch.serialize(_fix_buffer.data(), _fix_buffer.size());
+        if(size>0){
+            zmq::multipart_t msg_multipart_fix;
+            msg_multipart_fix.addstr(_fix_topic);
+            msg_multipart_fix.addmem(_fix_buffer.data(), size);
+            msg_multipart_fix.send(*get_port("gnss_fix"), ZMQ_DONTWAIT);
+        }
+    }
+
+    /* RTK fixed availability and time to fix */
+    bool fixed = (fix.flags & nmea::fast::FIX_QUALITY) && fix.fix==4;
+    if(fixed){
+        _n_fixed.fetch_add(1, memory_order_relaxed);
+        uint64_t first_ns = _correction_first_ns.load();
+        if(!_fixed && _time_to_fix_s.load()<0.0 && first_ns>0 && fix.rx_last_ns>first_ns)
+            _time_to_fix_s.store((double)(fix.rx_last_ns-first_ns)*1e-9);
+        if(!_fixed && _fixed_lost_ns>0 && fix.rx_last_ns>_fixed_lost_ns)
+            _refix_s.store((double)(fix.rx_last_ns-_fixed_lost_ns)*1e-9);
+    }
+    else if(_fixed)
+        _fixed_lost_ns = fix.rx_last_ns;
+    _fixed = fixed;
+
+    /* latency from the last sentence of the epoch */
+    if(fix.rx_last_ns>0){
+        uint64_t now_ns = (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t latency = (now_ns>fix.rx_last_ns) ? now_ns-fix.rx_last_ns : 0;
+        _latency_sum_ns.fetch_add(latency, memory_order_relaxed);
+        _latency_count.fetch_add(1, memory_order_relaxed);
+        uint64_t max_ns = _latency_max_ns.load(memory_order_relaxed);
+        while(latency>max_ns && !_latency_max_ns.compare_exchange_weak(max_ns, latency, memory_order_relaxed));
+    }
+
+    lock_guard<mutex> lock(_fix_mutex);
+    _last_fix = fix;
+}
+
+void synerex_rtk_receiver::_publish_status(){
+
+    nmea::fast::gnss_fix fix;
+    {
+        lock_guard<mutex> lock(_fix_mutex);
+        fix = _last_fix;
+    }
+
+    uint64_t latency_count = _latency_count.exchange(0);
+    uint64_t latency_sum = _latency_sum_ns.exchange(0);
+    uint64_t latency_max = _latency_max_ns.exchange(0);
+
+    json status;
+    status["sentences"] = _n_sentences.load();
+    status["framing_errors"] = _n_framing_errors.load();
+    status["checksum_errors"] = _n_checksum_errors.load();
+    status["dropped_bytes"] = _bus.get_dropped_bytes();
+    status["epochs"] = _n_epochs.load();
+    status["epochs_terminated"] = _n_terminated.load();
+    status["publish_latency_us"] = {
+        {"mean", latency_count>0 ? (double)latency_sum/(double)latency_count*1e-3 : 0.0},
+        {"max", (double)latency_max*1e-3}
+    };
+    status["rtk"] = {
+        {"fixed_epochs", _n_fixed.load()},
+        {"time_to_fix_s", _time_to_fix_s.load()},
+        {"refix_s", _refix_s.load()}
+    };
+    status["correction"] = {
+        {"enable", _correction!=nullptr},
+        {"connected", _correction ? _correction->is_connected() : false},
+        {"frames", _correction ? _correction->get_frame_count() : 0},
+        {"crc_errors", _correction ? _correction->get_crc_error_count() : 0},
+        {"bytes", _correction ? _correction->get_byte_count() : 0},
+        {"reconnects", _correction ? _correction->get_reconnect_count() : 0},
+        {"tx_bytes", _bus.get_tx_bytes()},
+        {"tx_dropped", _bus.get_tx_dropped()},
+        {"tx_pending", _bus.get_tx_pending()}
+    };
+    status["fix"] = {
+        {"epoch", fix.epoch},
+        {"utc", fix.utc},
+        {"latitude", fix.latitude},
+        {"longitude", fix.longitude},
+        {"altitude", fix.altitude},
+        {"quality", fix.fix},
+        {"satellites", fix.satellites_used},
+        {"hdop", fix.hdop},
+        {"heading", fix.heading},
+        {"heading_source", (int)fix.source},
+        {"rx_time_ns", fix.rx_last_ns}
+    };
+
+    try{
+        if(get_port("status")->handle()!=nullptr){
+            zmq::multipart_t msg_multipart_status;
+            msg_multipart_status.addstr(fmt::format("{}/status", get_name()));
+            msg_multipart_status.addstr(status.dump());
+            msg_multipart_status.send(*get_port("status"), ZMQ_DONTWAIT);
+        }
+    }
+    catch(const zmq::error_t& e){
+        logger::error("[{}] Status publish error : {}", get_name(), e.what());
+    }
+}
@@ -19,7 +19,12 @@
 #include <thread>
 #include <string>
 #include <atomic>
+#include <mutex>
 #include "serial/serial.hpp"
+#include "nmea/fast/epoch.hpp"
+#include "rtcm/correction_source.hpp"
+#include <memory>
+#include <utility>
 
 using namespace std;
 
@@ -36,10 +41,51 @@ class synerex_rtk_receiver : public flame::component::object {
 
     private:
         /* serial */
-        device::bus::serial _bus;
+        flame::device::bus::serial _bus;
 
+        /* serial receive worker */
+        thread _receive_worker;
         atomic<bool> _worker_stop {false};
 
+        /* sentence validation */
+        bool _require_checksum {true};
+        nmea::fast::sentence_view _sentence; /* sliced sentence (receive worker only) */
+        atomic<uint64_t> _n_sentences {0};
+        atomic<uint64_t> _n_framing_errors {0};
+        atomic<uint64_t> _n_checksum_errors {0};
+
+        /* raw sentence pass-through, resolved once in onInit (null if the profile has no nmea_stream port) */
+        using port_handle = decltype(declval<flame::component::object&>().get_port(string()));
+        port_handle _nmea_port {};
+
+        /* epoch consolidation (receive worker only) */
+        nmea::fast::epoch_assembler _epoch;
+        vector<uint8_t> _fix_buffer; /* preallocated, max message size */
+        string _fix_topic;
+
+        /* publish statistics (status) */
+        mutex _fix_mutex;
+        nmea::fast::gnss_fix _last_fix; /* last published epoch */
+        atomic<uint64_t> _n_epochs {0};
+        atomic<uint64_t> _n_terminated {0}; /* epochs completed by their last sentence (not by the next UTC) */
+        atomic<uint64_t> _latency_sum_ns {0}; /* last sentence received -> published */
+        atomic<uint64_t> _latency_max_ns {0};
+        atomic<uint64_t> _latency_count {0};
+
+        /* RTCM correction injection (frames are queued to the serial port, written by the receive worker) */
+        unique_ptr<correction_source> _correction;
+        atomic<uint64_t> _correction_first_ns {0}; /* first injected frame (system clock) */
+        atomic<uint64_t> _n_fixed {0}; /* epochs with RTK fixed */
+        atomic<double> _time_to_fix_s {-1.0}; /* first injected frame -> first RTK fixed epoch */
+        atomic<double> _refix_s {-1.0}; /* last RTK fixed loss -> fixed again */
+        uint64_t _fixed_lost_ns {0}; /* receive worker only */
+        bool _fixed {false}; /* receive worker only */
+
+    private:
+        void _receive_task(); /* wait on the serial port, consolidate sentences & publish one fix per epoch */
+        void _publish_fix(); /* publish the completed epoch (binary gnss_fix + satellite table) */
+        void _publish_status(); /* publish receiver status (json) */
+
 
 }; /* class */
 